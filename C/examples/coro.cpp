@@ -0,0 +1,172 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+   C++20 coroutine example (SMQCo.h).
+
+   Runs many simulated devices on one thread. Each device is a
+   coroutine that connects, creates the topic /coro/status,
+   subscribes to /coro/cmd, answers each command by publishing to the
+   sender's ephemeral topic ID, and publishes a heartbeat to
+   /coro/status when idle. A controller coroutine publishes a command
+   every second and prints how many devices answered and how long the
+   last answer took.
+
+   Build and run:
+     make coro
+     ./coro 1000
+     ./coro 1000 http://127.0.0.1/smq.lsp
+ */
+
+#if 1
+#define SMQ_DOMAIN "simplemq.com"
+#else
+#define SMQ_DOMAIN "127.0.0.1"
+#endif
+#define SMQ_URL "http://" SMQ_DOMAIN "/smq.lsp"
+
+#include <SMQCo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+static const char* url = SMQ_URL;
+static U32 connected;
+
+
+static SMQTask<>
+device(SMQExecutor& exec, int n)
+{
+   U8 buf[256];
+   char uid[32];
+   SMQCo smq(exec, buf, sizeof(buf));
+   S64 status, cmd; /* Topic IDs */
+   int x;
+   snprintf(uid, sizeof(uid), "coro device %d", n);
+   if((x = co_await smq.connect(url, uid, strlen(uid))) != 0)
+   {
+      printf("Device %d: connect failed: %d\n", n, x);
+      co_return;
+   }
+   status = co_await smq.create("/coro/status");
+   cmd = co_await smq.subscribe("/coro/cmd");
+   if(status < 0 || cmd < 0)
+      co_return;
+   connected++;
+   smq.smq.timeout = 5000 + n % 1000; /* Spread the heartbeats */
+   for(;;)
+   {
+      SMQCo::Message m = co_await smq.nextMessage();
+      if(m.len == SMQ_TIMEOUT)
+         smq.publish(uid, strlen(uid), status, 0);
+      else if(m.len >= 0)
+      {
+         if(m.tid == (U32)cmd)
+            smq.publish(m.data, m.len, m.ptid, 0); /* Reply to sender */
+      }
+      else
+      {
+         printf("Device %d: %d\n", n, m.len);
+         break;
+      }
+   }
+   connected--;
+}
+
+
+static SMQTask<>
+controller(SMQExecutor& exec, U32 devices)
+{
+   U8 buf[256];
+   SMQCo smq(exec, buf, sizeof(buf));
+   int status;
+   S64 cmd; /* Topic ID */
+   U32 seq;
+   if((status = co_await smq.connect(url, "coro controller", 15)) != 0)
+   {
+      printf("Controller: connect failed: %d\n", status);
+      exec.stop();
+      co_return;
+   }
+   if((cmd = co_await smq.create("/coro/cmd")) < 0)
+      co_return;
+   while(connected < devices)
+      co_await exec.sleep(100);
+   smq.smq.timeout = 100;
+   for(seq = 1 ; ; seq++)
+   {
+      U64 start = SMQExecutor::now(), last = start;
+      U32 replies = 0;
+      smq.publish(&seq, sizeof(seq), cmd, 0);
+      while(SMQExecutor::now() - start < 1000)
+      {
+         SMQCo::Message m = co_await smq.nextMessage();
+         if(m.len == sizeof(seq) && !memcmp(m.data, &seq, sizeof(seq)))
+         {
+            replies++;
+            last = SMQExecutor::now();
+         }
+         else if(m.len < 0 && m.len != SMQ_TIMEOUT)
+         {
+            exec.stop();
+            co_return;
+         }
+      }
+      printf("Command %u: %u of %u devices replied in %u ms\n",
+             seq, replies, connected, (unsigned)(last - start));
+   }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+   SMQExecutor exec;
+   U32 i, devices = argc > 1 ? (U32)atoi(argv[1]) : 100;
+   if(argc > 2)
+      url = argv[2];
+   signal(SIGPIPE, SIG_IGN);
+   for(i = 0 ; i < devices ; i++)
+      exec.spawn(device(exec, (int)i));
+   exec.spawn(controller(exec, devices));
+   return exec.run();
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
@@ -0,0 +1,165 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+   SeCtx context switch benchmark (host).
+
+   Measures the cost of one block/resume cycle (SeCtx_save followed
+   by SeCtx_restore) for the stack copying implementation (SeCtx.c)
+   and the stack switching implementation (SeCtxSwitch.c) at
+   increasing stack depths between SeCtx_run and SeCtx_save. The
+   copying version's cost grows with the depth; the switching
+   version's cost does not.
+
+   Build and run:
+     make ctxbench
+     ./ctxbench-copy
+     ./ctxbench-switch
+
+   The copying version passes the SeCtx pointer through longjmp as an
+   int, so the benchmark is linked as a non PIE executable on 64 bit
+   hosts.
+ */
+
+#include <selib.h>
+#include <SeCtx.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CYCLES 200000
+
+static SeCtx ctx;
+static U8 stackBuf[60*1024]; /* SeCtx.c: max 64K */
+static int depth; /* Recursion levels of 256 bytes each */
+static BaBool finished;
+
+
+static void
+nest(SeCtx* c, int n)
+{
+   volatile U8 pad[256]; /* Stack to save or switch */
+   pad[0] = (U8)n;
+   if(n > 0)
+      nest(c, n-1);
+   else
+   {
+      U32 i;
+      for(i = 0 ; i < CYCLES ; i++)
+         SeCtx_save(c); /* Block, as se_recv does in a bare metal port */
+   }
+   (void)pad[0];
+}
+
+
+static void
+task(SeCtx* c)
+{
+   nest(c, depth);
+   finished = TRUE;
+}
+
+
+/* Same structure as SeCtx_run in the bare metal porting layers */
+static int
+run(SeCtx* c)
+{
+   auto U8 stackMark;
+   if(c->hasContext)
+   {
+      c->ready = TRUE; /* Simulate a TCP/IP event */
+      SeCtx_restore(c);
+   }
+#ifdef SECTX_SWITCH
+   else
+   {
+      (void)stackMark;
+      return SeCtx_start(c);
+   }
+#else
+   else if( ! SeCtx_setStackTop(c, &stackMark) )
+   {
+      c->task(c);
+      return -1;
+   }
+#endif
+   return 0;
+}
+
+
+int
+main(void)
+{
+   static const int depths[] = {0, 2, 8, 32};
+   /* Static: SeCtx.c's longjmp does not preserve the caller's registers */
+   static U32 i;
+   static struct timespec t0, t1;
+   printf("%s\n%10s %12s\n",
+#ifdef SECTX_SWITCH
+          "Stack switching (SeCtxSwitch.c)",
+#else
+          "Stack copying (SeCtx.c)",
+#endif
+          "stack", "ns/cycle");
+   for(i = 0 ; i < sizeof(depths) / sizeof(depths[0]) ; i++)
+   {
+      double ns;
+      depth = depths[i];
+      finished = FALSE;
+      SeCtx_constructor(&ctx, task, stackBuf, sizeof(stackBuf));
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      while( ! finished )
+         run(&ctx);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+      printf("%10d %12.1f\n", (depth + 1) * 256, ns / CYCLES);
+   }
+   return 0;
+}
+
+
+void
+SeCtx_panic(SeCtx* o, U32 size)
+{
+   (void)o;
+   printf("SeCtx buffer too small: %u\n", (unsigned)size);
+   exit(1);
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
@@ -0,0 +1,232 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+   Large object transfer example (SMQLob).
+
+   Sends a file of any size to all receivers subscribed to the topic
+   /lob/demo, or receives such a file. The sender reads the file one
+   chunk at a time; the receiver writes each chunk to the output
+   file. When the connection is lost, the sender reconnects and the
+   transfer resumes from the last offset stored by the receiver.
+
+   Start the receiver(s) first:
+     ./lob recv out.bin
+     ./lob send firmware.bin
+ */
+
+#if 1
+#define SMQ_DOMAIN "simplemq.com"
+#else
+#define SMQ_DOMAIN "127.0.0.1"
+#endif
+#define SMQ_URL "http://" SMQ_DOMAIN "/smq.lsp"
+
+#include <SMQLob.h>
+#include <stdio.h>
+
+#define OBJ_ID 1 /* Object ID: a real application could use a file hash */
+
+
+static int
+fileRead(void* ctx, U32 offset, U8* buf, int len)
+{
+   FILE* fp = (FILE*)ctx;
+   if(fseek(fp, (long)offset, SEEK_SET))
+      return -1;
+   len = (int)fread(buf, 1, len, fp);
+   return ferror(fp) ? -1 : len;
+}
+
+
+static int
+fileWrite(void* ctx, U32 offset, const U8* data, int len)
+{
+   FILE* fp = (FILE*)ctx;
+   if(fseek(fp, (long)offset, SEEK_SET) ||
+      fwrite(data, 1, len, fp) != (size_t)len)
+   {
+      return -1;
+   }
+   return 0;
+}
+
+
+/* Connect and resolve the topic and the sub-topic used for transfers.
+ */
+static int
+connectBroker(SMQ* smq, BaBool sender, U32* tid, U32* lobSubtid)
+{
+   U8* msg;
+   const char* uid = sender ? "LOB sender" : "LOB receiver";
+   if(SMQ_init(smq, SMQ_URL, 0) < 0 ||
+      SMQ_connect(smq, uid, strlen(uid), 0, 0, 0, 0))
+   {
+      printf("Cannot connect, status: %d\n", smq->status);
+      return -1;
+   }
+   if(sender)
+      SMQ_create(smq, "/lob/demo");
+   else
+      SMQ_subscribe(smq, "/lob/demo");
+   SMQ_createsub(smq, "lob");
+   if(SMQ_getMessage(smq, &msg) != (sender ? SMQ_CREATEACK : SMQ_SUBACK))
+      return -1;
+   *tid = smq->ptid;
+   if(SMQ_getMessage(smq, &msg) != SMQ_CREATESUBACK)
+      return -1;
+   *lobSubtid = smq->ptid;
+   return 0;
+}
+
+
+static int
+sendFile(const char* name)
+{
+   SMQ smq;
+   SMQLobSender lob;
+   U8 smqBuf[1024];
+   static U8 chunk[8*1024];
+   U32 tid, lobSubtid;
+   FILE* fp = fopen(name, "rb");
+   if(!fp)
+   {
+      printf("Cannot open %s\n", name);
+      return 1;
+   }
+   SMQ_constructor(&smq, smqBuf, sizeof(smqBuf));
+   SMQLobSender_constructor(&lob, &smq, chunk, sizeof(chunk), fileRead, fp);
+   for(;;) /* Reconnect loop */
+   {
+      int x;
+      if(connectBroker(&smq, TRUE, &tid, &lobSubtid))
+         return 1;
+      /* Start, or resume after a reconnect */
+      x = SMQLobSender_start(&lob, OBJ_ID, tid, lobSubtid, 8*sizeof(chunk));
+      while(x == 0)
+      {
+         U8* msg;
+         int len = SMQ_getMessage(&smq, &msg);
+         if(len >= 0 && smq.subtid == lobSubtid)
+            x = SMQLobSender_onMsg(&lob, msg, len);
+         else if(len < 0 && len != SMQ_TIMEOUT)
+            x = len;
+      }
+      if(x == SMQ_LOB_DONE)
+      {
+         printf("Sent %u bytes\n", lob.offset);
+         break;
+      }
+      printf("Transfer interrupted at offset %u: %d\n", lob.acked, x);
+      SMQ_destructor(&smq);
+      if(x == SMQE_LOB_ABORTED || x == SMQE_LOB_IO)
+         break;
+   }
+   SMQ_disconnect(&smq);
+   SMQ_destructor(&smq);
+   fclose(fp);
+   return 0;
+}
+
+
+static int
+recvFile(const char* name)
+{
+   SMQ smq;
+   SMQLobReceiver lob;
+   U8 smqBuf[1024];
+   U32 tid, lobSubtid;
+   FILE* fp = fopen(name, "wb");
+   if(!fp)
+   {
+      printf("Cannot open %s\n", name);
+      return 1;
+   }
+   SMQ_constructor(&smq, smqBuf, sizeof(smqBuf));
+   SMQLobReceiver_constructor(&lob, &smq, fileWrite, fp);
+   if(connectBroker(&smq, FALSE, &tid, &lobSubtid))
+      return 1;
+   for(;;)
+   {
+      U8* msg;
+      int len = SMQ_getMessage(&smq, &msg);
+      if(len >= 0 && smq.subtid == lobSubtid)
+      {
+         int x = SMQLobReceiver_onMsg(&lob, msg, len);
+         if(x == SMQ_LOB_DONE)
+         {
+            printf("Received %u bytes\n", lob.size);
+            break;
+         }
+         if(x < 0)
+         {
+            printf("Transfer failed: %d\n", x);
+            break;
+         }
+      }
+      else if(len < 0 && len != SMQ_TIMEOUT)
+      {
+         printf("Connection closed: %d\n", len);
+         break;
+      }
+   }
+   SMQ_disconnect(&smq);
+   SMQ_destructor(&smq);
+   fclose(fp);
+   return 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+#ifdef _WIN32
+   WSADATA wsaData;
+   WSAStartup(MAKEWORD(1,1), &wsaData);
+#endif
+   if(argc == 3 && !strcmp(argv[1], "send"))
+      return sendFile(argv[2]);
+   if(argc == 3 && !strcmp(argv[1], "recv"))
+      return recvFile(argv[2]);
+   printf("Usage: %s send|recv file\n", argv[0]);
+   return 1;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
@@ -0,0 +1,331 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+   SMQRpc latency and throughput benchmark.
+
+   A server process answers 'echo' calls and a client process keeps N
+   calls in flight, for increasing N, and prints the calls per second
+   and the latency percentiles. With N=1 the client waits for each
+   response before sending the next request, as a serial RPC does.
+
+   Build:
+     make rpcbench
+   Run against a broker (the server is started as a child process):
+     ./rpcbench http://127.0.0.1/smq.lsp
+   Run the server and the client on different hosts:
+     ./rpcbench -s http://broker/smq.lsp
+     ./rpcbench -c http://broker/smq.lsp
+ */
+
+#include <SMQRpc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define CALLS 50000 /* Calls per run */
+#define PAYLOAD 32 /* Argument size */
+#define MAX_INFLIGHT 256
+
+static const U32 inflight[] = {1, 4, 16, 64, 256};
+
+typedef struct
+{
+   SMQRpc* rpc;
+   U32 tid, subtid, tmo;
+   U32 calls; /* Calls to make in this run */
+   U32 issued, completed, errors;
+   double* lat; /* Latency of each call in microseconds */
+} Bench;
+
+typedef struct
+{
+   Bench* b;
+   double start;
+} Slot;
+
+static Slot slots[MAX_INFLIGHT];
+static U8 args[PAYLOAD];
+
+
+static double
+usTime(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static U32
+msTime(void)
+{
+   return (U32)(U64)(usTime() / 1000);
+}
+
+
+/* Wait for the response to create, createsub, or subscribe and set
+   'id' to the (sub)topic ID, which may use all 32 bits.
+   Returns 0 or -1 if denied or on a connection error.
+*/
+static int
+waitAck(SMQ* smq, int code, U32* id)
+{
+   for(;;)
+   {
+      U8* msg;
+      int x = SMQ_getMessage(smq, &msg);
+      if(x == code)
+      {
+         *id = smq->ptid;
+         return smq->status ? -1 : 0;
+      }
+      if(x < 0 && x != SMQ_TIMEOUT)
+         return -1;
+   }
+}
+
+
+static int
+connectBroker(SMQ* smq, U8* buf, U16 bufLen, const char* url,
+              const char* uid)
+{
+   SMQ_constructor(smq, buf, bufLen);
+   if(SMQ_init(smq, url, 0) || SMQ_connect(smq, uid, strlen(uid), 0,0,0,0))
+   {
+      printf("%s: cannot connect to %s\n", uid, url);
+      return -1;
+   }
+   return 0;
+}
+
+
+static void
+echo(void* ctx, SMQRpc* rpc, const SMQRpcReq* req, const U8* a, int len)
+{
+   (void)ctx;
+   SMQRpc_reply(rpc, req, a, len);
+}
+
+
+static int
+server(const char* url)
+{
+   static U8 buf[1024];
+   SMQRpcCall calls[1];
+   SMQ smq;
+   SMQRpc rpc;
+   U32 tid, subtid;
+   if(connectBroker(&smq, buf, sizeof(buf), url, "rpcbench server"))
+      return 1;
+   SMQ_subscribe(&smq, "/rpcbench");
+   if(waitAck(&smq, SMQ_SUBACK, &tid))
+      return 1;
+   SMQ_createsub(&smq, "echo");
+   if(waitAck(&smq, SMQ_CREATESUBACK, &subtid))
+      return 1;
+   SMQRpc_constructor(&rpc, &smq, calls, 1);
+   SMQRpc_setHandler(&rpc, echo, 0);
+   for(;;)
+   {
+      U8* msg;
+      int len = SMQ_getMessage(&smq, &msg);
+      if(len >= 0 && smq.subtid == subtid)
+         SMQRpc_onMsg(&rpc, msg, len);
+      else if(len < 0 && len != SMQ_TIMEOUT)
+         return 1;
+   }
+}
+
+
+static void issue(Bench* b, Slot* s);
+
+static void
+done(void* ctx, int status, const U8* data, int len)
+{
+   Slot* s = (Slot*)ctx;
+   Bench* b = s->b;
+   (void)data;
+   if(status || len != PAYLOAD)
+      b->errors++;
+   b->lat[b->completed++] = usTime() - s->start;
+   if(b->issued < b->calls)
+      issue(b, s);
+}
+
+
+static void
+issue(Bench* b, Slot* s)
+{
+   s->b = b;
+   s->start = usTime();
+   b->issued++;
+   if(SMQRpc_call(b->rpc, b->tid, b->subtid, args, PAYLOAD, msTime(), b->tmo,
+                  done, s))
+   {
+      b->errors++;
+      b->completed++;
+   }
+}
+
+
+/* Process responses until all calls of the run are completed.
+   Returns 0 or a connection error.
+*/
+static int
+pump(Bench* b, SMQ* smq)
+{
+   while(b->completed < b->calls)
+   {
+      U8* msg;
+      int len;
+      U32 tmo = SMQRpc_run(b->rpc, msTime());
+      /* Wake up for the keepalive PING, see SMQRpc_run */
+      smq->timeout = tmo < (U32)smq->pingTmo ? tmo : (U32)smq->pingTmo;
+      if(b->completed == b->calls)
+         break; /* The last call timed out */
+      len = SMQ_getMessage(smq, &msg);
+      if(len >= 0 && smq->subtid == b->subtid)
+         SMQRpc_onMsg(b->rpc, msg, len);
+      else if(len < 0 && len != SMQ_TIMEOUT)
+         return len;
+   }
+   return 0;
+}
+
+
+static int
+cmpDouble(const void* a, const void* b)
+{
+   double x = *(const double*)a, y = *(const double*)b;
+   return x < y ? -1 : x > y;
+}
+
+
+static int
+client(const char* url)
+{
+   static U8 buf[1024];
+   static SMQRpcCall calls[MAX_INFLIGHT];
+   SMQ smq;
+   SMQRpc rpc;
+   Bench b;
+   U32 tid, subtid;
+   int err;
+   U32 i, n;
+   if(connectBroker(&smq, buf, sizeof(buf), url, "rpcbench client"))
+      return 1;
+   SMQ_create(&smq, "/rpcbench");
+   if(waitAck(&smq, SMQ_CREATEACK, &tid))
+      return 1;
+   SMQ_createsub(&smq, "echo");
+   if(waitAck(&smq, SMQ_CREATESUBACK, &subtid))
+      return 1;
+   SMQRpc_constructor(&rpc, &smq, calls, MAX_INFLIGHT);
+   memset(&b, 0, sizeof(b));
+   b.rpc = &rpc;
+   b.tid = tid;
+   b.subtid = subtid;
+   b.lat = (double*)malloc(CALLS * sizeof(double));
+   /* Wait until the server has subscribed */
+   b.calls = 1;
+   b.tmo = 200;
+   do
+   {
+      b.issued = b.completed = b.errors = 0;
+      issue(&b, slots);
+      if(pump(&b, &smq))
+         return 1;
+   } while(b.errors);
+   b.calls = CALLS;
+   b.tmo = 5000;
+   printf("%8s %10s %10s %10s %10s\n",
+          "inflight", "calls/s", "p50 us", "p99 us", "max us");
+   for(i = 0 ; i < sizeof(inflight) / sizeof(inflight[0]) ; i++)
+   {
+      double t;
+      b.issued = b.completed = b.errors = 0;
+      t = usTime();
+      for(n = 0 ; n < inflight[i] ; n++)
+         issue(&b, slots + n);
+      if((err = pump(&b, &smq)) != 0)
+      {
+         printf("Connection error %d\n", err);
+         return 1;
+      }
+      t = usTime() - t;
+      qsort(b.lat, CALLS, sizeof(double), cmpDouble);
+      printf("%8u %10.0f %10.1f %10.1f %10.1f", inflight[i], CALLS / t * 1e6,
+             b.lat[CALLS / 2], b.lat[CALLS * 99 / 100], b.lat[CALLS - 1]);
+      if(b.errors)
+         printf("  (%u errors)", b.errors);
+      printf("\n");
+   }
+   SMQ_disconnect(&smq);
+   SMQ_destructor(&smq);
+   free(b.lat);
+   return 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+   const char* url = "http://127.0.0.1/smq.lsp";
+   pid_t child;
+   int ret;
+   signal(SIGPIPE, SIG_IGN);
+   memset(args, 'x', sizeof(args));
+   if(argc > 2 && !strcmp(argv[1], "-s"))
+      return server(argv[2]);
+   if(argc > 2 && !strcmp(argv[1], "-c"))
+      return client(argv[2]);
+   if(argc > 1)
+      url = argv[1];
+   if((child = fork()) == 0)
+      _exit(server(url));
+   ret = client(url);
+   kill(child, SIGTERM);
+   waitpid(child, 0, 0);
+   return ret;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
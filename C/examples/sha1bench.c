@@ -0,0 +1,230 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+   SHA-1 micro-benchmark.
+
+   Hashes messages of increasing size with each SHA-1 implementation
+   supported by this CPU and prints the throughput of the one message
+   at a time API (SharkSslSha1Ctx) and of se_sha1Multi with a batch of
+   messages. The 20 byte messages correspond to the salted password
+   hash calculated for each SMQ connect.
+
+   Before measuring, each implementation is checked against the FIPS
+   180-2 test vectors and against the portable C implementation for
+   all message lengths up to CHECK_MAX, with se_sha1Multi hashing the
+   messages in one batch. The program prints the failing
+   implementation and returns 1 if a digest differs.
+
+   Note that SE_SHA1_AUTO selects SHA-NI or the ARMv8 crypto extension
+   when the CPU has it, so se_sha1Multi uses the AVX2 multi-buffer
+   implementation only on x86-64 CPUs without SHA-NI, or when it is
+   selected with se_sha1Select(SE_SHA1_SIMD).
+
+   Build:
+     make sha1bench
+   Run:
+     ./sha1bench
+ */
+
+#include <selib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BYTES (64*1024*1024) /* Data hashed per size and mode */
+#define BATCH 64 /* Messages per se_sha1Multi call */
+#define CHECK_MAX 300 /* Lengths 0..CHECK_MAX are checked */
+
+static const U32 sizes[] = {20, 64, 256, 1024, 16384};
+static const char* names[] = {"scalar", "simd", "hw"};
+
+/* FIPS 180-2 test vectors */
+static const struct
+{
+   const char* msg;
+   const char* digest;
+} vectors[] = {
+   {"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+   {"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"},
+   {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    "84983e441c3bd26ebaae4aa1f95129e5e54670f1"}
+};
+
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void
+sha1(const U8* data, U32 len, U8* digest)
+{
+   SharkSslSha1Ctx ctx;
+   SharkSslSha1Ctx_constructor(&ctx);
+   SharkSslSha1Ctx_append(&ctx, data, len);
+   SharkSslSha1Ctx_finish(&ctx, digest);
+}
+
+
+static void
+toHex(const U8* digest, char* hex)
+{
+   int i;
+   for(i = 0 ; i < SHARKSSL_SHA1_HASH_LEN ; i++)
+      sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+
+/* Check the selected implementation 'impl' against the test vectors
+   and against 'ref', the portable C digests of buf[0..len) for len =
+   0..CHECK_MAX. Returns the number of wrong digests.
+*/
+static int
+check(int impl, const U8* buf, const U8* ref)
+{
+   static U8 digest[(CHECK_MAX + 1) * SHARKSSL_SHA1_HASH_LEN];
+   const U8* data[CHECK_MAX + 1];
+   U32 len[CHECK_MAX + 1];
+   char hex[2 * SHARKSSL_SHA1_HASH_LEN + 1];
+   int errors = 0;
+   U32 i, n = sizeof(vectors) / sizeof(vectors[0]);
+   for(i = 0 ; i < n ; i++)
+   {
+      data[i] = (const U8*)vectors[i].msg;
+      len[i] = (U32)strlen(vectors[i].msg);
+      sha1(data[i], len[i], digest);
+      toHex(digest, hex);
+      if(strcmp(hex, vectors[i].digest))
+         errors++;
+   }
+   se_sha1Multi(data, len, digest, n);
+   for(i = 0 ; i < n ; i++)
+   {
+      toHex(digest + i * SHARKSSL_SHA1_HASH_LEN, hex);
+      if(strcmp(hex, vectors[i].digest))
+         errors++;
+   }
+   for(i = 0 ; i <= CHECK_MAX ; i++)
+   {
+      data[i] = buf;
+      len[i] = i;
+      sha1(buf, i, digest);
+      if(memcmp(digest, ref + i * SHARKSSL_SHA1_HASH_LEN,
+                SHARKSSL_SHA1_HASH_LEN))
+      {
+         errors++;
+      }
+   }
+   se_sha1Multi(data, len, digest, CHECK_MAX + 1);
+   if(memcmp(digest, ref, sizeof(digest)))
+      errors++;
+   if(errors)
+      printf("%8s FAILED: %d wrong digests\n", names[impl], errors);
+   return errors;
+}
+
+
+int
+main(void)
+{
+   static U8 digest[BATCH * SHARKSSL_SHA1_HASH_LEN];
+   static U8 ref[(CHECK_MAX + 1) * SHARKSSL_SHA1_HASH_LEN];
+   const U8* data[BATCH];
+   U32 len[BATCH];
+   U8* buf;
+   int impl, failed = 0;
+   U32 i, j;
+   buf = (U8*)malloc(BATCH * sizes[sizeof(sizes) / sizeof(sizes[0]) - 1]);
+   for(i = 0 ; i < BATCH * sizes[sizeof(sizes) / sizeof(sizes[0]) - 1] ; i++)
+      buf[i] = (U8)i;
+   se_sha1Select(SE_SHA1_SCALAR);
+   for(i = 0 ; i <= CHECK_MAX ; i++)
+      sha1(buf, i, ref + i * SHARKSSL_SHA1_HASH_LEN);
+   for(impl = SE_SHA1_SCALAR ; impl <= SE_SHA1_HW ; impl++)
+   {
+      if(se_sha1Select(impl) >= 0 && check(impl, buf, ref))
+         failed = 1;
+   }
+   if(failed)
+   {
+      free(buf);
+      return 1;
+   }
+   printf("%8s %8s %14s %14s %12s\n",
+          "impl", "size", "single MB/s", "multi MB/s", "single/s");
+   for(impl = SE_SHA1_SCALAR ; impl <= SE_SHA1_HW ; impl++)
+   {
+      if(se_sha1Select(impl) < 0)
+      {
+         printf("%8s %8s\n", names[impl], "n/a");
+         continue;
+      }
+      for(i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+      {
+         U32 count = BENCH_BYTES / sizes[i];
+         double t, single, multi;
+         for(j = 0 ; j < BATCH ; j++)
+         {
+            data[j] = buf + j * sizes[i];
+            len[j] = sizes[i];
+         }
+         t = now();
+         for(j = 0 ; j < count ; j++)
+            sha1(data[j % BATCH], sizes[i], digest);
+         single = now() - t;
+         t = now();
+         for(j = 0 ; j < count ; j += BATCH)
+            se_sha1Multi(data, len, digest, BATCH);
+         multi = now() - t;
+         printf("%8s %8u %14.1f %14.1f %12.0f\n", names[impl], sizes[i],
+                BENCH_BYTES / single / (1024 * 1024),
+                BENCH_BYTES / multi / (1024 * 1024), count / single);
+      }
+   }
+   free(buf);
+   return 0;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
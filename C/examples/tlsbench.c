@@ -0,0 +1,297 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+   TLS handshake rate benchmark (make TLS=1 tlsbench).
+
+   Connects to a local TLS broker stand-in, performs the SMQ init and
+   connect handshake, and disconnects, repeatedly. Each run is made
+   with the session cache disabled (a full TLS handshake per
+   connection) and enabled (the session is resumed), with TLS 1.2 and
+   TLS 1.3, and prints the connections per second.
+
+   The broker stand-in is a child process using a self-signed P-256
+   certificate, which the client trusts via se_tlsInit. It answers
+   the SMQ HTTP request with the Init message and the Connect message
+   with Connack, and nothing else.
+
+   Build:
+     make TLS=1 tlsbench
+   Run:
+     ./tlsbench [connections]
+ */
+
+#include <SMQ.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <openssl/pem.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#ifndef SE_TLS
+#error Compile with -DSE_TLS (make TLS=1)
+#endif
+
+#define PORT 9443
+#define URL "https://127.0.0.1:9443/smq.lsp"
+
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* Create a self-signed certificate for 127.0.0.1 and localhost */
+static int
+makeCert(EVP_PKEY** key, X509** cert)
+{
+   EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, 0);
+   X509_EXTENSION* ext;
+   X509V3_CTX v3;
+   X509_NAME* name;
+   *key = 0;
+   if(!kctx || EVP_PKEY_keygen_init(kctx) <= 0 ||
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1)<=0 ||
+      EVP_PKEY_keygen(kctx, key) <= 0)
+   {
+      EVP_PKEY_CTX_free(kctx);
+      return -1;
+   }
+   EVP_PKEY_CTX_free(kctx);
+   *cert = X509_new();
+   X509_set_version(*cert, 2);
+   ASN1_INTEGER_set(X509_get_serialNumber(*cert), 1);
+   X509_gmtime_adj(X509_getm_notBefore(*cert), -3600);
+   X509_gmtime_adj(X509_getm_notAfter(*cert), 86400);
+   X509_set_pubkey(*cert, *key);
+   name = X509_get_subject_name(*cert);
+   X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                              (const U8*)"localhost", -1, -1, 0);
+   X509_set_issuer_name(*cert, name);
+   X509V3_set_ctx(&v3, *cert, *cert, 0, 0, 0);
+   ext = X509V3_EXT_conf_nid(0, &v3, NID_subject_alt_name,
+                             "IP:127.0.0.1,DNS:localhost");
+   X509_add_ext(*cert, ext, -1);
+   X509_EXTENSION_free(ext);
+   ext = X509V3_EXT_conf_nid(0, &v3, NID_basic_constraints, "CA:TRUE");
+   X509_add_ext(*cert, ext, -1);
+   X509_EXTENSION_free(ext);
+   return X509_sign(*cert, *key, EVP_sha256()) > 0 ? 0 : -1;
+}
+
+
+static int
+readAll(SSL* ssl, U8* buf, int len)
+{
+   int n = 0;
+   while(n < len)
+   {
+      int x = SSL_read(ssl, buf + n, len - n);
+      if(x <= 0)
+         return -1;
+      n += x;
+   }
+   return 0;
+}
+
+
+/* Answer the SMQ init and connect handshake, then wait for the
+   client to disconnect.
+*/
+static void
+session(SSL* ssl)
+{
+   static const U8 init[] = {
+      0, 17, 1, 1, 0x12, 0x34, 0x56, 0x78,
+      '1', '2', '7', '.', '0', '.', '0', '.', '1'
+   };
+   static const U8 connack[] = {0, 8, 3, 0, 0, 0, 0, 1};
+   U8 buf[1024];
+   int n = 0;
+   while(n < 4 || memcmp(buf + n - 4, "\r\n\r\n", 4))
+   {
+      if(n == sizeof(buf) || SSL_read(ssl, buf + n, 1) != 1)
+         return;
+      n++;
+   }
+   if(SSL_write(ssl, init, sizeof(init)) <= 0 || readAll(ssl, buf, 2))
+      return;
+   n = (buf[0] << 8) | buf[1];
+   if(n < 3 || n > (int)sizeof(buf) || readAll(ssl, buf + 2, n - 2) ||
+      SSL_write(ssl, connack, sizeof(connack)) <= 0)
+   {
+      return;
+   }
+   while(SSL_read(ssl, buf, sizeof(buf)) > 0) ;
+}
+
+
+static void
+broker(int lsock, EVP_PKEY* key, X509* cert, int maxVersion)
+{
+   SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+   int one = 1;
+   SSL_CTX_use_certificate(ctx, cert);
+   SSL_CTX_use_PrivateKey(ctx, key);
+   SSL_CTX_set_max_proto_version(ctx, maxVersion);
+   for(;;)
+   {
+      SSL* ssl;
+      int s = accept(lsock, 0, 0);
+      if(s < 0)
+         continue;
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      ssl = SSL_new(ctx);
+      SSL_set_fd(ssl, s);
+      if(SSL_accept(ssl) == 1)
+      {
+         session(ssl);
+         SSL_shutdown(ssl);
+      }
+      ERR_clear_error();
+      SSL_free(ssl);
+      close(s);
+   }
+}
+
+
+static int
+run(int count, BaBool cache, double* rate, U32* resumed, U32* ktls)
+{
+   static U8 buf[256];
+   SeTlsStats stats = se_tlsStats;
+   SMQ smq;
+   double t;
+   int i;
+   se_tlsSessionCache(cache);
+   t = now();
+   for(i = 0 ; i < count ; i++)
+   {
+      SMQ_constructor(&smq, buf, sizeof(buf));
+      if(SMQ_init(&smq, URL, 0) || SMQ_connect(&smq, "bench", 5, 0,0,0,0))
+      {
+         printf("Connection %d failed: %d\n", i, smq.status);
+         SMQ_destructor(&smq);
+         return -1;
+      }
+      SMQ_disconnect(&smq);
+      SMQ_destructor(&smq);
+   }
+   t = now() - t;
+   *rate = count / t;
+   *resumed = se_tlsStats.resumed - stats.resumed;
+   *ktls = se_tlsStats.ktlsSend - stats.ktlsSend;
+   return 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+   static const struct { int version; const char* name; } versions[] = {
+      {TLS1_2_VERSION, "TLS 1.2"}, {TLS1_3_VERSION, "TLS 1.3"}
+   };
+   char caFile[] = "/tmp/tlsbenchXXXXXX";
+   int count = argc > 1 ? atoi(argv[1]) : 2000;
+   EVP_PKEY* key;
+   X509* cert;
+   FILE* fp;
+   int fd, v, ret = 0;
+   signal(SIGPIPE, SIG_IGN);
+   if(makeCert(&key, &cert) || (fd = mkstemp(caFile)) < 0)
+   {
+      printf("Cannot create the certificate\n");
+      return 1;
+   }
+   fp = fdopen(fd, "w");
+   PEM_write_X509(fp, cert);
+   fclose(fp);
+   if(se_tlsInit(caFile, TRUE))
+   {
+      printf("Cannot load %s\n", caFile);
+      return 1;
+   }
+   printf("%8s %10s %12s %10s %8s\n",
+          "version", "session", "connects/s", "resumed", "ktls");
+   for(v = 0 ; v < 2 && !ret ; v++)
+   {
+      SOCKET lsock;
+      pid_t child;
+      int c;
+      if(se_bind(&lsock, PORT))
+      {
+         printf("Cannot bind port %d\n", PORT);
+         ret = 1;
+         break;
+      }
+      if((child = fork()) == 0)
+      {
+         broker(lsock, key, cert, versions[v].version);
+         _exit(0);
+      }
+      se_close(&lsock);
+      for(c = 0 ; c < 2 ; c++)
+      {
+         double rate;
+         U32 resumed, ktls;
+         if(run(count, (BaBool)c, &rate, &resumed, &ktls))
+         {
+            ret = 1;
+            break;
+         }
+         printf("%8s %10s %12.0f %10u %8u\n", versions[v].name,
+                c ? "resumed" : "full", rate, resumed, ktls);
+      }
+      kill(child, SIGTERM);
+      waitpid(child, 0, 0);
+   }
+   unlink(caFile);
+   se_tlsClose();
+   return ret;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
@@ -0,0 +1,321 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+   AF_UNIX versus TCP loopback benchmark.
+
+   Connects to a local broker stand-in with http://127.0.0.1 and with
+   a unix: URL and prints, for small publishes:
+     * the round trip time for a message published to a topic the
+       stand-in echoes back (publish + SMQ_getMessage),
+     * the publish rate when streaming messages to a topic the
+       stand-in discards.
+
+   The stand-in answers the SMQ handshake, echoes publish frames
+   sent to ECHO_TID, and drops all other frames. The client prints
+   the stand-in's process ID and user ID as returned by se_peerCred.
+
+   Build:
+     make unixbench
+   Run:
+     ./unixbench
+ */
+
+#include <SMQ.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+#ifndef SE_UNIX
+#error The porting layer does not support AF_UNIX sockets
+#endif
+
+#define PORT 9600
+#define SOCK_PATH "/tmp/unixbench.sock"
+
+#define MSG_PUBLISH 8 /* See SMQClient.c */
+#define ECHO_TID 1
+#define SINK_TID 2
+
+#define ROUND_TRIPS 20000
+#define PUBLISHES 200000
+
+static const U32 sizes[] = {16, 128, 1024};
+
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static int
+readAll(int s, U8* buf, int len)
+{
+   int n = 0;
+   while(n < len)
+   {
+      int x = (int)recv(s, buf + n, len - n, 0);
+      if(x <= 0)
+         return -1;
+      n += x;
+   }
+   return 0;
+}
+
+
+/* Answer the SMQ init and connect handshake, then echo or drop the
+   received frames until the client disconnects.
+*/
+static void
+session(int s)
+{
+   static const U8 init[] = {
+      0, 17, 1, 1, 0x12, 0x34, 0x56, 0x78,
+      '1', '2', '7', '.', '0', '.', '0', '.', '1'
+   };
+   static const U8 connack[] = {0, 8, 3, 0, 0, 0, 0, 3};
+   static U8 buf[64*1024];
+   int n = 0;
+   while(n < 4 || memcmp(buf + n - 4, "\r\n\r\n", 4))
+   {
+      if(n == sizeof(buf) || recv(s, buf + n, 1, 0) != 1)
+         return;
+      n++;
+   }
+   if(send(s, init, sizeof(init), 0) < 0 || readAll(s, buf, 2))
+      return;
+   n = (buf[0] << 8) | buf[1];
+   if(n < 3 || readAll(s, buf + 2, n - 2) ||
+      send(s, connack, sizeof(connack), 0) < 0)
+   {
+      return;
+   }
+   n = 0;
+   for(;;)
+   {
+      int x, off = 0;
+      if((x = (int)recv(s, buf + n, sizeof(buf) - n, 0)) <= 0)
+         return;
+      n += x;
+      while(n - off >= 2)
+      {
+         int len = (buf[off] << 8) | buf[off + 1];
+         U8* f = buf + off;
+         if(len < 3)
+            return;
+         if(len > n - off)
+            break;
+         if(f[2] == MSG_PUBLISH && len >= 15 && !f[3] && !f[4] && !f[5] &&
+            f[6] == ECHO_TID && send(s, f, len, 0) < 0)
+         {
+            return;
+         }
+         off += len;
+      }
+      memmove(buf, buf + off, n - off);
+      n -= off;
+   }
+}
+
+
+static void
+broker(int tcpSock, int unixSock)
+{
+   for(;;)
+   {
+      SOCKET s;
+      SOCKET* sp = &s;
+      SOCKET* lp = &tcpSock;
+      struct pollfd pfd[2];
+      int one = 1;
+      pfd[0].fd = tcpSock;
+      pfd[1].fd = unixSock;
+      pfd[0].events = pfd[1].events = POLLIN;
+      if(poll(pfd, 2, -1) <= 0)
+         continue;
+      if(pfd[1].revents)
+         lp = &unixSock;
+      if(se_accept(&lp, INFINITE_TMO, &sp) != 1)
+         continue;
+      if(lp == &tcpSock)
+         setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      if(fork() == 0)
+      {
+         session(s);
+         _exit(0);
+      }
+      close(s);
+   }
+}
+
+
+static int
+cmpDouble(const void* a, const void* b)
+{
+   double x = *(const double*)a, y = *(const double*)b;
+   return x < y ? -1 : x > y;
+}
+
+
+/* Measure round trips and the publish rate for one transport */
+static int
+run(const char* url, U32 size, double* p50, double* p99, double* rate)
+{
+   static U8 buf[2048];
+   static double lat[ROUND_TRIPS];
+   U8 data[1024];
+   SMQ smq;
+   SMQ_constructor(&smq, buf, sizeof(buf));
+   memset(data, 'x', size);
+   if(SMQ_init(&smq, url, 0) || SMQ_connect(&smq, "unixbench", 9, 0, 0, 0, 0))
+   {
+      SMQ_destructor(&smq);
+      return -1;
+   }
+   smq.timeout = 5000;
+   {
+      U32 i;
+      double t;
+      for(i = 0 ; i < ROUND_TRIPS ; i++)
+      {
+         U8* msg;
+         t = now();
+         if(SMQ_publish(&smq, data, (int)size, ECHO_TID, 0) ||
+            SMQ_getMessage(&smq, &msg) != (int)size)
+         {
+            SMQ_destructor(&smq);
+            return -1;
+         }
+         lat[i] = (now() - t) * 1e6;
+      }
+      qsort(lat, ROUND_TRIPS, sizeof(double), cmpDouble);
+      *p50 = lat[ROUND_TRIPS / 2];
+      *p99 = lat[ROUND_TRIPS * 99 / 100];
+      /* Stream to the sink, then wait for an echo: the stand-in has
+         then processed all messages.
+      */
+      t = now();
+      for(i = 0 ; i < PUBLISHES ; i++)
+      {
+         if(SMQ_publish(&smq, data, (int)size, SINK_TID, 0))
+            break;
+      }
+      if(i == PUBLISHES)
+      {
+         U8* msg;
+         if(SMQ_publish(&smq, data, (int)size, ECHO_TID, 0) ||
+            SMQ_getMessage(&smq, &msg) != (int)size)
+         {
+            i = 0;
+         }
+      }
+      *rate = PUBLISHES / (now() - t);
+      if(i != PUBLISHES)
+      {
+         SMQ_destructor(&smq);
+         return -1;
+      }
+   }
+   SMQ_disconnect(&smq);
+   SMQ_destructor(&smq);
+   return 0;
+}
+
+
+int
+main()
+{
+   static const char* const urls[] = {
+      "http://127.0.0.1:9600/smq.lsp",
+      "unix:" SOCK_PATH ":/smq.lsp"
+   };
+   SOCKET tcpSock, unixSock;
+   SePeerCred cred;
+   SMQ smq;
+   U8 buf[256];
+   pid_t child;
+   U32 i, j;
+   signal(SIGPIPE, SIG_IGN);
+   if(se_bind(&tcpSock, PORT) || se_bindUnix(&unixSock, SOCK_PATH))
+   {
+      printf("Cannot listen on port %d or %s\n", PORT, SOCK_PATH);
+      return 1;
+   }
+   if((child = fork()) == 0)
+   {
+      broker(tcpSock, unixSock);
+      _exit(0);
+   }
+   se_close(&tcpSock);
+   se_close(&unixSock);
+   SMQ_constructor(&smq, buf, sizeof(buf));
+   if(!SMQ_init(&smq, urls[1], 0) && !se_peerCred(&smq.sock, &cred))
+      printf("Broker stand-in: pid %d, uid %d\n",(int)cred.pid,(int)cred.uid);
+   SMQ_destructor(&smq);
+   printf("%10s %6s %10s %10s %12s\n",
+          "transport", "size", "p50 us", "p99 us", "publishes/s");
+   for(i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+   {
+      for(j = 0 ; j < 2 ; j++)
+      {
+         double p50, p99, rate;
+         if(run(urls[j], sizes[i], &p50, &p99, &rate))
+         {
+            printf("%s failed\n", urls[j]);
+            break;
+         }
+         printf("%10s %6u %10.1f %10.1f %12.0f\n", j ? "unix" : "tcp",
+                sizes[i], p50, p99, rate);
+      }
+   }
+   kill(child, SIGTERM);
+   waitpid(child, 0, 0);
+   unlink(SOCK_PATH);
+   return 0;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
@@ -0,0 +1,214 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+   MSG_ZEROCOPY benchmark (Linux).
+
+   Publishes messages of increasing size with SMQ_publish, first with
+   the normal copy path and then with the zero copy path, and prints
+   throughput and sender CPU time per message. The crossover is the
+   smallest size where the zero copy path uses less CPU without
+   losing throughput; set SE_ZEROCOPY_THRESHOLD or se_zcThreshold to
+   that value.
+
+   The receiver is a sink that discards all data; the SMQ handshake is
+   skipped since only the send path is measured.
+
+   Build:
+     make clean
+     make XCFLAGS=-DSE_ZEROCOPY zcbench
+
+   Run on one host (loopback always copies; see the 'copied' column):
+     ./zcbench
+   Run against a sink on another host:
+     remote$ ./zcbench -s 9400
+     local$  ./zcbench remote-host 9400
+ */
+
+#include <SMQ.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifndef SE_ZEROCOPY
+#error Compile with -DSE_ZEROCOPY
+#endif
+
+#define BENCH_BYTES (64*1024*1024) /* Data sent per size and mode */
+
+static const U32 sizes[] = {1024, 2048, 4096, 8192, 16384, 32768, 0xFFF0};
+
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static double
+cpuTime(void)
+{
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+      ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+
+static void
+sink(SOCKET* lsock)
+{
+   for(;;)
+   {
+      SOCKET s;
+      SOCKET* sp = &s;
+      if(se_accept(&lsock, INFINITE_TMO, &sp) != 1)
+         return;
+      if(fork() == 0)
+      {
+         static U8 buf[64*1024];
+         while(recv(s, buf, sizeof(buf), 0) > 0) ;
+         _exit(0);
+      }
+      close(s);
+   }
+}
+
+
+/* Publish BENCH_BYTES in messages of 'size' bytes. Returns -1 on error. */
+static int
+run(const char* host, U16 port, U32 size, U32 threshold,
+    double* mbps, double* cpuPerMsg)
+{
+   static U8 buf[512]; /* Small SMQ buffer: payload is sent from 'data' */
+   SMQ smq;
+   U8* data;
+   U32 i, count = BENCH_BYTES / size;
+   double t, c;
+   SMQ_constructor(&smq, buf, sizeof(buf));
+   if(se_connect(&smq.sock, host, port))
+      return -1;
+   data = (U8*)malloc(size);
+   memset(data, 'x', size);
+   se_zcThreshold = threshold;
+   t = now();
+   c = cpuTime();
+   for(i = 0 ; i < count ; i++)
+   {
+      if(SMQ_publish(&smq, data, (int)size, 1, 0))
+      {
+         free(data);
+         SMQ_destructor(&smq);
+         return -1;
+      }
+   }
+   t = now() - t;
+   c = cpuTime() - c;
+   *mbps = (double)count * size / t / (1024 * 1024);
+   *cpuPerMsg = c / count * 1e6;
+   free(data);
+   SMQ_destructor(&smq);
+   return 0;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+   const char* host = "127.0.0.1";
+   U16 port = 9400;
+   pid_t child = 0;
+   U32 i;
+   signal(SIGPIPE, SIG_IGN);
+   if(argc > 2 && !strcmp(argv[1], "-s"))
+   {
+      SOCKET lsock;
+      if(se_bind(&lsock, (U16)atoi(argv[2])))
+         return 1;
+      sink(&lsock);
+      return 0;
+   }
+   if(argc > 1)
+   {
+      host = argv[1];
+      if(argc > 2)
+         port = (U16)atoi(argv[2]);
+   }
+   else
+   {
+      SOCKET lsock;
+      if(se_bind(&lsock, port))
+         return 1;
+      if((child = fork()) == 0)
+      {
+         sink(&lsock);
+         _exit(0);
+      }
+      se_close(&lsock);
+   }
+   printf("%8s %12s %12s %12s %12s %8s\n", "size", "copy MB/s",
+          "copy us/msg", "zc MB/s", "zc us/msg", "copied");
+   for(i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+   {
+      double cmb, ccpu, zmb, zcpu;
+      U32 copied = se_zcStats.copied;
+      if(run(host, port, sizes[i], ~(U32)0, &cmb, &ccpu) ||
+         run(host, port, sizes[i], 0, &zmb, &zcpu))
+      {
+         printf("Connection to %s:%d failed\n", host, (int)port);
+         break;
+      }
+      printf("%8u %12.1f %12.2f %12.1f %12.2f %8u\n", sizes[i],
+             cmb, ccpu, zmb, zcpu, se_zcStats.copied - copied);
+   }
+   if(child)
+   {
+      kill(child, SIGTERM);
+      waitpid(child, 0, 0);
+   }
+   return 0;
+}
+
+
+#ifdef XPRINTF
+void _xprintf(const char* fmt, ...)
+{
+   va_list varg;
+   va_start(varg, fmt);
+   vprintf(fmt, varg);
+   va_end(varg);
+}
+#endif
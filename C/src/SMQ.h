@@ -134,6 +134,29 @@
 
 #define SMQSTR(str) str, (sizeof(str)-1)
 
+/** Interface for borrowing a buffer when a frame is larger than
+    SMQ::buf. See #SMQ_setBufIntf and SMQPool.h.
+ */
+typedef struct SMQBufIntf
+{
+   /** Returns a buffer of at least 'size' bytes and sets 'outSize' to
+       the buffer size, or returns NULL.
+   */
+   U8* (*borrow)(struct SMQBufIntf* o, U32 size, U32* outSize);
+   /** Returns a buffer obtained from 'borrow'. */
+   void (*giveBack)(struct SMQBufIntf* o, U8* buf, U32 size);
+} SMQBufIntf;
+
+/** Resize statistics for the adaptive buffer; see #SMQ_constructor2.
+ */
+typedef struct
+{
+   U32 grows; /**< Times the buffer was enlarged */
+   U32 shrinks; /**< Times the buffer was reduced after being idle */
+   U32 failures; /**< baRealloc failures */
+   U16 peakLen; /**< Largest buffer size */
+} SMQBufStats;
+
 /** SimpleMQ structure.
  */
 typedef struct SMQ
@@ -141,6 +164,8 @@ typedef struct SMQ
    SOCKET sock;
 
    U8* buf; /**< The buffer set via the constructor. */
+   /** Socket options set via #SMQ_setSockOpt */
+   const SeSockOpt* sockOpt;
 #ifdef SMQ_ENABLE_SENDBUF
    U8* sBuf;
 #endif
@@ -163,6 +188,17 @@ typedef struct SMQ
    /** Read frame data using SMQ_getMessage until: frameLen - bytesRead = 0 */
    U16 bytesRead;
    U8 inRecv; /* boolean set to true when thread blocked in SMQ_recv */
+   /** Optional buffer pool set via #SMQ_setBufIntf */
+   SMQBufIntf* bufIntf;
+   U8* ownBuf; /* SMQ::buf while a borrowed buffer is in use */
+   U16 ownBufLen;
+#ifdef SMQ_ADAPTIVE_BUF
+   SMQBufStats bufStats; /**< Adaptive buffer resize statistics */
+   U32 idleTmo; /* See SMQ_constructor2 */
+   U32 lastLarge; /* SMQ_MSTIME() when the last large frame arrived */
+   U16 minBufLen;
+   U16 maxBufLen; /* Non zero in adaptive mode */
+#endif
 #ifdef __cplusplus
 
 /** Create a SimpleMQ client instance.
@@ -171,6 +207,11 @@ typedef struct SMQ
    SMQ(U8* buf, U16 bufLen);
 
 
+/** Set the socket options used when connecting.
+    \see SMQ_setSockOpt
+*/
+   void setSockOpt(const SeSockOpt* opt);
+
 /** Initiate the SMQ server connection. 
     \see SMQ_init
 */
@@ -228,6 +269,12 @@ typedef struct SMQ
    int publish(const void* data, int len, U32 tid, U32 subtid);
 
 
+/** Publish a message gathered from several buffers.
+    \see SMQ_publishv
+*/
+   int publishv(const SeIoVec* iov, int cnt, U32 tid, U32 subtid);
+
+
 /** Publish a message in chunks and request the broker to assemble the
     message before publishing to the subscriber(s).
     \see SMQ_wrtstr
@@ -240,6 +287,11 @@ typedef struct SMQ
 */
    int write( const void* data, int len);
 
+/** Publish a message in chunks without copying large regions.
+    \see SMQ_writeDirect
+*/
+   int writeDirect( const void* data, int len);
+
 /** Flush the internal buffer and request the broker to assemble all
     stored fragments as one message.
     \see SMQ_pubflush
@@ -296,6 +348,33 @@ extern "C" {
 void SMQ_constructor(SMQ* o, U8* buf, U16 bufLen);
 
 
+#ifdef SMQ_ADAPTIVE_BUF
+/** Create a SimpleMQ client instance with an adaptive buffer
+    (requires SMQ_ADAPTIVE_BUF). The buffer is allocated with baMalloc
+    and starts at 'minLen' bytes. It is enlarged with baRealloc, up to
+    'maxLen' bytes, when a frame does not fit; a message larger than
+    'maxLen' is returned in fragments as with a fixed buffer. The
+    buffer is reduced to 'minLen' bytes when no frame larger than
+    'minLen' has been received for 'idleTmo' milliseconds. The check
+    runs for each received frame and in #SMQ_idle, so the buffer also
+    shrinks on a connection that keeps receiving small frames.
+    SMQ::bufStats counts the resize events. The buffer is released by
+    #SMQ_destructor.
+
+    The idle time is measured with SMQ_MSTIME(), a monotonic
+    millisecond clock returning U32. The Posix and Windows ports
+    provide it; define SMQ_MSTIME() when compiling for other ports.
+    \param o Uninitialized data of size sizeof(SMQ).
+    \param minLen initial and idle buffer length; see #SMQ_constructor.
+    \param maxLen max buffer length.
+    \param idleTmo idle time in milliseconds before the buffer
+    shrinks, or zero to never shrink.
+    \returns zero on success or -1 if the buffer cannot be allocated.
+ */
+int SMQ_constructor2(SMQ* o, U16 minLen, U16 maxLen, U32 idleTmo);
+#endif
+
+
 /** Bare metal configuration. This macro must be called immediately
     after calling the constructor on bare metal systems.
     \param o the #SMQ instance.
@@ -304,12 +383,50 @@ void SMQ_constructor(SMQ* o, U8* buf, U16 bufLen);
 #define SMQ_setCtx(o, ctx) SOCKET_constructor(&(o)->sock, ctx)
 
 
+/** Set the socket options used by #SMQ_init when connecting to the
+    broker. The options must be set prior to calling SMQ_init and
+    'opt' must be valid until SMQ_init returns. Example:
+    \code
+    static SeSockOpt opt;
+    SeSockOpt_constructor(&opt);
+    opt.noDelay = TRUE;
+    opt.keepAlive = TRUE;
+    opt.keepIdle = 60;
+    SMQ_setSockOpt(&smq, &opt);
+    \endcode
+    \param o the #SMQ instance.
+    \param opt the socket options or NULL for the stack's defaults.
+ */
+#define SMQ_setSockOpt(o, opt) ((o)->sockOpt = (opt))
+
+
+/** Set an interface used for borrowing a buffer when a frame is
+    larger than the buffer set in the constructor. The frame is then
+    received in one piece in the borrowed buffer, which is returned to
+    the interface by the next #SMQ_getMessage call or by
+    #SMQ_destructor, thus a session only holds a large buffer while
+    the application processes a large message. Without this interface,
+    #SMQ_getMessage returns a large message in fragments. Not
+    supported when compiled with SMQ_ENABLE_SENDBUF.
+    \param o the #SMQ instance.
+    \param intf the interface or NULL. See SMQPool.h.
+ */
+#define SMQ_setBufIntf(o, intf) ((o)->bufIntf = (intf))
+
+
 /** Initiate the SMQ server connection. The connection phase is
     divided into two steps: (1) initiating and (2) connecting via
     SMQ_connect.
     \param o the SMQ instance.
     \param url is a URL that starts with http:// and this URL
     must be to a server resource that initiates a SimpleMQ connection.
+    A URL that starts with https:// is accepted when the library is
+    compiled with SE_TLS (Posix: seTls.h). A broker on the same host
+    can be reached with an AF_UNIX socket when the porting layer
+    defines SE_UNIX (Posix): unix:/socket/path or
+    unix:/socket/path:/smq.lsp, where the optional part after the
+    second colon is the broker resource; the Host header is then
+    "localhost".
     \param rnd (out param) a random number created by the server. This
     number can be used for securing hash based password encryption.
     \returns 0 on success, error code from TCP/IP stack, or
@@ -420,6 +537,23 @@ int SMQ_unsubscribe(SMQ* o, U32 tid);
 int SMQ_publish(SMQ* o, const void* data, int len, U32 tid, U32 subtid);
 
 
+/** Publish one message gathered from several buffers, such as a
+    protocol header followed by the payload, without copying the
+    buffers into SMQ::buf. The message is sent with one #se_sendv
+    call.
+    \param o the SMQ instance.
+    \param iov the buffers; the message size must not exceed 0xFFF0.
+    \param cnt number of buffers, at most #SMQ_PUBLISHV_MAX.
+    \param tid the topic ID.
+    \param subtid optional sub-topic ID.
+    \see SMQ_publish
+ */
+int SMQ_publishv(SMQ* o, const SeIoVec* iov, int cnt, U32 tid, U32 subtid);
+
+/** Max number of buffers for #SMQ_publishv */
+#define SMQ_PUBLISHV_MAX 7
+
+
 /** Publish a message in chunks and request the broker to assemble the
     message before publishing to the subscriber(s). This method uses
     the internal buffer (SMQ::buf) and sends the message as a chunk
@@ -448,6 +582,21 @@ int SMQ_wrtstr(SMQ* o, const char* str);
  */
 int SMQ_write(SMQ* o,  const void* data, int len);
 
+/** Same as #SMQ_write, but data that does not fit in the internal
+    buffer is sent directly from 'data' without being copied. The
+    fragment header and the bytes already buffered are sent together
+    with the caller's data using one vectored send (#se_sendv), and
+    only the tail that fits in the internal buffer is copied. Use this
+    function when streaming large regions, such as a JSON document
+    built in a separate buffer, through a small SMQ::buf. SMQ_write
+    and SMQ_writeDirect can be mixed in the same message.
+
+    \param o the SMQ instance.
+    \param data message payload.
+    \param len payload length.
+ */
+int SMQ_writeDirect(SMQ* o,  const void* data, int len);
+
 /** Flush the internal buffer and request the broker to assemble all
     stored fragments as one message. This message is then published to
     topic 'tid', and sub-topic 'subtid'.
@@ -529,6 +678,62 @@ int SMQ_getMessage(SMQ* o, U8** msg);
  */
 #define SMQ_getMsgSize(o) ((o)->frameLen-15)
 
+
+/** \defgroup SMQClient_Event Event driven API
+\ingroup SMQClient_C
+
+SMQ_init and SMQ_connect split into the request and response steps,
+for clients that do not block in the SMQ functions, such as the C++20
+coroutine layer in SMQCo.h. The caller connects SMQ::sock, waits
+until the complete response frame is in the socket's receive buffer,
+and then calls the response function, which returns without blocking.
+@{
+*/
+
+/** Extract the hostname and port number from a URL.
+    \param url the URL as used by #SMQ_init.
+    \param host buffer for the hostname.
+    \param hostLen size of 'host'.
+    \param port (out param) the port number.
+    \returns 0 on success, #SMQE_INVALID_URL, or #SMQE_BUF_OVERFLOW.
+    For a unix: URL, 'host' is set to the socket path and 'port' to 0.
+ */
+int SMQ_parseUrl(const char* url, char* host, int hostLen, U16* port);
+
+/** Send the HTTP request initiating the SMQ connection on the
+    connected SMQ::sock.
+    \see SMQ_init
+ */
+int SMQ_initReq(SMQ* o, const char* url);
+
+/** Read the Init message sent in response to #SMQ_initReq.
+    \see SMQ_init
+ */
+int SMQ_initRsp(SMQ* o, U32* rnd);
+
+/** Send the Connect message.
+    \see SMQ_connect
+ */
+int SMQ_connectReq(SMQ* o, const char* uid, int uidLen,
+                   const char* credentials, U8 credLen,
+                   const char* info, int infoLen);
+
+/** Read the Connack message sent in response to #SMQ_connectReq.
+    \see SMQ_connect
+ */
+int SMQ_connectRsp(SMQ* o);
+
+/** Run the timeout logic SMQ_getMessage runs when no frame is
+    received within SMQ::timeout: sends a PING when the connection
+    has been idle for SMQ::pingTmo and shrinks the adaptive buffer.
+    \param o the SMQ instance.
+    \param ms time in milliseconds since the last call or frame.
+    \returns #SMQ_TIMEOUT, #SMQE_PONGTIMEOUT, or a socket error code.
+ */
+int SMQ_idle(SMQ* o, U32 ms);
+
+/** @} */ /* end group SMQClient_Event */
+
 /** @} */ /* end group SMQClient_C */ 
 
 #ifdef __cplusplus
@@ -537,6 +742,10 @@ inline SMQ::SMQ(U8* buf, U16 bufLen) {
    SMQ_constructor(this,buf, bufLen);
 }
 
+inline void SMQ::setSockOpt(const SeSockOpt* opt) {
+   SMQ_setSockOpt(this, opt);
+}
+
 inline int SMQ::init(const char* url, U32* rnd) {
    return SMQ_init(this, url, rnd);
 }
@@ -574,6 +783,10 @@ inline int SMQ::publish(const void* data, int len, U32 _tid, U32 _subtid) {
    return SMQ_publish(this, data, len, _tid, _subtid);
 }
 
+inline int SMQ::publishv(const SeIoVec* iov, int cnt, U32 _tid, U32 _subtid) {
+   return SMQ_publishv(this, iov, cnt, _tid, _subtid);
+}
+
 inline int SMQ::wrtstr(const char* str) {
    return SMQ_wrtstr(this, str);
 }
@@ -582,6 +795,10 @@ inline int SMQ::write( const void* data, int len) {
    return SMQ_write(this, data, len);
 }
 
+inline int SMQ::writeDirect( const void* data, int len) {
+   return SMQ_writeDirect(this, data, len);
+}
+
 inline int SMQ::pubflush(U32 _tid, U32 _subtid) {
    return SMQ_pubflush(this, _tid, _subtid);
 }
@@ -629,8 +846,11 @@ inline int SMQ::getMsgSize() {
 #define SharkMQ_unsubscribe(o, tid) SMQ_unsubscribe(o, tid)
 #define SharkMQ_publish(o, data, len, tid, subtid) \
    SMQ_publish(o, data, len, tid, subtid)
+#define SharkMQ_publishv(o, iov, cnt, tid, subtid) \
+   SMQ_publishv(o, iov, cnt, tid, subtid)
 #define SharkMQ_wrtstr(o, str) SMQ_wrtstr(o, str)
 #define SharkMQ_write(o,  data, len) SMQ_write(o,  data, len)
+#define SharkMQ_writeDirect(o,  data, len) SMQ_writeDirect(o,  data, len)
 #define SharkMQ_pubflush(o, tid, subtid) SMQ_pubflush(o, tid, subtid)
 #define SharkMQ_observe(o, tid) SMQ_observe(o, tid)
 #define SharkMQ_unobserve(o, tid) SMQ_unobserve(o, tid)
@@ -132,6 +132,134 @@ SMQ_readFrameHeader(SMQ* o)
 
 
 
+#ifndef SMQ_ENABLE_SENDBUF
+/* Borrow a buffer for a frame larger than SMQ::buf. The frame header
+   bytes read thus far are copied to the borrowed buffer.
+   Returns TRUE if SMQ::buf can now hold the frame.
+ */
+static int
+SMQ_borrowBuf(SMQ* o)
+{
+   U32 size;
+   U8* buf;
+   if(!o->bufIntf || o->ownBuf)
+      return FALSE;
+   buf = o->bufIntf->borrow(o->bufIntf, o->frameLen, &size);
+   if(!buf)
+      return FALSE;
+   memcpy(buf, o->buf, o->rBufIx);
+   o->ownBuf = o->buf;
+   o->ownBufLen = o->bufLen;
+   o->buf = buf;
+   o->bufLen = size > 0xFFFF ? 0xFFFF : (U16)size;
+   return TRUE;
+}
+
+
+static void
+SMQ_returnBuf(SMQ* o)
+{
+   if(o->ownBuf)
+   {
+      o->bufIntf->giveBack(o->bufIntf, o->buf, o->bufLen);
+      o->buf = o->ownBuf;
+      o->bufLen = o->ownBufLen;
+      o->ownBuf = 0;
+   }
+}
+#else
+#define SMQ_borrowBuf(o) FALSE
+#define SMQ_returnBuf(o)
+#endif
+
+
+#ifdef SMQ_ADAPTIVE_BUF
+#ifdef SMQ_ENABLE_SENDBUF
+#error SMQ_ADAPTIVE_BUF cannot be combined with SMQ_ENABLE_SENDBUF
+#endif
+
+#ifndef SMQ_MSTIME
+#if defined(SharkSSLWindows)
+#define SMQ_MSTIME() ((U32)GetTickCount())
+#elif defined(SharkSSLPosix)
+#include <time.h>
+static U32
+SMQ_msTime(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U32)ts.tv_sec * 1000 + (U32)(ts.tv_nsec / 1000000);
+}
+#define SMQ_MSTIME() SMQ_msTime()
+#else
+#error SMQ_ADAPTIVE_BUF requires a millisecond clock: define SMQ_MSTIME()
+#endif
+#endif
+
+/* Reallocate the adaptive buffer. Returns TRUE on success. */
+static int
+SMQ_resizeBuf(SMQ* o, U32 len)
+{
+   U8* buf;
+   if(len > o->maxBufLen)
+      len = o->maxBufLen;
+   if(len == o->bufLen)
+      return TRUE;
+   buf = (U8*)baRealloc(o->buf, len);
+   if(!buf)
+   {
+      o->bufStats.failures++;
+      return FALSE;
+   }
+   if(len > o->bufLen)
+   {
+      o->bufStats.grows++;
+      if(len > o->bufStats.peakLen)
+         o->bufStats.peakLen = (U16)len;
+   }
+   else
+      o->bufStats.shrinks++;
+   o->buf = buf;
+   o->bufLen = (U16)len;
+   return TRUE;
+}
+
+
+/* Reduce the adaptive buffer to SMQ::minBufLen when no frame larger
+   than that has been received for SMQ::idleTmo ms. The buffer must
+   not hold more than a frame header, or a frame that fits.
+ */
+static void
+SMQ_shrinkIdleBuf(SMQ* o)
+{
+   if(o->maxBufLen && o->idleTmo && o->bufLen > o->minBufLen &&
+      (U32)(SMQ_MSTIME() - o->lastLarge) >= o->idleTmo)
+   {
+      SMQ_resizeBuf(o, o->minBufLen);
+   }
+}
+#endif
+
+
+/* Make SMQ::buf large enough for the current frame, if possible, by
+   growing the adaptive buffer or by borrowing a buffer.
+   Returns TRUE if SMQ::buf can now hold the frame.
+ */
+static int
+SMQ_growBuf(SMQ* o)
+{
+#ifdef SMQ_ADAPTIVE_BUF
+   if(o->maxBufLen)
+   {  /* Grow at least 2x to limit the number of reallocations */
+      U32 len = 2 * (U32)o->bufLen;
+      SMQ_resizeBuf(o, len > o->frameLen ? len : o->frameLen);
+      return o->frameLen <= o->bufLen;
+   }
+#endif
+   return SMQ_borrowBuf(o);
+}
+
+
 /* Reads a complete frame.
    Designed to be used by control frames.
 
@@ -143,7 +271,7 @@ SMQ_readFrame(SMQ* o, int hasFH)
 {
    int x;
    if(!hasFH && SMQ_readFrameHeader(o)) return o->status;
-   if(o->frameLen > o->bufLen || o->frameLen < 3)
+   if((o->frameLen > o->bufLen && !SMQ_growBuf(o)) || o->frameLen < 3)
       return o->status = SMQE_BUF_OVERFLOW;
    do
    {
@@ -244,72 +372,153 @@ SMQ_constructor(SMQ* o, U8* buf, U16 bufLen)
 }
 
 
+#ifdef SMQ_ADAPTIVE_BUF
 int
-SMQ_init(SMQ* o, const char* url, U32* rnd)
+SMQ_constructor2(SMQ* o, U16 minLen, U16 maxLen, U32 idleTmo)
 {
-   int x;
-   const char* path;
-   const char* eohn; /* End Of Hostname */
+   U8* buf = (U8*)baMalloc(minLen);
+   SMQ_constructor(o, buf, minLen);
+   if(!buf)
+      return -1;
+   o->minBufLen = minLen;
+   o->maxBufLen = maxLen < minLen ? minLen : maxLen;
+   o->idleTmo = idleTmo;
+   o->lastLarge = SMQ_MSTIME();
+   o->bufStats.peakLen = minLen;
+   return 0;
+}
+#endif
+
+
+/* Split 'url' into hostname (url..eohn), port, and path. For
+   unix:/socket/path[:/smq/path], the hostname is the socket path and
+   the port is zero.
+   Returns zero or SMQE_INVALID_URL.
+ */
+static int
+SMQ_splitUrl(const char** url, const char** eohn, const char** path,
+             U16* port)
+{
+   const char* u = *url;
    U16 portNo=0;
-   if( ! strncmp("http://",url,7) )
-      url+=7;
-   else if( ! strncmp("https:", url, 6) )
+   U16 defPort=80;
+   if( ! strncmp("http://",u,7) )
+      u+=7;
+#ifdef SE_TLS
+   else if( ! strncmp("https://", u, 8) )
+   {
+      u+=8;
+      defPort=443;
+   }
+#endif
+   else if( ! strncmp("https:", u, 6) )
       return SMQE_INVALID_URL;
-   path=strchr(url, '/');
-   if(!path)
-      path = url+strlen(url);
-   if(path > url && ISDIGIT((unsigned char)*(path-1)))
+#ifdef SE_UNIX
+   else if( ! strncmp("unix:", u, 5) )
+   {
+      u+=5;
+      if(u[0] == '/' && u[1] == '/') /* unix:///socket/path */
+         u+=2;
+      *eohn=strchr(u, ':');
+      if(!*eohn)
+         *eohn = u+strlen(u);
+      if(*eohn == u)
+         return SMQE_INVALID_URL;
+      *path = **eohn ? *eohn+1 : *eohn;
+      *url=u;
+      *port=0;
+      return 0;
+   }
+#endif
+   *path=strchr(u, '/');
+   if(!*path)
+      *path = u+strlen(u);
+   if(*path > u && ISDIGIT((unsigned char)*(*path-1)))
    {
-      for(eohn = path-2 ; ; eohn--)
+      for(*eohn = *path-2 ; ; (*eohn)--)
       {
-         if(path > url)
+         if(*path > u)
          {
-            if( ! ISDIGIT((unsigned char)*eohn) )
+            if( ! ISDIGIT((unsigned char)**eohn) )
             {
-               const char* ptr = eohn;
+               const char* ptr = *eohn;
                if(*ptr != ':')
                   goto L_defPorts;
-               while(++ptr < path)
+               while(++ptr < *path)
                   portNo = 10 * portNo + (*ptr-'0');
                break;
             }
          }
          else
-            return o->status = SMQE_INVALID_URL;
+            return SMQE_INVALID_URL;
       }
    }
    else
    {
 L_defPorts:
-      portNo=80;
-      eohn=path; /* end of eohn */
+      portNo=defPort;
+      *eohn=*path; /* end of eohn */
    }
-   /* Write hostname */
+   *url=u;
+   *port=portNo;
+   return 0;
+}
 
-   SMQ_resetSB(o);
-   SMQSBufIx(o) = (U16)(eohn-url); /* save hostname len */
-   if((SMQSBufIx(o)+1) >= o->bufLen)
-      return o->status = SMQE_BUF_OVERFLOW;
-   memcpy(SMQSBuf(o), url, SMQSBufIx(o)); 
-   SMQSBuf(o)[SMQSBufIx(o)]=0;
 
-   /* connect to 'hostname' */
-   if( (x = se_connect(&o->sock, (char*)SMQSBuf(o), portNo)) != 0 )
-      return o->status = x;
+int
+SMQ_parseUrl(const char* url, char* host, int hostLen, U16* port)
+{
+   const char* eohn;
+   const char* path;
+   if(SMQ_splitUrl(&url, &eohn, &path, port))
+      return SMQE_INVALID_URL;
+   if((eohn-url) >= hostLen)
+      return SMQE_BUF_OVERFLOW;
+   memcpy(host, url, eohn-url);
+   host[eohn-url]=0;
+   return 0;
+}
+
 
+int
+SMQ_initReq(SMQ* o, const char* url)
+{
+   const char* path;
+   const char* eohn; /* End Of Hostname */
+   const char* host;
+   U16 portNo;
+#ifdef SE_UNIX
+   BaBool local = ! strncmp("unix:", url, 5);
+#endif
+   if(SMQ_splitUrl(&url, &eohn, &path, &portNo))
+      return o->status = SMQE_INVALID_URL;
+   host = url;
+#ifdef SE_UNIX
+   if(local)
+   {
+      host = "localhost";
+      eohn = host+9;
+   }
+#endif
    /* Send HTTP header. Host is included for multihomed servers */
    SMQ_resetSB(o);
    if(SMQ_writeb(o, SMQSTR("GET ")) ||
       (*path == 0 ? SMQ_writeb(o, "/", -1) : SMQ_writeb(o, path, -1)) ||
       SMQ_writeb(o,SMQSTR(" HTTP/1.0\r\nHost: ")) ||
-      SMQ_writeb(o, url, eohn-url) ||
+      SMQ_writeb(o, host, eohn-host) ||
       SMQ_writeb(o, SMQSTR("\r\nSimpleMQ: 1\r\n")) ||
       SMQ_writeb(o, SMQSTR("User-Agent: SimpleMQ/1\r\n\r\n")) ||
       SMQ_flushb(o))
    {
       return o->status;
    }
+   return 0;
+}
+
 
+int
+SMQ_initRsp(SMQ* o, U32* rnd)
+{
    /* Get the Init message */
    if(SMQ_readFrame(o, FALSE)) return o->status;
    if(o->frameLen < 11 || o->buf[2] != MSG_INIT || o->buf[3] != SMQ_S_VERSION)
@@ -322,10 +531,47 @@ L_defPorts:
 }
 
 
+int
+SMQ_init(SMQ* o, const char* url, U32* rnd)
+{
+   int x;
+   U16 portNo;
+
+   /* Write hostname */
+   x = SMQ_parseUrl(url, (char*)SMQSBuf(o), o->bufLen, &portNo);
+   if(x)
+      return o->status = x;
+
+   /* connect to 'hostname' */
+#ifdef SE_UNIX
+   if( ! strncmp("unix:", url, 5) )
+   {
+      x = se_connectUnix(&o->sock, (char*)SMQSBuf(o));
+      if(!x && o->sockOpt)
+         se_setSockOpt(&o->sock, o->sockOpt); /* TCP options are ignored */
+   }
+   else
+#endif
+      x = se_connectEx(&o->sock, (char*)SMQSBuf(o), portNo, o->sockOpt);
+   if(x != 0)
+      return o->status = x;
+#ifdef SE_TLS
+   if( ! strncmp("https://", url, 8) )
+   {
+      x = se_tlsConnect(&o->sock, (char*)SMQSBuf(o), portNo);
+      if(x != 0)
+         return o->status = x;
+   }
+#endif
+
+   if(SMQ_initReq(o, url)) return o->status;
+   return SMQ_initRsp(o, rnd);
+}
+
 
 int
-SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
-            U8 credLen, const char* info, int infoLen)
+SMQ_connectReq(SMQ* o, const char* uid, int uidLen, const char* credentials,
+               U8 credLen, const char* info, int infoLen)
 {
    if(o->bufLen < 5+uidLen+credLen+infoLen) return SMQE_BUF_OVERFLOW;
    SMQSBufIx(o) = 2;
@@ -341,8 +587,13 @@ SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
    if(info)
       SMQ_putb(o,info,infoLen);
    netConvU16(SMQSBuf(o), (U8*)&SMQSBufIx(o)); /* Frame Len */
-   if(SMQ_flushb(o)) return o->status;
+   return SMQ_flushb(o) ? o->status : 0;
+}
+
 
+int
+SMQ_connectRsp(SMQ* o)
+{
    /* Get the response message Connack */
    if(SMQ_readFrame(o, FALSE)) return o->status;
    if(o->frameLen < 8 || o->buf[2] != MSG_CONNACK)
@@ -360,6 +611,15 @@ SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
 }
 
 
+int
+SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
+            U8 credLen, const char* info, int infoLen)
+{
+   int x = SMQ_connectReq(o,uid,uidLen,credentials,credLen,info,infoLen);
+   return x ? x : SMQ_connectRsp(o);
+}
+
+
 void
 SMQ_disconnect(SMQ* o)
 {
@@ -378,6 +638,14 @@ void
 SMQ_destructor(SMQ* o)
 {
    se_close(&o->sock);
+   SMQ_returnBuf(o);
+#ifdef SMQ_ADAPTIVE_BUF
+   if(o->maxBufLen && o->buf)
+   {
+      baFree(o->buf);
+      o->buf = 0;
+   }
+#endif
 }
 
 /* Send MSG_SUBSCRIBE, MSG_CREATE, or MSG_CREATESUB */
@@ -466,6 +734,38 @@ SMQ_publish(SMQ* o, const void* data, int len, U32 tid, U32 subtid)
 }
 
 
+int
+SMQ_publishv(SMQ* o, const SeIoVec* iov, int cnt, U32 tid, U32 subtid)
+{
+   SeIoVec v[SMQ_PUBLISHV_MAX+1];
+   U8 buf[15];
+   U32 len=15;
+   U16 tlen;
+   int i, x;
+   if(cnt > SMQ_PUBLISHV_MAX)
+      return SMQE_BUF_OVERFLOW;
+   for(i=0 ; i < cnt ; i++)
+   {
+      len += iov[i].len;
+      v[i+1] = iov[i];
+   }
+   if(len > 0xFFF0+15)
+      return SMQE_BUF_OVERFLOW;
+   tlen=(U16)len;
+   netConvU16(buf, (U8*)&tlen); /* Frame Len */
+   buf[2] = MSG_PUBLISH;
+   netConvU32(buf+3, (U8*)&tid);
+   netConvU32(buf+7,(U8*)&o->clientTid);
+   netConvU32(buf+11,(U8*)&subtid);
+   v[0].data = buf;
+   v[0].len = 15;
+   x = se_sendv(&o->sock, v, cnt+1);
+   if(x < 0)
+      return o->status = x;
+   return 0;
+}
+
+
 int
 SMQ_wrtstr(SMQ* o, const char* data)
 {
@@ -497,6 +797,49 @@ SMQ_write(SMQ* o,  const void* data, int len)
 }
 
 
+int
+SMQ_writeDirect(SMQ* o,  const void* data, int len)
+{
+   U8* ptr = (U8*)data;
+   if(o->inRecv)
+      return SMQE_PROTOCOL_ERROR;
+   if(!SMQSBufIx(o))
+      SMQSBufIx(o) = 15;
+   while(len > o->bufLen - SMQSBufIx(o))
+   {
+      SeIoVec iov[2];
+      U16 flen;
+      int x, chunk = 0xFFF0 - (SMQSBufIx(o) - 15);
+      if(chunk > len)
+         chunk = len;
+      /* Fragment: the buffered data followed by 'chunk' caller bytes */
+      flen = (U16)(SMQSBufIx(o) + chunk);
+      netConvU16(SMQSBuf(o), (U8*)&flen); /* Frame Len */
+      SMQSBuf(o)[2] = MSG_PUBFRAG;
+      memset(SMQSBuf(o)+3, 0, 4);
+      netConvU32(SMQSBuf(o)+7,(U8*)&o->clientTid);
+      memset(SMQSBuf(o)+11, 0, 4);
+      iov[0].data = SMQSBuf(o);
+      iov[0].len = SMQSBufIx(o);
+      iov[1].data = ptr;
+      iov[1].len = (U32)chunk;
+      x = se_sendv(&o->sock, iov, 2);
+      SMQSBufIx(o) = 15;
+      if(x < 0)
+      {
+         SMQ_resetSB(o);
+         return o->status = x;
+      }
+      ptr += chunk;
+      len -= chunk;
+   }
+   /* Small tail: buffer it */
+   memcpy(SMQSBuf(o)+SMQSBufIx(o), ptr, len);
+   SMQSBufIx(o) += (U16)len;
+   return 0;
+}
+
+
 int
 SMQ_pubflush(SMQ* o, U32 tid, U32 subtid)
 {
@@ -530,11 +873,44 @@ SMQ_unobserve(SMQ* o, U32 tid)
 }
 
 
+int
+SMQ_idle(SMQ* o, U32 ms)
+{
+#ifdef SMQ_ADAPTIVE_BUF
+   if(o->rBufIx == 0)
+      SMQ_shrinkIdleBuf(o);
+#endif
+   if(o->pingTmoCounter >= 0)
+   {
+      o->pingTmoCounter += ms;
+      if(o->pingTmoCounter >= o->pingTmo && o->rBufIx == 0)
+      {
+         /* Use rec buffer for sending */
+         o->pingTmoCounter = -10000; /* PONG tmo hard coded to 10 sec */
+         o->rBufIx=3;
+         netConvU16(o->buf, (U8*)&o->rBufIx); /* Frame Len */
+         o->buf[2] = MSG_PING;
+         o->status=se_send(&o->sock, o->buf, o->rBufIx);
+         SMQ_resetRB(o);
+         if(o->status < 0) return o->status;
+      }
+   }
+   else
+   {
+      o->pingTmoCounter += ms;
+      if(o->pingTmoCounter >= 0)
+         return SMQE_PONGTIMEOUT;
+   }
+   return o->status = SMQ_TIMEOUT;
+}
+
+
 int
 SMQ_getMessage(SMQ* o, U8** msg)
 {
    int x;
 
+   SMQ_returnBuf(o);
    if(o->bytesRead)
    {
       if(o->bytesRead < o->frameLen)
@@ -555,32 +931,16 @@ SMQ_getMessage(SMQ* o, U8** msg)
    {
       /* Timeout is not an error in between frames */
       if(o->status == SMQ_TIMEOUT)
-      {
-         if(o->pingTmoCounter >= 0)
-         {
-            o->pingTmoCounter += o->timeout;
-            if(o->pingTmoCounter >= o->pingTmo && o->rBufIx == 0)
-            {
-               /* Use rec buffer for sending */
-               o->pingTmoCounter = -10000; /* PONG tmo hard coded to 10 sec */
-               o->rBufIx=3;
-               netConvU16(o->buf, (U8*)&o->rBufIx); /* Frame Len */
-               o->buf[2] = MSG_PING;
-               o->status=se_send(&o->sock, o->buf, o->rBufIx);
-               SMQ_resetRB(o);
-               if(o->status < 0) return o->status;
-            }
-         }
-         else
-         {
-            o->pingTmoCounter += o->timeout;
-            if(o->pingTmoCounter >= 0)
-               return SMQE_PONGTIMEOUT;
-         }
-      }
+         return SMQ_idle(o, o->timeout);
       return o->status;
    }
    o->pingTmoCounter=0;
+#ifdef SMQ_ADAPTIVE_BUF
+   if(o->frameLen > o->minBufLen)
+      o->lastLarge = SMQ_MSTIME();
+   else
+      SMQ_shrinkIdleBuf(o); /* Keeps the header read thus far */
+#endif
    switch(o->buf[2])
    {
       case MSG_DISCONNECT:
@@ -621,6 +981,7 @@ SMQ_getMessage(SMQ* o, U8** msg)
 
       case MSG_PUBLISH:
          if(o->frameLen < 15) return SMQE_PROTOCOL_ERROR;
+         if(o->frameLen > o->bufLen) SMQ_growBuf(o);
          o->bytesRead = o->frameLen <= o->bufLen ? o->frameLen : o->bufLen;
          x=SMQ_readData(o, o->bytesRead);
          SMQ_resetRB(o);
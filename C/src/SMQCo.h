@@ -0,0 +1,931 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+  C++20 coroutine interface for the SMQ client.
+ */
+
+#ifndef __SMQCo_h
+#define __SMQCo_h
+
+#include "SMQ.h"
+
+#if !defined(__cplusplus) || __cplusplus < 202002L
+#error SMQCo.h requires C++20
+#endif
+#if defined(SE_URING) || defined(SE_CTX) || defined(SMQ_ENABLE_SENDBUF)
+#error SMQCo.h requires the default Posix socket layer
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <deque>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+/** @defgroup SMQCo C++20 Coroutines
+    @ingroup SMQClient
+
+    A coroutine interface for the SMQ client, for running many
+    logical device tasks on one thread without a stack per task. The
+    tasks are C++20 coroutines returning #SMQTask and are run by an
+    #SMQExecutor, a single threaded event loop built on poll().
+
+    \code
+    SMQTask<> device(SMQExecutor& exec, const char* url, const char* uid)
+    {
+       U8 buf[512];
+       SMQCo smq(exec, buf, sizeof(buf));
+       if(co_await smq.connect(url, uid, strlen(uid)))
+          co_return;
+       S64 tid = co_await smq.create("/devices/status");
+       if(tid < 0)
+          co_return;
+       co_await smq.subscribe("/devices/cmd");
+       for(;;)
+       {
+          SMQCo::Message m = co_await smq.nextMessage();
+          if(m.len == SMQ_TIMEOUT)
+             smq.publish("alive", 5, tid, 0);
+          else if(m.len < 0)
+             break;
+       }
+    }
+
+    SMQExecutor exec;
+    for(i = 0 ; i < 1000 ; i++)
+       exec.spawn(device(exec, url, uids[i]));
+    exec.run();
+    \endcode
+
+    The SMQ C functions block while waiting for a frame. SMQCo waits
+    for readability with the executor and calls the C functions only
+    when the complete frame is in the socket's receive buffer
+    (SO_RCVLOWAT is set to the frame size), thus the calls return
+    without blocking. Sending, including publish, uses the C functions
+    and blocks if the socket's send buffer is full.
+
+    Requires the Posix port without SE_URING, SE_CTX, and
+    SMQ_ENABLE_SENDBUF.
+@{
+*/
+
+class SMQExecutor;
+
+/** @cond */
+struct SMQTaskPromiseBase
+{
+   std::coroutine_handle<> continuation;
+   SMQExecutor* owner = nullptr; /* Set for tasks started by spawn */
+
+   struct Final
+   {
+      bool await_ready() noexcept { return false; }
+      template<typename P> std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<P> h) noexcept;
+      void await_resume() noexcept {}
+   };
+
+   std::suspend_always initial_suspend() noexcept { return {}; }
+   Final final_suspend() noexcept { return {}; }
+   void unhandled_exception() noexcept { std::terminate(); }
+};
+
+template<typename T> struct SMQTaskPromise : SMQTaskPromiseBase
+{
+   T value{};
+   void return_value(T v) { value = std::move(v); }
+   T result() { return std::move(value); }
+};
+
+template<> struct SMQTaskPromise<void> : SMQTaskPromiseBase
+{
+   void return_void() {}
+   void result() {}
+};
+/** @endcond */
+
+
+/** A lazily started coroutine. Awaiting the task starts it and
+    returns its result. Tasks returning void can also be started by
+    SMQExecutor::spawn.
+*/
+template<typename T=void> class SMQTask
+{
+public:
+   struct promise_type : SMQTaskPromise<T>
+   {
+      SMQTask get_return_object() {
+         return SMQTask(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+   };
+
+   SMQTask(SMQTask&& t) noexcept : h(std::exchange(t.h, nullptr)) {}
+   SMQTask(const SMQTask&) = delete;
+   SMQTask& operator=(const SMQTask&) = delete;
+   ~SMQTask() { if(h) h.destroy(); }
+
+   bool await_ready() { return !h || h.done(); }
+   std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) {
+      h.promise().continuation = c;
+      return h;
+   }
+   T await_resume() { return h.promise().result(); }
+
+private:
+   friend class SMQExecutor;
+   explicit SMQTask(std::coroutine_handle<promise_type> ch) : h(ch) {}
+   std::coroutine_handle<promise_type> h;
+};
+
+
+/** Single threaded event loop running #SMQTask coroutines.
+*/
+class SMQExecutor
+{
+public:
+   /** A registered wait for socket events and/or a deadline.
+    */
+   struct Wait
+   {
+      int fd = -1; /* -1 for a timer */
+      short events = POLLIN;
+      U64 deadline = ~(U64)0; /* ms, see now() */
+      int result = 0; /* 1: events, 0: deadline, -1: socket error */
+      std::coroutine_handle<> h; /* Resumed when done, or: */
+      void (*cb)(Wait* w) = nullptr; /* Called when done */
+      void* user = nullptr;
+      size_t ix = ~(size_t)0; /* Index in 'waits' when active */
+   };
+
+   /** Awaitable returned by io() and sleep().
+    */
+   struct IoAwait
+   {
+      SMQExecutor* exec;
+      Wait w;
+      bool await_ready() { return false; }
+      void await_suspend(std::coroutine_handle<> h) { w.h = h; exec->add(&w); }
+      int await_resume() { return w.result; }
+   };
+
+   SMQExecutor() = default;
+   SMQExecutor(const SMQExecutor&) = delete;
+   SMQExecutor& operator=(const SMQExecutor&) = delete;
+
+   /** Start a task. The executor owns the task and destroys it
+       when it completes.
+   */
+   void spawn(SMQTask<void>&& t) {
+      std::coroutine_handle<SMQTask<void>::promise_type> h =
+         std::exchange(t.h, nullptr);
+      h.promise().owner = this;
+      tasks++;
+      ready.push_back(h);
+   }
+
+   /** Run until all spawned tasks have completed or stop() is called.
+       \returns 0, or -1 if poll fails.
+   */
+   int run();
+
+   /** Make run() return after the current iteration. */
+   void stop() { stopped = true; }
+
+   /** Number of spawned tasks not yet completed. */
+   U32 taskCount() const { return tasks; }
+
+   /** Wait for 'events' (POLLIN/POLLOUT) on 'fd' for at most 'tmo'
+       milliseconds, which can be #INFINITE_TMO.
+       \returns 1 when ready, 0 on timeout, and -1 on socket error.
+   */
+   IoAwait io(int fd, short events, U32 tmo) {
+      IoAwait a{this, {}};
+      a.w.fd = fd;
+      a.w.events = events;
+      a.w.deadline = deadline(tmo);
+      return a;
+   }
+
+   /** Suspend the calling task for 'ms' milliseconds. */
+   IoAwait sleep(U32 ms) { return io(-1, 0, ms); }
+
+   /** Monotonic time in milliseconds. */
+   static U64 now() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (U64)ts.tv_sec * 1000 + (U64)(ts.tv_nsec / 1000000);
+   }
+
+   static U64 deadline(U32 tmo) {
+      return tmo == INFINITE_TMO ? ~(U64)0 : now() + tmo;
+   }
+
+   /** Register 'w', or update it if already registered. */
+   void add(Wait* w) {
+      if(w->ix == ~(size_t)0)
+      {
+         w->ix = waits.size();
+         waits.push_back(w);
+      }
+   }
+
+   /** Unregister 'w' without completing it. */
+   void remove(Wait* w) {
+      if(w->ix != ~(size_t)0)
+      {
+         waits[w->ix] = waits.back();
+         waits[w->ix]->ix = w->ix;
+         waits.pop_back();
+         w->ix = ~(size_t)0;
+      }
+   }
+
+   /** Queue a suspended coroutine for resumption. */
+   void schedule(std::coroutine_handle<> h) { ready.push_back(h); }
+
+private:
+   friend struct SMQTaskPromiseBase;
+   std::deque<std::coroutine_handle<>> ready;
+   std::vector<Wait*> waits;
+   std::vector<struct pollfd> pfds;
+   std::vector<Wait*> pfdWaits;
+   std::vector<Wait*> fired;
+   U32 tasks = 0;
+   bool stopped = false;
+};
+
+
+/** An SMQ connection driven by an #SMQExecutor. The awaitable
+    functions must be awaited by coroutines run by the executor. Any
+    number of tasks can await create(), createsub(), and subscribe()
+    on the same connection, but only one task can await nextMessage().
+*/
+class SMQCo
+{
+public:
+   /** A message or an asynchronous event returned by nextMessage().
+    */
+   struct Message
+   {
+      /** The SMQ_getMessage return value: the message (fragment)
+          length, #SMQ_TIMEOUT, #SMQ_SUBCHANGE, or an error code.
+      */
+      int len;
+      U8* data; /**< Valid until the next nextMessage() */
+      U32 tid; /**< Topic ID */
+      U32 ptid; /**< Publisher's tid; the observed tid for SMQ_SUBCHANGE */
+      U32 subtid; /**< Sub-topic ID */
+      int status; /**< Number of subscribers for SMQ_SUBCHANGE */
+      U16 frameLen; /**< See SMQ_getMessage: receiving large frames */
+      U16 bytesRead;
+   };
+
+   /** Awaitable returned by create(), createsub(), and subscribe().
+       The result is the topic ID, which may use all 32 bits, -1 if
+       the broker denied the request, or an error code.
+   */
+   class Ack
+   {
+   public:
+      bool await_ready() { return false; }
+      bool await_suspend(std::coroutine_handle<> h);
+      S64 await_resume() { return result; }
+   private:
+      friend class SMQCo;
+      Ack(SMQCo* c, const char* t, int m) : co(c), topic(t), msg(m) {}
+      SMQCo* co;
+      const char* topic;
+      int msg; /* 0: create, 1: createsub, 2: subscribe */
+      S64 result = 0;
+      bool done = false;
+      bool suspended = false;
+      U64 deadline = 0;
+      std::coroutine_handle<> h;
+   };
+
+   /** Awaitable returned by nextMessage(). */
+   class MsgAwait
+   {
+   public:
+      bool await_ready();
+      bool await_suspend(std::coroutine_handle<> h);
+      Message await_resume() { return m; }
+   private:
+      friend class SMQCo;
+      explicit MsgAwait(SMQCo* c) : co(c) {}
+      SMQCo* co;
+      Message m{};
+      bool done = false;
+      bool suspended = false;
+      U64 deadline = 0;
+      std::coroutine_handle<> h;
+   };
+
+   /** Create an SMQ instance using 'buf' as the SMQ buffer.
+       \see SMQ_constructor
+   */
+   SMQCo(SMQExecutor& e, U8* buf, U16 bufLen) : smq(buf, bufLen), exec(e) {
+      rw.cb = onWait;
+      rw.user = this;
+   }
+   ~SMQCo() { exec.remove(&rw); }
+   SMQCo(const SMQCo&) = delete;
+   SMQCo& operator=(const SMQCo&) = delete;
+
+   /** Connect to the broker: SMQ_init followed by SMQ_connect
+       without blocking, including the DNS lookup when using the
+       resolver cache (SE_DNS_CACHE). The string arguments must be
+       valid until the returned task completes.
+       \returns 0 on success or an error code; see SMQ_connect.
+   */
+   SMQTask<int> connect(const char* url, const char* uid, int uidLen,
+                        const char* credentials=0, U8 credLen=0,
+                        const char* info=0, int infoLen=0, U32* rnd=0);
+
+   /** Create a topic and fetch the topic ID. \see SMQ_create */
+   Ack create(const char* topic) { return Ack(this, topic, 0); }
+
+   /** Create a sub-topic and fetch the sub-topic ID. \see SMQ_createsub */
+   Ack createsub(const char* subtopic) { return Ack(this, subtopic, 1); }
+
+   /** Subscribe to a topic and fetch the topic ID. \see SMQ_subscribe */
+   Ack subscribe(const char* topic) { return Ack(this, topic, 2); }
+
+   /** Wait at most SMQ::timeout milliseconds for the next message.
+       Returns #SMQ_TIMEOUT when the time elapses; the connection is
+       kept alive with PING messages as SMQ_getMessage does.
+   */
+   MsgAwait nextMessage() { return MsgAwait(this); }
+
+   /** \see SMQ_publish */
+   int publish(const void* data, int len, U32 tid, U32 subtid) {
+      return SMQ_publish(&smq, data, len, tid, subtid);
+   }
+   /** \see SMQ_unsubscribe */
+   int unsubscribe(U32 tid) { return SMQ_unsubscribe(&smq, tid); }
+   /** \see SMQ_observe */
+   int observe(U32 tid) { return SMQ_observe(&smq, tid); }
+   /** \see SMQ_unobserve */
+   int unobserve(U32 tid) { return SMQ_unobserve(&smq, tid); }
+   /** \see SMQ_disconnect */
+   void disconnect() { exec.remove(&rw); SMQ_disconnect(&smq); }
+
+   /** The SMQ instance; use for settings such as SMQ::timeout and
+       for SMQ::clientTid.
+   */
+   SMQ smq;
+
+private:
+   struct Queued
+   {
+      Message m;
+      std::vector<U8> data;
+   };
+
+   SMQTask<int> tcpConnect(const char* host, U16 port);
+   SMQTask<int> waitFrame(U32 tmo);
+   bool frameReady();
+   void setLowat(int len);
+   bool hasWaiters() const { return msgWaiter || !acks.empty(); }
+   void arm();
+   void pump();
+   void dispatch(int x, U8* msg);
+   void fail(int x);
+   void complete(Ack* a, S64 result);
+   void complete(MsgAwait* a);
+   static void onWait(SMQExecutor::Wait* w);
+
+   SMQExecutor& exec;
+   SMQExecutor::Wait rw; /* Read wait while tasks await frames */
+   std::deque<Ack*> acks; /* Pending acks in request order; NULL: timed out */
+   MsgAwait* msgWaiter = nullptr;
+   std::deque<Queued> queue; /* Messages received while awaiting acks */
+   std::vector<U8> current; /* Data for the last queued message returned */
+   U64 idleMark = 0; /* Time of the last frame or SMQ_idle call */
+   int failed = 0; /* Error code after a connection error */
+   int lowat = 1;
+};
+
+/** @} */ /* end group SMQCo */
+
+
+/** @cond */
+
+template<typename P> inline std::coroutine_handle<>
+SMQTaskPromiseBase::Final::await_suspend(std::coroutine_handle<P> h) noexcept
+{
+   SMQTaskPromiseBase& p = h.promise();
+   if(p.continuation)
+      return p.continuation;
+   if(p.owner)
+   {  /* Spawned task */
+      p.owner->tasks--;
+      h.destroy();
+   }
+   return std::noop_coroutine();
+}
+
+
+inline int
+SMQExecutor::run()
+{
+   stopped = false;
+   while(tasks && !stopped)
+   {
+      U64 next = ~(U64)0, t;
+      int tmo;
+      while( ! ready.empty() )
+      {
+         std::coroutine_handle<> h = ready.front();
+         ready.pop_front();
+         h.resume();
+      }
+      if( ! tasks || stopped )
+         break;
+      pfds.clear();
+      pfdWaits.clear();
+      for(Wait* w : waits)
+      {
+         if(w->deadline < next)
+            next = w->deadline;
+         if(w->fd >= 0)
+         {
+            struct pollfd p;
+            p.fd = w->fd;
+            p.events = w->events;
+            p.revents = 0;
+            pfds.push_back(p);
+            pfdWaits.push_back(w);
+         }
+      }
+      t = now();
+      tmo = next == ~(U64)0 ? -1 : next <= t ? 0 :
+         next - t > 0x7FFFFFFF ? 0x7FFFFFFF : (int)(next - t);
+      if(poll(pfds.data(), pfds.size(), tmo) < 0 && errno != EINTR)
+         return -1;
+      t = now();
+      fired.clear();
+      for(size_t i = 0 ; i < pfds.size() ; i++)
+      {
+         if(pfds[i].revents)
+         {
+            Wait* w = pfdWaits[i];
+            w->result = pfds[i].revents & (POLLERR|POLLNVAL) &&
+               !(pfds[i].revents & POLLIN) ? -1 : 1;
+            remove(w);
+            fired.push_back(w);
+         }
+      }
+      for(size_t i = 0 ; i < waits.size() ; )
+      {
+         Wait* w = waits[i];
+         if(w->deadline <= t)
+         {
+            w->result = 0;
+            remove(w);
+            fired.push_back(w);
+         }
+         else
+            i++;
+      }
+      for(Wait* w : fired)
+      {
+         if(w->cb)
+            w->cb(w);
+         else
+            ready.push_back(w->h);
+      }
+   }
+   return 0;
+}
+
+
+/* Resolve 'host' and connect to the first address that accepts the
+   connection. The socket is set to blocking mode when connected.
+*/
+inline SMQTask<int>
+SMQCo::tcpConnect(const char* host, U16 port)
+{
+   SeAddr addr[8];
+   int n, i;
+   U32 tmo = smq.sockOpt && smq.sockOpt->attemptTmo ?
+      smq.sockOpt->attemptTmo : 4000;
+#ifdef SE_DNS_CACHE
+   while((n = se_dnsResolve(host, addr, 8, FALSE)) == 0)
+   {
+      if(se_dnsFd() < 0 || co_await exec.io(se_dnsFd(), POLLIN, tmo) <= 0)
+         co_return -2;
+   }
+#else
+   {  /* getaddrinfo blocks; compile with SE_DNS_CACHE to avoid this */
+      struct addrinfo hints;
+      struct addrinfo* result = 0;
+      memset(&hints, 0, sizeof(hints));
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      if(getaddrinfo(host, 0, &hints, &result))
+         co_return -2;
+      n = se_copyAddrInfo(result, addr, 8);
+      freeaddrinfo(result);
+   }
+#endif
+   if(n <= 0)
+      co_return -2;
+   for(i = 0 ; i < n ; i++)
+   {
+      int fd = socket(addr[i].addr.ss_family, SOCK_STREAM, 0);
+      int nonBlock = 1, err = 0;
+      socklen_t len = sizeof(err);
+      if(fd < 0)
+         continue;
+      if(addr[i].addr.ss_family == AF_INET)
+         ((struct sockaddr_in*)&addr[i].addr)->sin_port = htons(port);
+      else
+         ((struct sockaddr_in6*)&addr[i].addr)->sin6_port = htons(port);
+      if(smq.sockOpt)
+         se_setSockOpt(&fd, smq.sockOpt);
+      ioctl(fd, FIONBIO, &nonBlock);
+      if(::connect(fd, (struct sockaddr*)&addr[i].addr, addr[i].len))
+      {
+         if(errno == EINPROGRESS)
+         {
+            int x = co_await exec.io(fd, POLLOUT, tmo);
+            if(x <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len))
+               err = -1;
+         }
+         else
+            err = -1;
+         if(err)
+         {
+            close(fd);
+            continue;
+         }
+      }
+      nonBlock = 0;
+      ioctl(fd, FIONBIO, &nonBlock);
+      smq.sock = fd;
+      rw.fd = fd;
+      lowat = 1;
+      co_return 0;
+   }
+   co_return -3;
+}
+
+
+/* True if a complete frame, or the rest of a frame returned in
+   fragments, is in the receive buffer. Also true on a socket error,
+   which the SMQ function then reports. Sets SO_RCVLOWAT so poll()
+   reports readable only when the missing data has arrived.
+   SMQ_getMessage reads the 3 byte frame header with a blocking read
+   once the first byte has arrived, so the whole header must be here
+   too, also for a malformed length below 3.
+*/
+inline bool
+SMQCo::frameReady()
+{
+   U8 hdr[3];
+   int avail, len;
+   ssize_t n;
+   if(smq.bytesRead && smq.bytesRead < smq.frameLen)
+      return true;
+   n = recv(smq.sock, hdr, 3, MSG_PEEK|MSG_DONTWAIT);
+   if(n <= 0)
+      return n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+   if(n < 3)
+   {
+      setLowat(3);
+      return false;
+   }
+   len = ((int)hdr[0] << 8) | hdr[1];
+   if(len < 3)
+      len = 3; /* SMQ_getMessage reports the error */
+   if(ioctl(smq.sock, FIONREAD, &avail) || avail >= len)
+   {
+      setLowat(1);
+      return true;
+   }
+   setLowat(len);
+   return false;
+}
+
+
+inline void
+SMQCo::setLowat(int len)
+{
+   if(len != lowat)
+   {
+      lowat = len;
+      setsockopt(smq.sock, SOL_SOCKET, SO_RCVLOWAT, &len, sizeof(len));
+   }
+}
+
+
+/* Used by connect: wait for a frame when no task awaits messages */
+inline SMQTask<int>
+SMQCo::waitFrame(U32 tmo)
+{
+   U64 end = SMQExecutor::deadline(tmo);
+   while( ! frameReady() )
+   {
+      U64 t = SMQExecutor::now();
+      int x;
+      if(t >= end)
+         co_return 0;
+      x = co_await exec.io(smq.sock, POLLIN,
+                           end == ~(U64)0 ? INFINITE_TMO : (U32)(end - t));
+      if(x < 0)
+         co_return 1; /* Let the SMQ function report the error */
+   }
+   co_return 1;
+}
+
+
+inline SMQTask<int>
+SMQCo::connect(const char* url, const char* uid, int uidLen,
+               const char* credentials, U8 credLen,
+               const char* info, int infoLen, U32* rnd)
+{
+   char host[256];
+   U16 port;
+   int x = SMQ_parseUrl(url, host, sizeof(host), &port);
+#ifdef SE_UNIX
+   if( ! x && ! strncmp("unix:", url, 5) )
+   {
+      /* A local connect completes or fails at once */
+      if( ! (x = se_connectUnix(&smq.sock, host)) )
+      {
+         rw.fd = smq.sock;
+         lowat = 1;
+      }
+   }
+   else
+#endif
+   if( ! x )
+      x = co_await tcpConnect(host, port);
+   if( ! x && ! (x = SMQ_initReq(&smq, url)) )
+   {
+      if( ! co_await waitFrame(smq.timeout) )
+         x = SMQ_TIMEOUT;
+      else if( ! (x = SMQ_initRsp(&smq, rnd)) &&
+               ! (x = SMQ_connectReq(&smq, uid, uidLen, credentials, credLen,
+                                     info, infoLen)) )
+      {
+         x = co_await waitFrame(smq.timeout) ?
+            SMQ_connectRsp(&smq) : SMQ_TIMEOUT;
+      }
+   }
+   failed = x;
+   idleMark = SMQExecutor::now();
+   co_return smq.status = x;
+}
+
+
+inline bool
+SMQCo::Ack::await_suspend(std::coroutine_handle<> hndl)
+{
+   if(co->failed)
+   {
+      result = co->failed;
+      return false;
+   }
+   result = msg == 0 ? SMQ_create(&co->smq, topic) :
+      msg == 1 ? SMQ_createsub(&co->smq, topic) :
+      SMQ_subscribe(&co->smq, topic);
+   if(result)
+      return false;
+   deadline = SMQExecutor::deadline(co->smq.timeout);
+   co->acks.push_back(this);
+   co->pump();
+   if(done)
+      return false;
+   h = hndl;
+   suspended = true;
+   co->arm();
+   return true;
+}
+
+
+inline bool
+SMQCo::MsgAwait::await_ready()
+{
+   if( ! co->queue.empty() )
+   {
+      Queued& q = co->queue.front();
+      co->current.swap(q.data);
+      m = q.m;
+      m.data = co->current.data();
+      co->queue.pop_front();
+      return true;
+   }
+   if(co->failed)
+   {
+      m.len = co->failed;
+      return true;
+   }
+   return false;
+}
+
+
+inline bool
+SMQCo::MsgAwait::await_suspend(std::coroutine_handle<> hndl)
+{
+   baAssert( ! co->msgWaiter );
+   deadline = SMQExecutor::deadline(co->smq.timeout);
+   co->msgWaiter = this;
+   co->pump();
+   if(done)
+      return false;
+   h = hndl;
+   suspended = true;
+   co->arm();
+   return true;
+}
+
+
+inline void
+SMQCo::complete(Ack* a, S64 result)
+{
+   a->result = result;
+   a->done = true;
+   if(a->suspended)
+      exec.schedule(a->h);
+}
+
+
+inline void
+SMQCo::complete(MsgAwait* a)
+{
+   msgWaiter = nullptr;
+   a->done = true;
+   if(a->suspended)
+      exec.schedule(a->h);
+}
+
+
+/* Register the read wait with the deadline of the oldest waiter */
+inline void
+SMQCo::arm()
+{
+   if(failed || ! hasWaiters())
+   {
+      exec.remove(&rw);
+      return;
+   }
+   rw.deadline = msgWaiter ? msgWaiter->deadline : ~(U64)0;
+   for(Ack* a : acks)
+   {
+      if(a)
+      {
+         if(a->deadline < rw.deadline)
+            rw.deadline = a->deadline;
+         break;
+      }
+   }
+   exec.add(&rw);
+}
+
+
+/* Read and dispatch frames while tasks are waiting for them */
+inline void
+SMQCo::pump()
+{
+   while( ! failed && hasWaiters() && frameReady() )
+   {
+      U8* msg = 0;
+      U32 tmo = smq.timeout;
+      int x;
+      smq.timeout = 0; /* PING/PONG: do not wait for the next frame */
+      x = SMQ_getMessage(&smq, &msg);
+      smq.timeout = tmo;
+      idleMark = SMQExecutor::now();
+      dispatch(x, msg);
+   }
+}
+
+
+inline void
+SMQCo::dispatch(int x, U8* msg)
+{
+   switch(x)
+   {
+      case SMQ_TIMEOUT: /* Consumed PING or PONG */
+         return;
+
+      case SMQ_CREATEACK:
+      case SMQ_CREATESUBACK:
+      case SMQ_SUBACK:
+         if(acks.empty())
+            return;
+         if(acks.front())
+            complete(acks.front(), smq.status ? -1 : (S64)smq.ptid);
+         acks.pop_front();
+         return;
+   }
+   if(x < 0 && x != SMQ_SUBCHANGE)
+   {
+      fail(x);
+      return;
+   }
+   Message m;
+   m.len = x;
+   m.data = x > 0 ? msg : 0;
+   m.tid = smq.tid;
+   m.ptid = smq.ptid;
+   m.subtid = smq.subtid;
+   m.status = smq.status;
+   m.frameLen = smq.frameLen;
+   m.bytesRead = smq.bytesRead;
+   if(msgWaiter)
+   {
+      msgWaiter->m = m;
+      complete(msgWaiter);
+   }
+   else
+   {  /* A task awaits an ack: keep a copy */
+      queue.emplace_back();
+      queue.back().m = m;
+      if(x > 0)
+         queue.back().data.assign(msg, msg + x);
+   }
+}
+
+
+inline void
+SMQCo::fail(int x)
+{
+   failed = x;
+   while( ! acks.empty() )
+   {
+      if(acks.front())
+         complete(acks.front(), x);
+      acks.pop_front();
+   }
+   if(msgWaiter)
+   {
+      msgWaiter->m.len = x;
+      complete(msgWaiter);
+   }
+   exec.remove(&rw);
+}
+
+
+inline void
+SMQCo::onWait(SMQExecutor::Wait* w)
+{
+   SMQCo* o = (SMQCo*)w->user;
+   U64 t;
+   o->pump();
+   t = SMQExecutor::now();
+   if(o->msgWaiter && o->msgWaiter->deadline <= t)
+   {
+      o->msgWaiter->m.len = SMQ_idle(&o->smq, (U32)(t - o->idleMark));
+      o->idleMark = t;
+      o->complete(o->msgWaiter);
+   }
+   for(Ack*& a : o->acks)
+   {
+      if(a && a->deadline <= t)
+      {
+         o->complete(a, SMQ_TIMEOUT);
+         a = nullptr; /* The late ack is discarded */
+      }
+   }
+   o->arm();
+}
+
+/** @endcond */
+
+#endif
@@ -0,0 +1,318 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Large object transfer over SMQ; see SMQLob.h.
+ */
+
+#include "SMQLob.h"
+
+#define LOB_BEGIN 1
+#define LOB_DATA  2
+#define LOB_END   3
+#define LOB_ACK   4
+#define LOB_ABORT 5
+
+/* Sender and receiver states */
+#define LOB_IDLE   0
+#define LOB_WAIT   1 /* Sender: BEGIN sent, waiting for start offset */
+#define LOB_XFER   2
+#define LOB_ENDING 3 /* Sender: END sent, waiting for final ACK */
+#define LOB_DONE   4
+#define LOB_FAILED 5
+
+
+static void
+SMQLob_putU32(U8* p, U32 v)
+{
+   p[0] = (U8)(v >> 24);
+   p[1] = (U8)(v >> 16);
+   p[2] = (U8)(v >> 8);
+   p[3] = (U8)v;
+}
+
+
+static U32
+SMQLob_getU32(const U8* p)
+{
+   return ((U32)p[0] << 24) | ((U32)p[1] << 16) | ((U32)p[2] << 8) | p[3];
+}
+
+
+static int
+SMQLob_sendCtrl(SMQ* smq, U8 type, U32 objId, U32 val, U32 tid, U32 subtid)
+{
+   U8 msg[SMQ_LOB_HDR_SIZE];
+   msg[0] = type;
+   SMQLob_putU32(msg+1, objId);
+   SMQLob_putU32(msg+5, val);
+   return SMQ_publish(smq, msg, SMQ_LOB_HDR_SIZE, tid, subtid);
+}
+
+
+void
+SMQLobSender_constructor(SMQLobSender* o, SMQ* smq, U8* buf,
+                         U16 bufLen, SMQLobRead read, void* ctx)
+{
+   memset(o, 0, sizeof(SMQLobSender));
+   o->smq = smq;
+   o->buf = buf;
+   o->bufLen = bufLen;
+   o->read = read;
+   o->ctx = ctx;
+}
+
+
+int
+SMQLobSender_start(SMQLobSender* o, U32 objId, U32 tid, U32 subtid,
+                   U32 window)
+{
+   o->objId = objId;
+   o->tid = tid;
+   o->subtid = subtid;
+   o->window = window ? window : 1;
+   o->offset = o->acked = 0;
+   o->error = 0;
+   o->state = LOB_WAIT;
+   return SMQLob_sendCtrl(o->smq, LOB_BEGIN, objId, o->window, tid, subtid);
+}
+
+
+int
+SMQLobSender_run(SMQLobSender* o)
+{
+   int chunk = o->bufLen - SMQ_LOB_HDR_SIZE;
+   if(chunk > SMQ_LOB_MAX_CHUNK)
+      chunk = SMQ_LOB_MAX_CHUNK;
+   while(o->state == LOB_XFER && o->offset - o->acked < o->window)
+   {
+      int x;
+      int len = o->read(o->ctx, o->offset, o->buf+SMQ_LOB_HDR_SIZE, chunk);
+      if(len < 0)
+      {
+         o->state = LOB_FAILED;
+         SMQLob_sendCtrl(o->smq, LOB_ABORT, o->objId, (U32)SMQE_LOB_IO,
+                         o->tid, o->subtid);
+         return SMQE_LOB_IO;
+      }
+      if(len == 0)
+      {
+         o->state = LOB_ENDING;
+         return SMQLob_sendCtrl(
+            o->smq, LOB_END, o->objId, o->offset, o->tid, o->subtid);
+      }
+      o->buf[0] = LOB_DATA;
+      SMQLob_putU32(o->buf+1, o->objId);
+      SMQLob_putU32(o->buf+5, o->offset);
+      x = SMQ_publish(o->smq, o->buf, len+SMQ_LOB_HDR_SIZE, o->tid, o->subtid);
+      if(x)
+         return x;
+      o->offset += (U32)len;
+   }
+   return 0;
+}
+
+
+int
+SMQLobSender_onMsg(SMQLobSender* o, const U8* msg, int len)
+{
+   U32 val;
+   if(len < SMQ_LOB_HDR_SIZE || SMQLob_getU32(msg+1) != o->objId ||
+      o->state == LOB_IDLE || o->state >= LOB_DONE)
+   {
+      return 0; /* Not for this transfer */
+   }
+   val = SMQLob_getU32(msg+5);
+   if(msg[0] == LOB_ABORT)
+   {
+      o->error = (S32)val;
+      o->state = LOB_FAILED;
+      return SMQE_LOB_ABORTED;
+   }
+   if(msg[0] != LOB_ACK)
+      return 0;
+   if(o->state == LOB_WAIT)
+   {  /* Response to BEGIN: the offset to start or resume from */
+      o->offset = o->acked = val;
+      o->state = LOB_XFER;
+   }
+   else if(val > o->acked && val <= o->offset)
+   {
+      o->acked = val;
+   }
+   if(o->state == LOB_ENDING && o->acked == o->offset)
+   {
+      o->state = LOB_DONE;
+      return SMQ_LOB_DONE;
+   }
+   return SMQLobSender_run(o);
+}
+
+
+void
+SMQLobReceiver_constructor(SMQLobReceiver* o, SMQ* smq,
+                           SMQLobWrite write, void* ctx)
+{
+   memset(o, 0, sizeof(SMQLobReceiver));
+   o->smq = smq;
+   o->write = write;
+   o->ctx = ctx;
+}
+
+
+static int
+SMQLobReceiver_ack(SMQLobReceiver* o)
+{
+   o->acked = o->offset;
+   return SMQLob_sendCtrl(o->smq, LOB_ACK, o->objId, o->offset,
+                          o->ptid, o->subtid);
+}
+
+
+static int
+SMQLobReceiver_abort(SMQLobReceiver* o, int error)
+{
+   o->error = error;
+   o->state = LOB_FAILED;
+   SMQLob_sendCtrl(o->smq, LOB_ABORT, o->objId, (U32)error,
+                   o->ptid, o->subtid);
+   return error;
+}
+
+
+static int
+SMQLobReceiver_store(SMQLobReceiver* o, const U8* data, int len)
+{
+   if(len > 0)
+   {
+      if(o->write(o->ctx, o->offset, data, len) < 0)
+         return SMQLobReceiver_abort(o, SMQE_LOB_IO);
+      o->offset += (U32)len;
+   }
+   if( ! o->dataLeft && o->offset - o->acked >= o->window / 2 )
+      return SMQLobReceiver_ack(o);
+   return 0;
+}
+
+
+int
+SMQLobReceiver_onMsg(SMQLobReceiver* o, const U8* msg, int len)
+{
+   SMQ* smq = o->smq;
+   U32 objId, val;
+   /* A continuation fragment of a chunk larger than SMQ::buf. Detected
+      from the frame position and not from dataLeft alone, which is
+      stale when the connection dropped in the middle of a frame.
+   */
+   if((U32)smq->bytesRead != (U32)len + 15)
+   {
+      if( ! o->dataLeft )
+         return 0;
+      o->dataLeft = (U32)(smq->frameLen - smq->bytesRead);
+      return o->state == LOB_XFER ? SMQLobReceiver_store(o, msg, len) : 0;
+   }
+   o->dataLeft = 0;
+   if(len < SMQ_LOB_HDR_SIZE)
+      return 0;
+   objId = SMQLob_getU32(msg+1);
+   val = SMQLob_getU32(msg+5);
+   switch(msg[0])
+   {
+      case LOB_BEGIN:
+         if(objId != o->objId || o->state == LOB_IDLE ||
+            o->state == LOB_FAILED)
+         {  /* New object; else resume from o->offset */
+            o->objId = objId;
+            o->offset = 0;
+            o->error = 0;
+         }
+         o->ptid = smq->ptid;
+         o->subtid = smq->subtid;
+         o->dataLeft = 0;
+         o->window = val;
+         o->state = LOB_XFER;
+         return SMQLobReceiver_ack(o);
+
+      case LOB_DATA:
+         if(objId != o->objId || o->state != LOB_XFER)
+            return 0;
+         if(val > o->offset)
+            return SMQLobReceiver_abort(o, SMQE_PROTOCOL_ERROR);
+         o->offset = val;
+         o->dataLeft = (U32)(smq->frameLen - smq->bytesRead);
+         return SMQLobReceiver_store(o, msg+SMQ_LOB_HDR_SIZE,
+                                     len-SMQ_LOB_HDR_SIZE);
+
+      case LOB_END:
+         if(objId != o->objId || o->state != LOB_XFER)
+            return 0;
+         if(val != o->offset)
+            return SMQLobReceiver_abort(o, SMQE_PROTOCOL_ERROR);
+         o->size = val;
+         o->state = LOB_DONE;
+         SMQLobReceiver_ack(o);
+         return SMQ_LOB_DONE;
+
+      case LOB_ABORT:
+         if(objId != o->objId)
+            return 0;
+         o->error = (S32)val;
+         o->state = LOB_FAILED;
+         return SMQE_LOB_ABORTED;
+   }
+   return 0;
+}
+
+
+int
+SMQLobMem_read(void* ctx, U32 offset, U8* buf, int len)
+{
+   SMQLobMem* o = (SMQLobMem*)ctx;
+   if(offset >= o->len)
+      return 0;
+   if((U32)len > o->len - offset)
+      len = (int)(o->len - offset);
+   memcpy(buf, o->buf + offset, len);
+   return len;
+}
+
+
+int
+SMQLobMem_write(void* ctx, U32 offset, const U8* data, int len)
+{
+   SMQLobMem* o = (SMQLobMem*)ctx;
+   if(offset > o->size || (U32)len > o->size - offset)
+      return -1;
+   memcpy(o->buf + offset, data, len);
+   if(offset + len > o->len)
+      o->len = offset + len;
+   return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+ */
+
+#ifndef __SMQLob_h
+#define __SMQLob_h
+
+#include "SMQ.h"
+
+/** @defgroup SMQLob Large Object Transfer
+    @ingroup SMQClient
+
+    Transfers objects of any size, such as firmware images and log
+    bundles, over an SMQ session. The object is split into sequenced
+    chunks, each published as one SMQ message to a topic and a
+    sub-topic reserved for the transfer. The receiver acknowledges the
+    bytes it has stored by publishing to the sender's ephemeral topic
+    ID, and the sender never has more than 'window' bytes
+    unacknowledged.
+
+    The sender reads the object through a #SMQLobRead callback, one
+    chunk at a time, and thus never holds the complete object in
+    memory. The receiver writes each chunk through a #SMQLobWrite
+    callback, for example to a file, or to a bounded memory buffer
+    using #SMQLobMem.
+
+    A transfer interrupted by a lost connection is resumed by calling
+    #SMQLobSender_start again after reconnecting. The receiver
+    responds with the number of bytes it has stored for the object ID
+    and the sender continues from that offset.
+
+    Both objects are event driven: the application calls
+    SMQ_getMessage and passes messages for the transfer's sub-topic to
+    SMQLobSender_onMsg or SMQLobReceiver_onMsg. Message fragments
+    (chunks larger than SMQ::buf) are passed in the same way.
+
+    Sender example:
+    \code
+    SMQLobSender_constructor(&lob, &smq, chunk, sizeof(chunk), fileRead, fp);
+    SMQLobSender_start(&lob, objId, tid, lobSubtid, 8*sizeof(chunk));
+    for(;;)
+    {
+       if(SMQLobSender_run(&lob) < 0) break;
+       len = SMQ_getMessage(&smq, &msg);
+       if(len >= 0 && smq.subtid == lobSubtid)
+       {
+          if(SMQLobSender_onMsg(&lob, msg, len) != 0) break;
+       }
+       else if(len < 0 && len != SMQ_TIMEOUT) ...
+    }
+    \endcode
+
+    Wire format, all integers in network byte order:
+    \li BEGIN: type(1) objId(4) window(4)
+    \li DATA: type(2) objId(4) offset(4) data
+    \li END: type(3) objId(4) size(4)
+    \li ACK: type(4) objId(4) offset(4)
+    \li ABORT: type(5) objId(4) error(4)
+@{
+*/
+
+/** Size of the header preceding the data in a chunk message */
+#define SMQ_LOB_HDR_SIZE 9
+
+/** Max chunk size: the payload limit minus the chunk header */
+#define SMQ_LOB_MAX_CHUNK (0xFFF0 - SMQ_LOB_HDR_SIZE)
+
+/** Returned by the onMsg functions when the transfer is complete */
+#define SMQ_LOB_DONE 1
+
+/** The peer aborted the transfer; the error is in SMQLobSender::error
+    or SMQLobReceiver::error.
+ */
+#define SMQE_LOB_ABORTED    -10010
+
+/** The SMQLobRead or SMQLobWrite callback failed. */
+#define SMQE_LOB_IO         -10011
+
+/** Read 'len' bytes at 'offset' into 'buf'.
+    \returns the number of bytes read, zero at end of object, or a
+    negative value on error.
+ */
+typedef int (*SMQLobRead)(void* ctx, U32 offset, U8* buf, int len);
+
+/** Store 'len' bytes at 'offset'. Chunks are delivered in order, but
+    a resumed transfer may rewrite the bytes after the last
+    acknowledged offset.
+    \returns zero on success or a negative value on error, which aborts
+    the transfer.
+ */
+typedef int (*SMQLobWrite)(void* ctx, U32 offset, const U8* data, int len);
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Large object sender */
+typedef struct
+{
+   SMQ* smq;
+   SMQLobRead read;
+   void* ctx;
+   U8* buf;
+   U32 objId;
+   U32 tid;
+   U32 subtid;
+   U32 window; /**< Unacknowledged bytes before the sender waits */
+   U32 offset; /**< Next byte to send */
+   U32 acked; /**< Bytes stored by the receiver */
+   S32 error; /**< Error code from an ABORT message */
+   U16 bufLen;
+   U8 state;
+} SMQLobSender;
+
+/** Create a sender.
+    \param o uninitialized data of size sizeof(SMQLobSender).
+    \param smq a connected SMQ instance.
+    \param buf chunk buffer; a chunk is bufLen - #SMQ_LOB_HDR_SIZE
+    bytes, but not more than #SMQ_LOB_MAX_CHUNK.
+    \param bufLen buffer length.
+    \param read reads the object.
+    \param ctx passed to 'read'.
+ */
+void SMQLobSender_constructor(SMQLobSender* o, SMQ* smq, U8* buf,
+                              U16 bufLen, SMQLobRead read, void* ctx);
+
+/** Start or resume a transfer by sending BEGIN. No data is sent until
+    the receiver has responded with the offset to start from.
+    \param o the sender.
+    \param objId identifies the object; use the same ID to resume.
+    \param tid the receiver's topic ID.
+    \param subtid the sub-topic reserved for transfers.
+    \param window the sender stops sending when 'window' or more bytes
+    are unacknowledged. The receiver acknowledges every window/2 bytes.
+ */
+int SMQLobSender_start(SMQLobSender* o, U32 objId, U32 tid, U32 subtid,
+                       U32 window);
+
+/** Send the chunks permitted by the window, and END at end of object.
+    \returns zero or an error code.
+ */
+int SMQLobSender_run(SMQLobSender* o);
+
+/** Process a message received on the transfer's sub-topic.
+    \returns #SMQ_LOB_DONE when the receiver has stored the complete
+    object, zero when more data is expected, or an error code.
+ */
+int SMQLobSender_onMsg(SMQLobSender* o, const U8* msg, int len);
+
+
+/** Large object receiver */
+typedef struct
+{
+   SMQ* smq;
+   SMQLobWrite write;
+   void* ctx;
+   U32 objId;
+   U32 ptid; /**< The sender's ephemeral topic ID */
+   U32 subtid;
+   U32 window;
+   U32 offset; /**< Bytes stored */
+   U32 acked; /**< Offset in the last ACK sent */
+   U32 size; /**< Object size, set when complete */
+   U32 dataLeft; /**< Data bytes left in the current fragmented chunk */
+   S32 error;
+   U8 state;
+} SMQLobReceiver;
+
+/** Create a receiver.
+    \param o uninitialized data of size sizeof(SMQLobReceiver).
+    \param smq a connected SMQ instance subscribed to the topic the
+    sender publishes to.
+    \param write stores the object.
+    \param ctx passed to 'write'.
+ */
+void SMQLobReceiver_constructor(SMQLobReceiver* o, SMQ* smq,
+                                SMQLobWrite write, void* ctx);
+
+/** Process a message or message fragment received on the transfer's
+    sub-topic.
+    \returns #SMQ_LOB_DONE when the complete object is stored
+    (SMQLobReceiver::size), zero when more data is expected, or an
+    error code.
+ */
+int SMQLobReceiver_onMsg(SMQLobReceiver* o, const U8* msg, int len);
+
+
+/** Bounded memory buffer for use as a #SMQLobRead or #SMQLobWrite
+    context. The receiver aborts the transfer when the object is
+    larger than the buffer.
+ */
+typedef struct
+{
+   U8* buf;
+   U32 size; /**< Buffer size */
+   U32 len; /**< Object length */
+} SMQLobMem;
+
+#define SMQLobMem_constructor(o, b, s) ((o)->buf=(b),(o)->size=(s),(o)->len=0)
+
+/** #SMQLobRead callback for a #SMQLobMem context */
+int SMQLobMem_read(void* ctx, U32 offset, U8* buf, int len);
+
+/** #SMQLobWrite callback for a #SMQLobMem context */
+int SMQLobMem_write(void* ctx, U32 offset, const U8* data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ /* end group SMQLob */
+
+#endif
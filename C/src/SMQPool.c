@@ -0,0 +1,210 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Session and buffer pool; see SMQPool.h.
+ */
+
+#include "SMQPool.h"
+
+#define SMQPool_round(x) (((x) + SMQ_POOL_ALIGN - 1) & ~(SMQ_POOL_ALIGN - 1))
+
+/* Size of an SMQ slot, rounded up to a whole number of cache lines */
+#define SMQ_SLOT_SIZE SMQPool_round(sizeof(SMQ))
+
+/* Each slab starts with a link to the next slab. The objects are
+   placed at the first aligned address after the link.
+ */
+typedef struct SMQSlab
+{
+   struct SMQSlab* next;
+} SMQSlab;
+
+
+static U8*
+SMQPool_newSlab(SMQPool* o, U32 size)
+{
+   SMQSlab* slab = (SMQSlab*)baMalloc(sizeof(SMQSlab) + SMQ_POOL_ALIGN + size);
+   if(!slab)
+   {
+      o->failed++;
+      return 0;
+   }
+   slab->next = (SMQSlab*)o->slabs;
+   o->slabs = slab;
+   return (U8*)SMQPool_round((size_t)(slab + 1));
+}
+
+
+static SMQPoolClass*
+SMQPool_getClass(SMQPool* o, U32 size)
+{
+   SMQPoolClass* c;
+   for(c = o->classes ; c < o->classes + SMQ_POOL_CLASSES ; c++)
+   {
+      if(size <= c->size)
+         return c;
+   }
+   return 0;
+}
+
+
+static U8*
+SMQPool_borrow(SMQBufIntf* super, U32 size, U32* outSize)
+{
+   SMQPool* o = (SMQPool*)super;
+   U8* buf = SMQPool_alloc(o, size, outSize);
+   if(buf)
+      o->borrowed++;
+   return buf;
+}
+
+
+static void
+SMQPool_giveBack(SMQBufIntf* super, U8* buf, U32 size)
+{
+   SMQPool_free((SMQPool*)super, buf, size);
+}
+
+
+void
+SMQPool_constructor(SMQPool* o, U16 smallBufLen)
+{
+   static const U32 sizes[SMQ_POOL_CLASSES] = SMQ_POOL_CLASS_SIZES;
+   int i;
+   memset(o, 0, sizeof(SMQPool));
+   o->super.borrow = SMQPool_borrow;
+   o->super.giveBack = SMQPool_giveBack;
+   for(i = 0 ; i < SMQ_POOL_CLASSES ; i++)
+      o->classes[i].size = sizes[i];
+   o->smallBufLen = smallBufLen;
+}
+
+
+void
+SMQPool_destructor(SMQPool* o)
+{
+   SMQSlab* slab = (SMQSlab*)o->slabs;
+   while(slab)
+   {
+      SMQSlab* next = slab->next;
+      baFree(slab);
+      slab = next;
+   }
+   o->slabs = 0;
+}
+
+
+U8*
+SMQPool_alloc(SMQPool* o, U32 size, U32* outSize)
+{
+   U8* buf;
+   SMQPoolClass* c = SMQPool_getClass(o, size);
+   if(!c)
+   {
+      o->failed++;
+      return 0;
+   }
+   if(!c->freeList)
+   {  /* Carve a new slab into buffers of this class */
+      U32 i, n = c->size < SMQ_POOL_SLAB ? SMQ_POOL_SLAB / c->size : 1;
+      U8* ptr = SMQPool_newSlab(o, n * c->size);
+      if(!ptr)
+         return 0;
+      for(i = 0 ; i < n ; i++, ptr += c->size)
+      {
+         *(U8**)ptr = c->freeList;
+         c->freeList = ptr;
+      }
+      c->total += n;
+   }
+   buf = c->freeList;
+   c->freeList = *(U8**)buf;
+   c->inUse++;
+   *outSize = c->size;
+   return buf;
+}
+
+
+void
+SMQPool_free(SMQPool* o, U8* buf, U32 size)
+{
+   SMQPoolClass* c = SMQPool_getClass(o, size);
+   baAssert(c && c->inUse);
+   *(U8**)buf = c->freeList;
+   c->freeList = buf;
+   c->inUse--;
+}
+
+
+SMQ*
+SMQPool_newSMQ(SMQPool* o)
+{
+   SMQ* smq;
+   U8* buf;
+   U32 size;
+   if(!o->freeSMQ)
+   {
+      int i;
+      U8* ptr = SMQPool_newSlab(o, SMQ_POOL_SMQ_PER_SLAB * SMQ_SLOT_SIZE);
+      if(!ptr)
+         return 0;
+      for(i = 0 ; i < SMQ_POOL_SMQ_PER_SLAB ; i++, ptr += SMQ_SLOT_SIZE)
+      {
+         *(void**)ptr = o->freeSMQ;
+         o->freeSMQ = ptr;
+      }
+      o->smqTotal += SMQ_POOL_SMQ_PER_SLAB;
+   }
+   if((buf = SMQPool_alloc(o, o->smallBufLen, &size)) == 0)
+      return 0;
+   smq = (SMQ*)o->freeSMQ;
+   o->freeSMQ = *(void**)smq;
+   o->smqInUse++;
+   SMQ_constructor(smq, buf, size > 0xFFFF ? 0xFFFF : (U16)size);
+   SMQ_setBufIntf(smq, &o->super);
+   return smq;
+}
+
+
+void
+SMQPool_deleteSMQ(SMQPool* o, SMQ* smq)
+{
+   SMQ_destructor(smq); /* Returns a borrowed buffer */
+#ifdef SMQ_ENABLE_SENDBUF
+   SMQPool_free(o, smq->buf, (U32)smq->bufLen * 2);
+#else
+   SMQPool_free(o, smq->buf, smq->bufLen);
+#endif
+   *(void**)smq = o->freeSMQ;
+   o->freeSMQ = smq;
+   o->smqInUse--;
+}
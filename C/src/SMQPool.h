@@ -0,0 +1,160 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+ */
+
+#ifndef __SMQPool_h
+#define __SMQPool_h
+
+#include "SMQ.h"
+
+/** @defgroup SMQPool Session and Buffer Pool
+    @ingroup SMQClient
+
+    Pooled allocation for processes running many SMQ sessions, such as
+    gateways. SMQ instances are taken from slabs of cache line aligned
+    structures, and buffers from size classed pools shared by all
+    sessions. Each session holds a small buffer while idle; a frame
+    larger than this buffer is received in a buffer borrowed from the
+    pool (see #SMQ_setBufIntf), which is returned when the application
+    calls SMQ_getMessage again.
+
+    Memory is obtained from baMalloc in slabs and is returned to the
+    system by SMQPool_destructor. The pool is not thread safe; use it
+    from the thread that drives the sessions or protect the calls.
+
+    \code
+    SMQPool pool;
+    SMQPool_constructor(&pool, 256);
+    for(i=0 ; i < nSessions ; i++)
+    {
+       smq[i] = SMQPool_newSMQ(&pool);
+       SMQ_init(smq[i], url, 0);
+       .
+    }
+    \endcode
+@{
+*/
+
+/** Alignment of SMQ structures and buffers */
+#ifndef SMQ_POOL_ALIGN
+#define SMQ_POOL_ALIGN 64
+#endif
+
+/** Bytes allocated per slab for small buffer classes */
+#ifndef SMQ_POOL_SLAB
+#define SMQ_POOL_SLAB (64*1024)
+#endif
+
+/** SMQ structures allocated per slab */
+#ifndef SMQ_POOL_SMQ_PER_SLAB
+#define SMQ_POOL_SMQ_PER_SLAB 32
+#endif
+
+/** Buffer size classes; the last class must hold the largest frame. */
+#ifndef SMQ_POOL_CLASS_SIZES
+#define SMQ_POOL_CLASS_SIZES \
+   {128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 0x10000}
+#endif
+#ifndef SMQ_POOL_CLASSES
+#define SMQ_POOL_CLASSES 10
+#endif
+
+/** A buffer size class */
+typedef struct
+{
+   U8* freeList;
+   U32 size; /**< Buffer size */
+   U32 inUse; /**< Buffers in use */
+   U32 total; /**< Buffers allocated */
+} SMQPoolClass;
+
+/** Session and buffer pool */
+typedef struct
+{
+   SMQBufIntf super; /* Inherits SMQBufIntf */
+   SMQPoolClass classes[SMQ_POOL_CLASSES];
+   void* slabs; /* All slabs, linked, for the destructor */
+   void* freeSMQ;
+   U32 smqInUse; /**< SMQ instances in use */
+   U32 smqTotal; /**< SMQ instances allocated */
+   U32 borrowed; /**< Frames received in a borrowed buffer */
+   U32 failed; /**< Allocations that failed */
+   U16 smallBufLen;
+} SMQPool;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create a pool.
+    \param o uninitialized data of size sizeof(SMQPool).
+    \param smallBufLen the buffer size for idle sessions, rounded up to
+    a size class. Must be large enough for the control frames, and not
+    less than 127 bytes; see #SMQ_constructor.
+ */
+void SMQPool_constructor(SMQPool* o, U16 smallBufLen);
+
+/** Release all memory. All sessions must be deleted first. */
+void SMQPool_destructor(SMQPool* o);
+
+/** Allocate and construct an SMQ instance with a small buffer and
+    the pool set as its buffer interface. Returns NULL if out of memory.
+ */
+SMQ* SMQPool_newSMQ(SMQPool* o);
+
+/** Destruct an SMQ instance created by SMQPool_newSMQ and return it
+    and its buffer to the pool.
+ */
+void SMQPool_deleteSMQ(SMQPool* o, SMQ* smq);
+
+/** Allocate a buffer of at least 'size' bytes from the size classes.
+    \param o the pool.
+    \param size requested size.
+    \param outSize set to the buffer size, which is the class size.
+    \returns the buffer or NULL.
+ */
+U8* SMQPool_alloc(SMQPool* o, U32 size, U32* outSize);
+
+/** Return a buffer to its size class.
+    \param o the pool.
+    \param buf buffer from SMQPool_alloc.
+    \param size the size requested or returned by SMQPool_alloc.
+ */
+void SMQPool_free(SMQPool* o, U8* buf, U32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ /* end group SMQPool */
+
+#endif
@@ -0,0 +1,311 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Pipelined request/response RPC over SMQ; see SMQRpc.h.
+ */
+
+#include "SMQRpc.h"
+
+#define RPC_REQUEST  1
+#define RPC_RESPONSE 2
+#define RPC_ERROR    3
+
+#define SMQ_RPC_FREE 0xFFFF /* SMQRpcCall::heapIx for a free slot */
+
+/* Deadline 'a' is before 'b'; handles wrap around of the ms counter */
+#define SMQRpc_before(a, b) ((S32)((a) - (b)) < 0)
+#define SMQRpc_heap(o, n) (o)->calls[(o)->calls[n].heapEnt]
+
+
+static void
+SMQRpc_putU32(U8* p, U32 v)
+{
+   p[0] = (U8)(v >> 24);
+   p[1] = (U8)(v >> 16);
+   p[2] = (U8)(v >> 8);
+   p[3] = (U8)v;
+}
+
+
+static U32
+SMQRpc_getU32(const U8* p)
+{
+   return ((U32)p[0] << 24) | ((U32)p[1] << 16) | ((U32)p[2] << 8) | p[3];
+}
+
+
+/* Store slot 'ix' at heap position 'pos' */
+static void
+SMQRpc_heapSet(SMQRpc* o, U16 pos, U16 ix)
+{
+   o->calls[pos].heapEnt = ix;
+   o->calls[ix].heapIx = pos;
+}
+
+
+static void
+SMQRpc_siftUp(SMQRpc* o, U16 pos)
+{
+   U16 ix = o->calls[pos].heapEnt;
+   while(pos > 0)
+   {
+      U16 parent = (U16)((pos - 1) / 2);
+      if( ! SMQRpc_before(o->calls[ix].deadline,
+                          SMQRpc_heap(o, parent).deadline) )
+      {
+         break;
+      }
+      SMQRpc_heapSet(o, pos, o->calls[parent].heapEnt);
+      pos = parent;
+   }
+   SMQRpc_heapSet(o, pos, ix);
+}
+
+
+static void
+SMQRpc_siftDown(SMQRpc* o, U16 pos)
+{
+   U16 ix = o->calls[pos].heapEnt;
+   for(;;)
+   {
+      U32 child = 2 * (U32)pos + 1;
+      if(child >= o->pending)
+         break;
+      if(child + 1 < o->pending &&
+         SMQRpc_before(SMQRpc_heap(o, child + 1).deadline,
+                       SMQRpc_heap(o, child).deadline))
+      {
+         child++;
+      }
+      if( ! SMQRpc_before(SMQRpc_heap(o, child).deadline,
+                          o->calls[ix].deadline) )
+      {
+         break;
+      }
+      SMQRpc_heapSet(o, pos, o->calls[child].heapEnt);
+      pos = (U16)child;
+   }
+   SMQRpc_heapSet(o, pos, ix);
+}
+
+
+/* Remove slot 'ix' from the heap, return it to the free list, and
+   call its 'done' callback. The slot is free before the callback
+   runs, thus the callback can start a new call.
+ */
+static void
+SMQRpc_complete(SMQRpc* o, U16 ix, int status, const U8* data, int len)
+{
+   SMQRpcCall* c = o->calls + ix;
+   SMQRpcDone done = c->done;
+   void* ctx = c->ctx;
+   U16 pos = c->heapIx;
+   U16 last = --o->pending;
+   if(pos != last)
+   {
+      SMQRpc_heapSet(o, pos, o->calls[last].heapEnt);
+      if(pos > 0 && SMQRpc_before(SMQRpc_heap(o, pos).deadline,
+                                  SMQRpc_heap(o, (pos - 1) / 2).deadline))
+      {
+         SMQRpc_siftUp(o, pos);
+      }
+      else
+         SMQRpc_siftDown(o, pos);
+   }
+   c->heapIx = SMQ_RPC_FREE;
+   c->next = o->freeList;
+   o->freeList = ix;
+   done(ctx, status, data, len);
+}
+
+
+void
+SMQRpc_constructor(SMQRpc* o, SMQ* smq, SMQRpcCall* calls, U16 nCalls)
+{
+   U16 i;
+   memset(o, 0, sizeof(SMQRpc));
+   o->smq = smq;
+   o->calls = calls;
+   o->nCalls = nCalls;
+   for(i = 0 ; i < nCalls ; i++)
+   {
+      calls[i].heapIx = SMQ_RPC_FREE;
+      calls[i].gen = 0;
+      calls[i].next = (U16)(i + 1);
+   }
+   o->freeList = nCalls ? 0 : SMQ_RPC_FREE;
+   if(nCalls)
+      calls[nCalls - 1].next = SMQ_RPC_FREE;
+}
+
+
+void
+SMQRpc_cancelAll(SMQRpc* o)
+{
+   while(o->pending)
+      SMQRpc_complete(o, o->calls[0].heapEnt, SMQE_RPC_CANCELLED, 0, 0);
+}
+
+
+int
+SMQRpc_call(SMQRpc* o, U32 tid, U32 subtid, const void* args, int len,
+            U32 now, U32 tmo, SMQRpcDone done, void* ctx)
+{
+   U8 hdr[SMQ_RPC_HDR_SIZE];
+   SeIoVec iov[2];
+   SMQRpcCall* c;
+   U16 ix = o->freeList;
+   int x;
+   if(ix == SMQ_RPC_FREE)
+      return SMQE_RPC_BUSY;
+   c = o->calls + ix;
+   c->gen++;
+   hdr[0] = RPC_REQUEST;
+   SMQRpc_putU32(hdr+1, ((U32)c->gen << 16) | ix);
+   iov[0].data = hdr;
+   iov[0].len = SMQ_RPC_HDR_SIZE;
+   iov[1].data = args;
+   iov[1].len = (U32)len;
+   if((x = SMQ_publishv(o->smq, iov, 2, tid, subtid)) != 0)
+      return x;
+   o->freeList = c->next;
+   c->done = done;
+   c->ctx = ctx;
+   c->deadline = now + tmo;
+   o->calls[o->pending].heapEnt = ix;
+   SMQRpc_siftUp(o, o->pending++);
+   return 0;
+}
+
+
+int
+SMQRpc_onMsg(SMQRpc* o, const U8* msg, int len)
+{
+   SMQ* smq = o->smq;
+   U32 id;
+   U16 ix;
+   /* A continuation fragment of a message larger than SMQ::buf */
+   if((U32)smq->bytesRead != (U32)len + 15)
+   {
+      if( ! o->skip )
+         return 0;
+      if(smq->bytesRead == smq->frameLen)
+         o->skip = FALSE;
+      return 1;
+   }
+   if(len < SMQ_RPC_HDR_SIZE || msg[0] < RPC_REQUEST || msg[0] > RPC_ERROR)
+      return 0;
+   id = SMQRpc_getU32(msg+1);
+   if(smq->bytesRead < smq->frameLen)
+      o->skip = TRUE; /* Oversized: handled below, the rest is skipped */
+   if(msg[0] == RPC_REQUEST)
+   {
+      SMQRpcReq req;
+      if(o->handler && ! o->skip)
+      {
+         req.ptid = smq->ptid;
+         req.subtid = smq->subtid;
+         req.id = id;
+         o->handler(o->hctx, o, &req, msg + SMQ_RPC_HDR_SIZE,
+                    len - SMQ_RPC_HDR_SIZE);
+      }
+      return 1;
+   }
+   ix = (U16)id;
+   if(ix >= o->nCalls || o->calls[ix].heapIx == SMQ_RPC_FREE ||
+      o->calls[ix].gen != (U16)(id >> 16))
+   {
+      o->stale++;
+      return 1;
+   }
+   if(o->skip)
+      SMQRpc_complete(o, ix, SMQE_BUF_OVERFLOW, 0, 0);
+   else if(msg[0] == RPC_ERROR)
+   {
+      SMQRpc_complete(o, ix, len >= SMQ_RPC_HDR_SIZE + 4 ?
+                      (int)(S32)SMQRpc_getU32(msg + SMQ_RPC_HDR_SIZE) :
+                      SMQE_PROTOCOL_ERROR, 0, 0);
+   }
+   else
+   {
+      SMQRpc_complete(o, ix, 0, msg + SMQ_RPC_HDR_SIZE,
+                      len - SMQ_RPC_HDR_SIZE);
+   }
+   return 1;
+}
+
+
+U32
+SMQRpc_run(SMQRpc* o, U32 now)
+{
+   while(o->pending)
+   {
+      SMQRpcCall* c = &SMQRpc_heap(o, 0);
+      if(SMQRpc_before(now, c->deadline))
+         return c->deadline - now;
+      o->timeouts++;
+      SMQRpc_complete(o, o->calls[0].heapEnt, SMQE_RPC_TIMEOUT, 0, 0);
+   }
+   return INFINITE_TMO;
+}
+
+
+static int
+SMQRpc_send(SMQRpc* o, const SMQRpcReq* req, U8 type, const void* data,
+            int len)
+{
+   U8 hdr[SMQ_RPC_HDR_SIZE];
+   SeIoVec iov[2];
+   hdr[0] = type;
+   SMQRpc_putU32(hdr+1, req->id);
+   iov[0].data = hdr;
+   iov[0].len = SMQ_RPC_HDR_SIZE;
+   iov[1].data = data;
+   iov[1].len = (U32)len;
+   return SMQ_publishv(o->smq, iov, 2, req->ptid, req->subtid);
+}
+
+
+int
+SMQRpc_reply(SMQRpc* o, const SMQRpcReq* req, const void* data, int len)
+{
+   return SMQRpc_send(o, req, RPC_RESPONSE, data, len);
+}
+
+
+int
+SMQRpc_replyError(SMQRpc* o, const SMQRpcReq* req, S32 error)
+{
+   U8 err[4];
+   SMQRpc_putU32(err, (U32)error);
+   return SMQRpc_send(o, req, RPC_ERROR, err, 4);
+}
@@ -0,0 +1,242 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+ */
+
+#ifndef __SMQRpc_h
+#define __SMQRpc_h
+
+#include "SMQ.h"
+
+/** @defgroup SMQRpc Request/Response RPC
+    @ingroup SMQClient
+
+    Pipelined request/response calls over SMQ. A request is published
+    to the server's ephemeral topic ID, or to a topic the server
+    subscribes to, and the sub-topic selects the method. The server
+    publishes the response to the caller's ephemeral topic ID (the
+    request's ptid) with the same sub-topic.
+
+    Each request carries a correlation ID, and any number of calls, up
+    to the number of call slots given to the constructor, can be in
+    flight. The correlation ID contains the call's slot index, thus
+    a response is matched to its call without a search, and a
+    generation count, which detects a response arriving after the
+    call has timed out. Call deadlines are kept in a binary heap
+    ordered by expiry time.
+
+    The object is event driven: the application calls
+    SMQ_getMessage, passes messages for the RPC sub-topics to
+    SMQRpc_onMsg, and calls SMQRpc_run, which expires calls past their
+    deadline and returns the time until the next deadline.
+
+    \code
+    SMQRpc_constructor(&rpc, &smq, calls, 64);
+    SMQRpc_call(&rpc, serverTid, addSubtid, args, len, now(), 2000,
+                addDone, 0);
+    for(;;)
+    {
+       tmo = SMQRpc_run(&rpc, now());
+       smq.timeout = tmo < (U32)smq.pingTmo ? tmo : (U32)smq.pingTmo;
+       len = SMQ_getMessage(&smq, &msg);
+       if(len >= 0 && smq.subtid == addSubtid)
+          SMQRpc_onMsg(&rpc, msg, len);
+       ...
+    }
+    \endcode
+
+    Wire format; the header precedes the arguments or the result, and
+    all integers are in network byte order:
+    \li REQUEST: type(1) id(4) arguments
+    \li RESPONSE: type(2) id(4) result
+    \li ERROR: type(3) id(4) error(4)
+@{
+*/
+
+/** Size of the header preceding the arguments and the result */
+#define SMQ_RPC_HDR_SIZE 5
+
+/** The call did not complete before its deadline */
+#define SMQE_RPC_TIMEOUT    -10020
+
+/** All call slots are in use */
+#define SMQE_RPC_BUSY       -10021
+
+/** The call was cancelled by SMQRpc_cancelAll */
+#define SMQE_RPC_CANCELLED  -10022
+
+struct SMQRpc;
+
+/** Called when a call completes.
+    \param ctx the 'ctx' argument passed to SMQRpc_call.
+    \param status zero when the server responded, the error code sent
+    by the server with SMQRpc_replyError, #SMQE_RPC_TIMEOUT,
+    #SMQE_RPC_CANCELLED, or #SMQE_BUF_OVERFLOW if the response did
+    not fit in SMQ::buf.
+    \param data the result when status is zero, otherwise NULL.
+    \param len the result length.
+ */
+typedef void (*SMQRpcDone)(void* ctx, int status, const U8* data, int len);
+
+/** The caller of a request received by a server. Copy the structure
+    to respond after the handler has returned.
+ */
+typedef struct
+{
+   U32 ptid; /**< The caller's ephemeral topic ID */
+   U32 subtid; /**< The method */
+   U32 id; /**< The correlation ID */
+} SMQRpcReq;
+
+/** Called by SMQRpc_onMsg for each request. The handler responds with
+    SMQRpc_reply or SMQRpc_replyError, now or later.
+ */
+typedef void (*SMQRpcHandler)(void* ctx, struct SMQRpc* rpc,
+                              const SMQRpcReq* req, const U8* args, int len);
+
+/** A call slot. The application provides an array of slots; the
+    fields are private.
+ */
+typedef struct
+{
+   SMQRpcDone done;
+   void* ctx;
+   U32 deadline;
+   U16 gen; /* Upper 16 bits of the correlation ID */
+   U16 heapIx; /* Position in the deadline heap or SMQ_RPC_FREE */
+   U16 next; /* Next free slot */
+   U16 heapEnt; /* Entry 'n' of the deadline heap is in slot n */
+} SMQRpcCall;
+
+/** Request/response RPC instance */
+typedef struct SMQRpc
+{
+   SMQ* smq;
+   SMQRpcCall* calls;
+   SMQRpcHandler handler;
+   void* hctx;
+   U32 timeouts; /**< Calls expired by SMQRpc_run */
+   U32 stale; /**< Responses received after the call had expired */
+   U16 nCalls;
+   U16 pending; /**< Calls in flight; also the heap size */
+   U16 freeList;
+   U8 skip; /* Skipping the fragments of an oversized message */
+} SMQRpc;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create an RPC instance.
+    \param o uninitialized data of size sizeof(SMQRpc).
+    \param smq a connected SMQ instance.
+    \param calls one slot for each call that can be in flight.
+    \param nCalls number of slots, at most 0xFFFE.
+ */
+void SMQRpc_constructor(SMQRpc* o, SMQ* smq, SMQRpcCall* calls, U16 nCalls);
+
+/** Complete all calls in flight with #SMQE_RPC_CANCELLED, for
+    example when the connection is lost. Also used as destructor.
+ */
+void SMQRpc_cancelAll(SMQRpc* o);
+#define SMQRpc_destructor(o) SMQRpc_cancelAll(o)
+
+/** Set the handler called for requests, making this instance a server.
+    A server also sends requests, thus a client and a server can
+    share one instance.
+ */
+#define SMQRpc_setHandler(o, h, ctx) ((o)->handler=(h), (o)->hctx=(ctx))
+
+/** Send a request.
+    \param o the RPC instance.
+    \param tid the server's ephemeral topic ID or a topic the server
+    subscribes to.
+    \param subtid the method.
+    \param args the arguments.
+    \param len arguments length; the request, including the
+    #SMQ_RPC_HDR_SIZE byte header, must fit in the server's SMQ::buf.
+    \param now the current time in milliseconds; any free running
+    millisecond counter, as long as all calls use the same one.
+    \param tmo the deadline relative to 'now'.
+    \param done called when the call completes, but not when this
+    function returns an error.
+    \param ctx passed to 'done'.
+    \returns zero, #SMQE_RPC_BUSY, or a socket error code.
+ */
+int SMQRpc_call(SMQRpc* o, U32 tid, U32 subtid, const void* args, int len,
+                U32 now, U32 tmo, SMQRpcDone done, void* ctx);
+
+/** Process a message received on an RPC sub-topic: a request if the
+    instance has a handler or a response to a call in flight. Message
+    fragments are passed in the same way, but a message larger than
+    SMQ::buf is not supported: a call receiving such a response
+    completes with #SMQE_BUF_OVERFLOW and such a request is dropped.
+    Call this function directly after SMQ_getMessage since the
+    SMQ::ptid, SMQ::subtid, and fragment state of the SMQ instance
+    belong to the message.
+    \returns 1 if the message was an RPC message and 0 if not.
+ */
+int SMQRpc_onMsg(SMQRpc* o, const U8* msg, int len);
+
+/** Expire the calls past their deadline.
+    \param o the RPC instance.
+    \param now the current time in milliseconds.
+    \returns the number of milliseconds until the next deadline or
+    #INFINITE_TMO if no calls are in flight. Use the value, or a
+    shorter time, as SMQ::timeout, but not more than SMQ::pingTmo:
+    SMQ_getMessage sends the keepalive PING only when it times out,
+    thus #INFINITE_TMO disables the PING.
+ */
+U32 SMQRpc_run(SMQRpc* o, U32 now);
+
+/** Send a response.
+    \param o the RPC instance.
+    \param req the request, as passed to the handler.
+    \param data the result.
+    \param len result length.
+ */
+int SMQRpc_reply(SMQRpc* o, const SMQRpcReq* req, const void* data, int len);
+
+/** Send an error response. The caller's 'done' callback receives
+    'error' as the status.
+    \param o the RPC instance.
+    \param req the request, as passed to the handler.
+    \param error a negative application error code.
+ */
+int SMQRpc_replyError(SMQRpc* o, const SMQRpcReq* req, S32 error);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ /* end group SMQRpc */
+
+#endif
@@ -46,6 +46,11 @@ https://realtimelogic.com/ba/doc/en/C/shark/group__BareMetal.html
 */
 
 #include "selib.h"
+#include "SeCtx.h"
+
+#ifdef SECTX_SWITCH
+#error SECTX_SWITCH is set: compile SeCtxSwitch.c instead of SeCtx.c
+#endif
 
 
 #ifdef DYNAMIC_SE_CTX
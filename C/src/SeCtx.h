@@ -33,7 +33,12 @@
  *
  */
 
+#ifndef _SeCtx_h
+#define _SeCtx_h
+
+#ifndef SE_CTX
 #define SE_CTX
+#endif
 
 
 /** @defgroup SeCtx Context Manager
@@ -57,13 +62,72 @@
 
 
 #include <setjmp.h>
+#ifndef HOST_PLATFORM
 #include <TargConfig.h>
+#endif
 
 struct SeCtx;
 
 /** The task/thread entry point */
 typedef void (*SeCtxTask)(struct SeCtx* ctx);
 
+#ifdef SECTX_SWITCH
+
+/* Stack switching implementation in SeCtxSwitch.c: the task runs on
+   its own stack and a context switch swaps stack pointers instead of
+   copying the stack. Uses a small assembler switch on ARMv7-M/ARMv8-M
+   Mainline (Cortex-M3/M4/M7/M33) and on x86-64 and AArch64 ELF hosts,
+   and ucontext elsewhere.
+ */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+   defined(__ARM_ARCH_8M_MAIN__) || \
+   (defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__)))
+#define SECTX_ASM
+#else
+#include <ucontext.h>
+#endif
+
+typedef struct SeCtx
+{
+#ifdef SECTX_ASM
+   void* taskSp;
+   void* mainSp;
+#else
+   ucontext_t taskCtx;
+   ucontext_t mainCtx;
+#endif
+   SeCtxTask task;
+   void* stackBuf;
+   U32 stackBufLen;
+   U32 timeout;
+   U32 startTime;
+   U8 hasContext;
+   U8 ready;
+   U8 done;
+#ifdef SECTX_EX
+   SECTX_EX;
+#endif
+} SeCtx;
+
+/** Create a Context Manager instance.
+    \param o uninitialized data of size sizeof(SeCtx).
+    \param t the task/thread to call
+    \param buf the task's stack. Unlike the copying implementation,
+    the buffer must hold the task's complete stack, including the
+    stack used by the TCP/IP porting layer.
+    \param bufLen buffer length.
+ */
+void SeCtx_constructor(SeCtx* o, SeCtxTask t, void* buf, int bufLen);
+#define SeCtx_destructor(o)
+
+/** Start the task on its own stack. Returns when the task calls
+    SeCtx_save or when the task returns.
+    \returns -1 if the task returned and zero if it is waiting.
+ */
+int SeCtx_start(SeCtx* o);
+
+#else /* SECTX_SWITCH */
+
 /** SeCtx structure: See [Context Manager](@ref SeCtx) and
     [Bare Metal Systems](@ref BareMetal) for details.
  */
@@ -114,6 +178,8 @@ void SeCtx_constructor(SeCtx* o, SeCtxTask t, void* buf, int bufLen);
 #define SeCtx_destructor(o)
 #endif
 
+#endif /* SECTX_SWITCH */
+
 void SeCtx_save(SeCtx* o); 
 
 void SeCtx_restore(SeCtx* o);
@@ -124,3 +190,5 @@ void SeCtx_restore(SeCtx* o);
 void SeCtx_panic(SeCtx* o, U32 size);
 
 /** @} */ /* end group SeCtx */
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Stack switching SeCtx implementation; compile this file instead of
+  SeCtx.c with the macro SECTX_SWITCH.
+
+  SeCtx.c saves the blocked task by copying the stack region between
+  SeCtx_run and SeCtx_save to SeCtx::stackBuf, and copies it back when
+  the task resumes, thus the cost of a context switch grows with the
+  stack depth. This implementation runs the task on its own stack,
+  SeCtx::stackBuf, and a context switch only saves the callee saved
+  registers and swaps the stack pointer. Use examples/ctxbench.c to
+  compare the two on a host.
+
+  The TCP/IP porting layer calls SeCtx_start instead of
+  SeCtx_setStackTop when the task is not running. See SeCtx_run in
+  lwIP-raw/seLwIP.c and Harmony/seHarmony.c.
+ */
+
+#include "selib.h"
+#include "SeCtx.h"
+
+#ifndef SECTX_SWITCH
+#error SECTX_SWITCH not defined: compile SeCtx.c
+#endif
+
+#if defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_BASE__)
+#error Cortex-M0/M0+/M23 not supported: use SeCtx.c
+#endif
+
+/* The context being started; read by SeCtx_entry */
+static SeCtx* SeCtx_cur;
+
+
+void
+SeCtx_constructor(SeCtx* o, SeCtxTask t, void* buf, int bufLen)
+{
+   memset(o, 0, sizeof(SeCtx));
+   o->task=t;
+   o->stackBuf = buf;
+   o->stackBufLen = (U32)bufLen;
+}
+
+
+#ifdef SECTX_ASM
+
+/* SeCtx_switch(saveSp, loadSp): save the callee saved registers and
+   the return address on the current stack, store SP in *saveSp, load
+   SP from 'loadSp', and return into the context saved on that stack.
+   SeCtx_start builds the initial frame, which returns into
+   SeCtx_entry.
+ */
+#if defined(__x86_64__) || defined(__aarch64__)
+__attribute__((visibility("hidden"))) void
+SeCtx_switch(void** saveSp, void* loadSp);
+#endif
+
+#if defined(__x86_64__)
+
+/* rbp, rbx, r12-r15, return address */
+#define SECTX_FRAME_WORDS 7
+#define SECTX_FRAME_ENTRY 6
+
+__asm__(
+   ".text\n"
+   ".globl SeCtx_switch\n"
+   ".hidden SeCtx_switch\n"
+   ".type SeCtx_switch, @function\n"
+   "SeCtx_switch:\n"
+   "push %rbp\n"
+   "push %rbx\n"
+   "push %r12\n"
+   "push %r13\n"
+   "push %r14\n"
+   "push %r15\n"
+   "mov %rsp, (%rdi)\n"
+   "mov %rsi, %rsp\n"
+   "pop %r15\n"
+   "pop %r14\n"
+   "pop %r13\n"
+   "pop %r12\n"
+   "pop %rbx\n"
+   "pop %rbp\n"
+   "ret\n"
+   ".size SeCtx_switch, .-SeCtx_switch\n");
+
+#elif defined(__aarch64__)
+
+/* x19-x28, x29, x30 (lr), d8-d15 */
+#define SECTX_FRAME_WORDS 20
+#define SECTX_FRAME_ENTRY 11
+
+__asm__(
+   ".text\n"
+   ".globl SeCtx_switch\n"
+   ".hidden SeCtx_switch\n"
+   ".type SeCtx_switch, %function\n"
+   "SeCtx_switch:\n"
+   "sub sp, sp, #160\n"
+   "stp x19, x20, [sp, #0]\n"
+   "stp x21, x22, [sp, #16]\n"
+   "stp x23, x24, [sp, #32]\n"
+   "stp x25, x26, [sp, #48]\n"
+   "stp x27, x28, [sp, #64]\n"
+   "stp x29, x30, [sp, #80]\n"
+   "stp d8, d9, [sp, #96]\n"
+   "stp d10, d11, [sp, #112]\n"
+   "stp d12, d13, [sp, #128]\n"
+   "stp d14, d15, [sp, #144]\n"
+   "mov x2, sp\n"
+   "str x2, [x0]\n"
+   "mov sp, x1\n"
+   "ldp x19, x20, [sp, #0]\n"
+   "ldp x21, x22, [sp, #16]\n"
+   "ldp x23, x24, [sp, #32]\n"
+   "ldp x25, x26, [sp, #48]\n"
+   "ldp x27, x28, [sp, #64]\n"
+   "ldp x29, x30, [sp, #80]\n"
+   "ldp d8, d9, [sp, #96]\n"
+   "ldp d10, d11, [sp, #112]\n"
+   "ldp d12, d13, [sp, #128]\n"
+   "ldp d14, d15, [sp, #144]\n"
+   "add sp, sp, #160\n"
+   "ret\n"
+   ".size SeCtx_switch, .-SeCtx_switch\n");
+
+#else /* Cortex-M */
+
+#if defined(__VFP_FP__) && !defined(__SOFTFP__)
+#define SECTX_FPU_WORDS 16 /* s16-s31 */
+#else
+#define SECTX_FPU_WORDS 0
+#endif
+
+/* r4-r11, lr, and s16-s31 when using the FPU */
+#define SECTX_FRAME_WORDS (9 + SECTX_FPU_WORDS)
+#define SECTX_FRAME_ENTRY 8
+
+__attribute__((naked, noinline)) static void
+SeCtx_switch(void** saveSp, void* loadSp)
+{
+   __asm volatile(
+#if SECTX_FPU_WORDS
+      "vpush {s16-s31}\n"
+#endif
+      "push {r4-r11, lr}\n"
+      "str sp, [r0]\n"
+      "mov sp, r1\n"
+      "pop {r4-r11, lr}\n"
+#if SECTX_FPU_WORDS
+      "vpop {s16-s31}\n"
+#endif
+      "bx lr\n");
+}
+
+#endif
+
+static void
+SeCtx_entry(void)
+{
+   SeCtx* o = SeCtx_cur;
+   o->task(o);
+   o->hasContext = FALSE;
+   o->done = TRUE;
+   SeCtx_switch(&o->taskSp, o->mainSp); /* Does not return */
+}
+
+
+int
+SeCtx_start(SeCtx* o)
+{
+   /* Initial frame popped by SeCtx_switch: zeroed registers and the
+      return address SeCtx_entry. The stack is aligned to 16 bytes
+      as the ABIs require at a call, and x86-64 has a return address
+      slot below SeCtx_entry's frame.
+   */
+   size_t* sp = (size_t*)
+      (((size_t)o->stackBuf + o->stackBufLen) & ~(size_t)15);
+#if defined(__x86_64__)
+   sp--;
+   *sp = 0;
+#endif
+   sp -= SECTX_FRAME_WORDS;
+   memset(sp, 0, SECTX_FRAME_WORDS * sizeof(size_t));
+   sp[SECTX_FRAME_ENTRY] = (size_t)SeCtx_entry;
+   o->taskSp = sp;
+   o->done = FALSE;
+   SeCtx_cur = o;
+   SeCtx_switch(&o->mainSp, o->taskSp);
+   return o->done ? -1 : 0;
+}
+
+
+void
+SeCtx_save(SeCtx* o)
+{
+   baAssert( ! o->hasContext );
+   baAssert(o->ready == FALSE);
+   o->hasContext = TRUE;
+   SeCtx_switch(&o->taskSp, o->mainSp);
+}
+
+
+void
+SeCtx_restore(SeCtx* o)
+{
+   baAssert(o->hasContext);
+   o->hasContext = FALSE;
+   o->ready = FALSE;
+   SeCtx_switch(&o->mainSp, o->taskSp);
+}
+
+#else /* ucontext */
+
+static void
+SeCtx_entry(void)
+{
+   SeCtx* o = SeCtx_cur;
+   o->task(o);
+   o->hasContext = FALSE;
+   o->done = TRUE;
+   /* Returns to SeCtx::mainCtx via uc_link */
+}
+
+
+int
+SeCtx_start(SeCtx* o)
+{
+   getcontext(&o->taskCtx);
+   o->taskCtx.uc_stack.ss_sp = o->stackBuf;
+   o->taskCtx.uc_stack.ss_size = o->stackBufLen;
+   o->taskCtx.uc_link = &o->mainCtx;
+   makecontext(&o->taskCtx, SeCtx_entry, 0);
+   o->done = FALSE;
+   SeCtx_cur = o;
+   swapcontext(&o->mainCtx, &o->taskCtx);
+   return o->done ? -1 : 0;
+}
+
+
+void
+SeCtx_save(SeCtx* o)
+{
+   baAssert( ! o->hasContext );
+   baAssert(o->ready == FALSE);
+   o->hasContext = TRUE;
+   swapcontext(&o->taskCtx, &o->mainCtx);
+}
+
+
+void
+SeCtx_restore(SeCtx* o)
+{
+   baAssert(o->hasContext);
+   o->hasContext = FALSE;
+   o->ready = FALSE;
+   swapcontext(&o->mainCtx, &o->taskCtx);
+}
+
+#endif
@@ -251,6 +251,14 @@ SeCtx_run(SeCtx* ctx)
          }
       }
    }
+#ifdef SECTX_SWITCH
+   else
+   {
+      (void)stackMark;
+      ctx->state = SELIB_INVALID;
+      return SeCtx_start(ctx); /* Run task on its own stack */
+   }
+#else
    else if( ! SeCtx_setStackTop(ctx, &stackMark) )
    {
       ctx->state = SELIB_INVALID;
@@ -258,5 +266,6 @@ SeCtx_run(SeCtx* ctx)
       baAssert( ! ctx->hasContext );
       return -1;
    }
+#endif
    return 0;
 }
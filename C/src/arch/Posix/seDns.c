@@ -0,0 +1,349 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Resolver cache for se_connect; see seDns.h.
+
+  Names are resolved by one background thread. An entry is either
+  free, queued, being resolved, or done. Callers waiting for the same
+  name wait on the same entry; only completed entries are evicted.
+ */
+
+#include "../../selib.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
+
+#ifndef SE_DNS_CACHE
+#error SE_DNS_CACHE not defined -> Using incorrect selibplat.h
+#endif
+
+#define SEDNS_FREE   0
+#define SEDNS_QUEUED 1
+#define SEDNS_BUSY   2
+#define SEDNS_DONE   3
+
+typedef struct
+{
+   char name[256];
+   SeAddr addrs[SE_DNS_ADDRS];
+   U32 expires; /* Monotonic time in seconds */
+   U32 used; /* For LRU eviction */
+   S16 n; /* Number of addresses or -2 */
+   U8 state;
+} SeDnsEntry;
+
+static struct
+{
+   pthread_mutex_t mutex;
+   pthread_cond_t work; /* Signaled when an entry is queued */
+   pthread_cond_t done; /* Broadcast when an entry is resolved */
+   int pipe[2]; /* Completion notification, see se_dnsFd */
+   U32 ttl;
+   U32 negTtl;
+   U32 tick;
+   BaBool running;
+   SeDnsEntry entries[SE_DNS_ENTRIES];
+} dns = {
+   PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+   PTHREAD_COND_INITIALIZER, {-1,-1}, SE_DNS_TTL, SE_DNS_NEG_TTL
+};
+
+SeDnsStats se_dnsStats;
+
+
+static U32
+dns_now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U32)ts.tv_sec;
+}
+
+
+static U32
+dns_msTime(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U32)ts.tv_sec * 1000 + (U32)(ts.tv_nsec / 1000000);
+}
+
+
+/* Resolve the entry's name. Called without the mutex; the entry is
+   in state SEDNS_BUSY and cannot be evicted.
+*/
+static void
+dns_lookup(SeDnsEntry* e)
+{
+   struct addrinfo hints;
+   struct addrinfo* result = 0;
+   SeAddr addrs[SE_DNS_ADDRS];
+   U32 latency = dns_msTime();
+   int n = 0;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if( ! getaddrinfo(e->name, 0, &hints, &result) )
+   {
+      n = se_copyAddrInfo(result, addrs, SE_DNS_ADDRS);
+      freeaddrinfo(result);
+   }
+   latency = dns_msTime() - latency;
+   pthread_mutex_lock(&dns.mutex);
+   se_dnsStats.queries++;
+   se_dnsStats.latencyLast = latency;
+   se_dnsStats.latencyTotal += latency;
+   if(latency > se_dnsStats.latencyMax)
+      se_dnsStats.latencyMax = latency;
+   if(n)
+   {
+      memcpy(e->addrs, addrs, n * sizeof(SeAddr));
+      e->n = (S16)n;
+      e->expires = dns_now() + dns.ttl;
+   }
+   else
+   {
+      se_dnsStats.failures++;
+      e->n = -2;
+      e->expires = dns_now() + dns.negTtl;
+   }
+   e->state = SEDNS_DONE;
+   pthread_cond_broadcast(&dns.done);
+   if(dns.pipe[1] >= 0)
+   {
+      U8 c = 0;
+      if(write(dns.pipe[1], &c, 1) < 0) {} /* Full pipe: already readable */
+   }
+   pthread_mutex_unlock(&dns.mutex);
+}
+
+
+static void*
+dns_thread(void* arg)
+{
+   (void)arg;
+   pthread_mutex_lock(&dns.mutex);
+   for(;;)
+   {
+      SeDnsEntry* e;
+      for(e = dns.entries ; e < dns.entries + SE_DNS_ENTRIES ; e++)
+      {
+         if(e->state == SEDNS_QUEUED)
+            break;
+      }
+      if(e == dns.entries + SE_DNS_ENTRIES)
+      {
+         pthread_cond_wait(&dns.work, &dns.mutex);
+         continue;
+      }
+      e->state = SEDNS_BUSY;
+      pthread_mutex_unlock(&dns.mutex);
+      dns_lookup(e);
+      pthread_mutex_lock(&dns.mutex);
+   }
+   return 0;
+}
+
+
+/* Queue the entry for the resolver thread. Returns FALSE if the
+   thread cannot be started; the caller must then resolve the entry.
+   Called with the mutex locked.
+*/
+static BaBool
+dns_queue(SeDnsEntry* e)
+{
+   if( ! dns.running )
+   {
+      pthread_t t;
+      pthread_attr_t attr;
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      dns.running = pthread_create(&t, &attr, dns_thread, 0) == 0;
+      pthread_attr_destroy(&attr);
+      if( ! dns.running )
+      {
+         e->state = SEDNS_BUSY;
+         return FALSE;
+      }
+   }
+   e->state = SEDNS_QUEUED;
+   pthread_cond_signal(&dns.work);
+   return TRUE;
+}
+
+
+/* Find the entry for 'host' or take the least recently used completed
+   entry. Returns NULL if all entries are in use. Called with the mutex
+   locked.
+*/
+static SeDnsEntry*
+dns_find(const char* host, BaBool* found)
+{
+   SeDnsEntry* e;
+   SeDnsEntry* lru = 0;
+   for(e = dns.entries ; e < dns.entries + SE_DNS_ENTRIES ; e++)
+   {
+      if(e->state == SEDNS_FREE)
+      {
+         if( ! lru || lru->state != SEDNS_FREE )
+            lru = e;
+      }
+      else if( ! strcmp(e->name, host) )
+      {
+         *found = TRUE;
+         return e;
+      }
+      else if(e->state == SEDNS_DONE &&
+              (! lru || (lru->state == SEDNS_DONE && e->used < lru->used)))
+      {
+         lru = e;
+      }
+   }
+   *found = FALSE;
+   if(lru)
+   {
+      strcpy(lru->name, host);
+      lru->state = SEDNS_FREE;
+   }
+   return lru;
+}
+
+
+int
+se_dnsResolve(const char* host, SeAddr* addrs, int max, BaBool wait)
+{
+   BaBool joined = FALSE;
+   int n;
+   if(strlen(host) >= sizeof(dns.entries[0].name))
+      return -2;
+   pthread_mutex_lock(&dns.mutex);
+   if(dns.pipe[0] >= 0)
+   {
+      U8 buf[32];
+      while(read(dns.pipe[0], buf, sizeof(buf)) > 0) ;
+   }
+   for(;;)
+   {
+      BaBool found;
+      SeDnsEntry* e = dns_find(host, &found);
+      if(e)
+      {
+         if(e->state == SEDNS_DONE)
+         {
+            if((S32)(e->expires - dns_now()) > 0)
+            {
+               if(e->n > 0)
+               {
+                  if( ! joined )
+                     se_dnsStats.hits++;
+                  n = e->n < max ? e->n : max;
+                  memcpy(addrs, e->addrs, n * sizeof(SeAddr));
+               }
+               else
+               {
+                  if( ! joined )
+                     se_dnsStats.negHits++;
+                  n = -2;
+               }
+               e->used = ++dns.tick;
+               break;
+            }
+            found = FALSE; /* Expired */
+         }
+         if( ! found )
+         {
+            if( ! dns_queue(e) )
+            {
+               pthread_mutex_unlock(&dns.mutex);
+               dns_lookup(e); /* No thread: resolve in the caller */
+               pthread_mutex_lock(&dns.mutex);
+               joined = TRUE;
+               continue;
+            }
+         }
+         else if( ! joined )
+         {
+            se_dnsStats.waits++;
+            joined = TRUE;
+         }
+      }
+      if( ! wait )
+      {
+         n = 0;
+         break;
+      }
+      joined = TRUE;
+      pthread_cond_wait(&dns.done, &dns.mutex);
+   }
+   pthread_mutex_unlock(&dns.mutex);
+   return n;
+}
+
+
+int
+se_dnsFd(void)
+{
+   pthread_mutex_lock(&dns.mutex);
+   if(dns.pipe[0] < 0 && pipe(dns.pipe) == 0)
+   {
+      fcntl(dns.pipe[0], F_SETFL, O_NONBLOCK);
+      fcntl(dns.pipe[1], F_SETFL, O_NONBLOCK);
+      fcntl(dns.pipe[0], F_SETFD, FD_CLOEXEC);
+      fcntl(dns.pipe[1], F_SETFD, FD_CLOEXEC);
+   }
+   pthread_mutex_unlock(&dns.mutex);
+   return dns.pipe[0];
+}
+
+
+void
+se_dnsSetTtl(U32 ttl, U32 negTtl)
+{
+   pthread_mutex_lock(&dns.mutex);
+   dns.ttl = ttl;
+   dns.negTtl = negTtl;
+   pthread_mutex_unlock(&dns.mutex);
+}
+
+
+void
+se_dnsFlush(void)
+{
+   SeDnsEntry* e;
+   pthread_mutex_lock(&dns.mutex);
+   for(e = dns.entries ; e < dns.entries + SE_DNS_ENTRIES ; e++)
+   {
+      if(e->state == SEDNS_DONE)
+         e->state = SEDNS_FREE;
+   }
+   pthread_mutex_unlock(&dns.mutex);
+}
@@ -0,0 +1,122 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  Resolver cache with TTL, negative caching, and non-blocking lookups.
+
+  Enabled by compiling selib.c and seDns.c with the macro SE_DNS_CACHE
+  (make DNSCACHE=1). se_connect and se_connectEx then resolve through
+  the cache, and concurrent lookups for the same name share one
+  resolver call, so a reconnect storm after a broker restart results
+  in one DNS query and not one per session.
+ */
+
+#ifndef _seDns_h
+#define _seDns_h
+
+#include <netdb.h>
+
+/* Number of cached names */
+#ifndef SE_DNS_ENTRIES
+#define SE_DNS_ENTRIES 32
+#endif
+
+/* Max addresses cached per name */
+#ifndef SE_DNS_ADDRS
+#define SE_DNS_ADDRS 8
+#endif
+
+/* Seconds a resolved name is cached. getaddrinfo does not return the
+ * record's TTL, thus a fixed TTL is used; see se_dnsSetTtl.
+ */
+#ifndef SE_DNS_TTL
+#define SE_DNS_TTL 60
+#endif
+
+/* Seconds a failed lookup is cached (negative caching) */
+#ifndef SE_DNS_NEG_TTL
+#define SE_DNS_NEG_TTL 5
+#endif
+
+typedef struct
+{
+   U32 hits; /* Lookups answered from the cache */
+   U32 negHits; /* Lookups answered by a cached failure */
+   U32 waits; /* Lookups that joined a lookup in progress */
+   U32 queries; /* Resolver (getaddrinfo) calls */
+   U32 failures; /* Resolver calls that failed */
+   U32 latencyLast; /* Resolver latency in milliseconds */
+   U32 latencyMax;
+   U32 latencyTotal; /* Divide by 'queries' for the average */
+} SeDnsStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern SeDnsStats se_dnsStats;
+
+/** Resolve 'host' using the cache.
+
+    Lookups run in a background thread. With 'wait' set to TRUE, the
+    function waits for the lookup to complete. With 'wait' set to
+    FALSE, the function never blocks: it returns zero if the name is
+    not in the cache and starts the lookup in the background. Call
+    the function again when the descriptor returned by se_dnsFd is
+    readable; se_connect does not block on DNS when the name is
+    cached.
+
+    \param host the name or numeric address to resolve.
+    \param addrs receives up to 'max' addresses with the address
+    families interleaved as recommended by RFC 8305.
+    \returns the number of addresses, zero if the lookup is in
+    progress (wait=FALSE), or -2 if the name cannot be resolved.
+*/
+int se_dnsResolve(const char* host, SeAddr* addrs, int max, BaBool wait);
+
+/** Returns a descriptor that is readable when a background lookup
+    has completed. Add it to your select/poll set when using
+    se_dnsResolve with wait=FALSE. The descriptor is drained by
+    se_dnsResolve. Returns -1 on error.
+*/
+int se_dnsFd(void);
+
+/** Set the positive and negative TTL in seconds. */
+void se_dnsSetTtl(U32 ttl, U32 negTtl);
+
+/** Remove all completed entries from the cache. */
+void se_dnsFlush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
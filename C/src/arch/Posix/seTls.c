@@ -0,0 +1,590 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  OpenSSL backend for se_send, se_recv, and se_close.
+
+  A socket becomes a TLS socket when se_tlsConnect completes the
+  handshake; all other sockets use the plain socket functions. The
+  TLS state is kept in a table indexed by the socket descriptor.
+
+  Sessions are cached per host and port so that reconnecting to a
+  broker resumes the session (an abbreviated handshake without the
+  certificate exchange and the key exchange signatures). With TLS 1.3
+  the session tickets arrive after the handshake and are stored by
+  the new session callback when SMQ reads the first message.
+
+  With OpenSSL 3 on Linux, kernel TLS is requested for each
+  connection. When the kernel accepts the send offload, se_send and
+  se_sendv write directly to the socket, thus se_sendv keeps sending
+  all regions with one sendmsg call. Receiving always goes through
+  SSL_read, which also handles the non application records.
+
+  The functions are thread safe; the table and the session cache are
+  protected by one mutex, which is not held while calling OpenSSL I/O
+  functions.
+ */
+
+#include "../../selib.h"
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef SE_TLS
+#error SE_TLS not defined -> Using incorrect selibplat.h
+#endif
+
+/* Host names this long or longer are not cached */
+#define SE_TLS_HOST_MAX 64
+
+/* Max plaintext size of a TLS record */
+#define SE_TLS_RECORD 16384
+
+
+typedef struct
+{
+   SSL* ssl;
+   U16 port;
+   BaBool ktlsSend; /* Kernel encrypts sent records */
+   BaBool resumed;
+   char host[1]; /* Allocated with the host name */
+} SeTlsConn;
+
+
+typedef struct
+{
+   SSL_SESSION* sess; /* NULL if the entry is free */
+   U32 lastUsed;
+   U16 port;
+   char host[SE_TLS_HOST_MAX];
+} SeTlsSession;
+
+
+typedef struct
+{
+   pthread_mutex_t lock;
+   SSL_CTX* ctx;
+   SeTlsConn** conns; /* Indexed by socket descriptor */
+   int nConns;
+   U32 tick; /* Session LRU clock */
+   BaBool noCache;
+   BaBool noVerify;
+   SeTlsSession sessions[SE_TLS_SESSIONS];
+} SeTls;
+
+static SeTls tls = { PTHREAD_MUTEX_INITIALIZER };
+
+SeTlsStats se_tlsStats;
+
+
+static U32
+seTls_msTime(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U32)ts.tv_sec * 1000 + (U32)(ts.tv_nsec / 1000000);
+}
+
+
+/* Wait 'tmo' ms for 'events'. Returns 0 when ready and -1 otherwise. */
+static int
+seTls_wait(int fd, short events, U32 tmo)
+{
+   struct pollfd pfd;
+   pfd.fd = fd;
+   pfd.events = events;
+   return poll(&pfd, 1, tmo > 0x7FFFFFFF ? 0x7FFFFFFF : (int)tmo) > 0 ? 0:-1;
+}
+
+
+/* Find the cached session for host:port. If 'victim' is set and the
+   session is not cached, returns a free or the least recently used
+   entry. Called with the lock held.
+*/
+static SeTlsSession*
+seTls_find(const char* host, U16 port, BaBool victim)
+{
+   SeTlsSession* lru = tls.sessions;
+   int i;
+   for(i = 0 ; i < SE_TLS_SESSIONS ; i++)
+   {
+      SeTlsSession* e = tls.sessions + i;
+      if(e->sess && e->port == port && !strcmp(e->host, host))
+         return e;
+      if(!e->sess)
+         lru = e;
+      else if(lru->sess && (S32)(e->lastUsed - lru->lastUsed) < 0)
+         lru = e;
+   }
+   return victim ? lru : 0;
+}
+
+
+static void
+seTls_flushSessions(void)
+{
+   int i;
+   for(i = 0 ; i < SE_TLS_SESSIONS ; i++)
+   {
+      if(tls.sessions[i].sess)
+      {
+         SSL_SESSION_free(tls.sessions[i].sess);
+         tls.sessions[i].sess = 0;
+      }
+   }
+}
+
+
+/* OpenSSL's new session callback: cache the session for the
+   connection's host and port. Returns 1 when the session is kept.
+*/
+static int
+seTls_newSession(SSL* ssl, SSL_SESSION* sess)
+{
+   SeTlsConn* c = (SeTlsConn*)SSL_get_app_data(ssl);
+   SeTlsSession* e;
+   if(!c || strlen(c->host) >= SE_TLS_HOST_MAX ||
+      !SSL_SESSION_is_resumable(sess))
+   {
+      return 0;
+   }
+   pthread_mutex_lock(&tls.lock);
+   if(tls.noCache)
+   {
+      pthread_mutex_unlock(&tls.lock);
+      return 0;
+   }
+   e = seTls_find(c->host, c->port, TRUE);
+   if(e->sess)
+      SSL_SESSION_free(e->sess);
+   e->sess = sess;
+   e->port = c->port;
+   strcpy(e->host, c->host);
+   e->lastUsed = ++tls.tick;
+   pthread_mutex_unlock(&tls.lock);
+   return 1;
+}
+
+
+/* Create the context on first use. Called with the lock held. */
+static SSL_CTX*
+seTls_ctx(void)
+{
+   if(!tls.ctx)
+   {
+      SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+      if(!ctx)
+         return 0;
+      SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+#ifdef SSL_OP_ENABLE_KTLS
+      SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+      /* SSL_read returns after a non application record so that
+         se_recv can honor its timeout.
+      */
+      SSL_CTX_clear_mode(ctx, SSL_MODE_AUTO_RETRY);
+      SSL_CTX_set_session_cache_mode(
+         ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(ctx, seTls_newSession);
+      SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, 0);
+      SSL_CTX_set_default_verify_paths(ctx);
+      tls.ctx = ctx;
+   }
+   return tls.ctx;
+}
+
+
+/* Add or remove (c=NULL) the connection for 'fd'. Called with the
+   lock held. Returns 0 or -1 if out of memory.
+*/
+static int
+seTls_setConn(int fd, SeTlsConn* c)
+{
+   if(fd >= tls.nConns)
+   {
+      int n = tls.nConns ? tls.nConns * 2 : 64;
+      SeTlsConn** conns;
+      if(!c)
+         return 0;
+      if(n <= fd)
+         n = fd + 1;
+      conns = (SeTlsConn**)baRealloc(tls.conns, n * sizeof(SeTlsConn*));
+      if(!conns)
+         return -1;
+      memset(conns + tls.nConns, 0, (n - tls.nConns) * sizeof(SeTlsConn*));
+      tls.conns = conns;
+      tls.nConns = n;
+   }
+   tls.conns[fd] = c;
+   return 0;
+}
+
+
+static SeTlsConn*
+seTls_conn(int fd)
+{
+   SeTlsConn* c = 0;
+   pthread_mutex_lock(&tls.lock);
+   if(fd >= 0 && fd < tls.nConns)
+      c = tls.conns[fd];
+   pthread_mutex_unlock(&tls.lock);
+   return c;
+}
+
+
+static void
+SeTlsConn_free(SeTlsConn* c)
+{
+   if(c->ssl)
+      SSL_free(c->ssl);
+   baFree(c);
+}
+
+
+/* Complete the handshake within SE_TLS_HANDSHAKE_TMO. */
+static int
+seTls_handshake(SSL* ssl, int fd)
+{
+   U32 start = seTls_msTime();
+   int x, nonBlock = 1;
+   ioctl(fd, FIONBIO, &nonBlock);
+   while((x = SSL_connect(ssl)) != 1)
+   {
+      U32 elapsed = seTls_msTime() - start;
+      int err = SSL_get_error(ssl, x);
+      if((err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) ||
+         elapsed >= SE_TLS_HANDSHAKE_TMO ||
+         seTls_wait(fd, err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT,
+                    SE_TLS_HANDSHAKE_TMO - elapsed))
+      {
+         break;
+      }
+   }
+   nonBlock = 0;
+   ioctl(fd, FIONBIO, &nonBlock);
+   return x == 1 ? 0 : -1;
+}
+
+
+int
+se_tlsInit(const char* caFile, BaBool verify)
+{
+   SSL_CTX* ctx;
+   int ret = 0;
+   pthread_mutex_lock(&tls.lock);
+   ctx = seTls_ctx();
+   if(!ctx)
+      ret = -1;
+   else
+   {
+      if(caFile)
+      {
+         SSL_CTX_set_cert_store(ctx, X509_STORE_new());
+         if(SSL_CTX_load_verify_locations(ctx, caFile, 0) != 1)
+            ret = -1;
+      }
+      SSL_CTX_set_verify(ctx, verify ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, 0);
+      tls.noVerify = !verify;
+   }
+   pthread_mutex_unlock(&tls.lock);
+   return ret;
+}
+
+
+void
+se_tlsClose(void)
+{
+   pthread_mutex_lock(&tls.lock);
+   seTls_flushSessions();
+   if(tls.ctx)
+   {
+      SSL_CTX_free(tls.ctx);
+      tls.ctx = 0;
+   }
+   pthread_mutex_unlock(&tls.lock);
+}
+
+
+void
+se_tlsSessionCache(BaBool enable)
+{
+   pthread_mutex_lock(&tls.lock);
+   tls.noCache = !enable;
+   if(!enable)
+      seTls_flushSessions();
+   pthread_mutex_unlock(&tls.lock);
+}
+
+
+int
+se_tlsConnect(int* sock, const char* host, U16 port)
+{
+   size_t hostLen = strlen(host);
+   SeTlsConn* c = (SeTlsConn*)baMalloc(sizeof(SeTlsConn) + hostLen);
+   SSL_SESSION* sess = 0;
+   SSL_CTX* ctx;
+   BaBool noVerify;
+   U8 addr[16];
+   int err, one = 1;
+   if(!c)
+      return -4;
+   memset(c, 0, sizeof(SeTlsConn));
+   c->port = port;
+   memcpy(c->host, host, hostLen + 1);
+   pthread_mutex_lock(&tls.lock);
+   ctx = seTls_ctx();
+   if(ctx && (c->ssl = SSL_new(ctx)) != 0 && !tls.noCache)
+   {
+      SeTlsSession* e = seTls_find(host, port, FALSE);
+      if(e)
+      {
+         sess = e->sess;
+         SSL_SESSION_up_ref(sess);
+         e->lastUsed = ++tls.tick;
+      }
+   }
+   noVerify = tls.noVerify;
+   if(!c->ssl || seTls_setConn(*sock, c))
+   {
+      pthread_mutex_unlock(&tls.lock);
+      if(sess)
+         SSL_SESSION_free(sess);
+      SeTlsConn_free(c);
+      return -4;
+   }
+   pthread_mutex_unlock(&tls.lock);
+   SSL_set_app_data(c->ssl, c);
+   SSL_set_fd(c->ssl, *sock);
+   /* OpenSSL writes complete records and flights; with Nagle, a
+      flight followed by application data, as in a resumed TLS 1.2
+      handshake, waits for the peer's delayed ACK.
+   */
+   setsockopt(*sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+   if(inet_pton(AF_INET, host, addr) == 1 || inet_pton(AF_INET6, host, addr) == 1)
+   {
+      if(!noVerify)
+         X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(c->ssl), host);
+   }
+   else
+   {
+      SSL_set_tlsext_host_name(c->ssl, host); /* SNI */
+      if(!noVerify)
+         SSL_set1_host(c->ssl, host);
+   }
+   if(sess)
+   {
+      SSL_set_session(c->ssl, sess);
+      SSL_SESSION_free(sess);
+   }
+   if(seTls_handshake(c->ssl, *sock))
+   {
+      err = SSL_get_verify_result(c->ssl) != X509_V_OK ? -5 : -4;
+      ERR_clear_error();
+      pthread_mutex_lock(&tls.lock);
+      seTls_setConn(*sock, 0);
+      se_tlsStats.failed++;
+      pthread_mutex_unlock(&tls.lock);
+      SeTlsConn_free(c);
+      return err;
+   }
+   c->resumed = SSL_session_reused(c->ssl) ? TRUE : FALSE;
+#ifndef OPENSSL_NO_KTLS
+#ifdef BIO_get_ktls_send
+   c->ktlsSend = BIO_get_ktls_send(SSL_get_wbio(c->ssl)) ? TRUE : FALSE;
+#endif
+#endif
+   pthread_mutex_lock(&tls.lock);
+   se_tlsStats.handshakes++;
+   if(c->resumed)
+      se_tlsStats.resumed++;
+   if(c->ktlsSend)
+      se_tlsStats.ktlsSend++;
+#if !defined(OPENSSL_NO_KTLS) && defined(BIO_get_ktls_recv)
+   if(BIO_get_ktls_recv(SSL_get_rbio(c->ssl)))
+      se_tlsStats.ktlsRecv++;
+#endif
+   pthread_mutex_unlock(&tls.lock);
+   return 0;
+}
+
+
+BaBool
+se_tlsResumed(int* sock)
+{
+   SeTlsConn* c = seTls_conn(*sock);
+   return c ? c->resumed : FALSE;
+}
+
+
+BaBool
+se_tlsKtls(int* sock)
+{
+   SeTlsConn* c = seTls_conn(*sock);
+   return c ? c->ktlsSend : FALSE;
+}
+
+
+void
+se_close(int* sock)
+{
+   SeTlsConn* c = 0;
+   if(*sock < 0)
+      return;
+   pthread_mutex_lock(&tls.lock);
+   if(*sock < tls.nConns)
+   {
+      c = tls.conns[*sock];
+      tls.conns[*sock] = 0;
+   }
+   pthread_mutex_unlock(&tls.lock);
+   if(c)
+   {
+      SSL_shutdown(c->ssl); /* Send close_notify */
+      ERR_clear_error();
+      SeTlsConn_free(c);
+   }
+   close(*sock);
+   *sock=-1;
+}
+
+
+static S32
+seTls_write(SeTlsConn* c, const void* buf, U32 len)
+{
+   U32 sent = 0;
+   while(sent < len)
+   {
+      int x = SSL_write(c->ssl, (const U8*)buf + sent, (int)(len - sent));
+      if(x <= 0)
+      {
+         ERR_clear_error();
+         return -1;
+      }
+      sent += (U32)x;
+   }
+   return (S32)len;
+}
+
+
+S32
+se_send(int* sock, const void* buf, U32 len)
+{
+   SeTlsConn* c = seTls_conn(*sock);
+   if(!c || c->ktlsSend)
+      return send(*sock, (void*)buf, len, 0);
+   return seTls_write(c, buf, len);
+}
+
+
+/* Small regions are copied into one record; large regions are sent
+   as they are.
+*/
+S32
+se_sendv(int* sock, const SeIoVec* iov, int cnt)
+{
+   U8 buf[SE_TLS_RECORD];
+   SeTlsConn* c = seTls_conn(*sock);
+   U32 n = 0;
+   S32 sent = 0;
+   if(!c || c->ktlsSend)
+      return se_sendmsgv(sock, iov, cnt);
+   for( ; cnt > 0 ; iov++, cnt--)
+   {
+      if(iov->len < SE_TLS_COALESCE && n + iov->len <= sizeof(buf))
+      {
+         memcpy(buf + n, iov->data, iov->len);
+         n += iov->len;
+         continue;
+      }
+      if(n)
+      {
+         if(seTls_write(c, buf, n) < 0)
+            return -1;
+         sent += (S32)n;
+         n = 0;
+      }
+      if(iov->len < SE_TLS_COALESCE)
+      {
+         memcpy(buf, iov->data, iov->len);
+         n = iov->len;
+      }
+      else
+      {
+         if(seTls_write(c, iov->data, iov->len) < 0)
+            return -1;
+         sent += (S32)iov->len;
+      }
+   }
+   if(n)
+   {
+      if(seTls_write(c, buf, n) < 0)
+         return -1;
+      sent += (S32)n;
+   }
+   return sent;
+}
+
+
+S32
+se_recv(int* sock, void* buf, U32 len, U32 timeout)
+{
+   SeTlsConn* c = seTls_conn(*sock);
+   if(!c)
+   {
+      int x;
+      if(timeout != INFINITE_TMO && seTls_wait(*sock, POLLIN, timeout))
+         return 0;
+      x = recv(*sock, buf, len, 0);
+      return x <= 0 ? -1 : x;
+   }
+   for(;;)
+   {
+      int x;
+      if(!SSL_has_pending(c->ssl) && timeout != INFINITE_TMO &&
+         seTls_wait(*sock, POLLIN, timeout))
+      {
+         return 0;
+      }
+      x = SSL_read(c->ssl, buf, (int)len);
+      if(x > 0)
+         return x;
+      if(SSL_get_error(c->ssl, x) != SSL_ERROR_WANT_READ)
+      {
+         ERR_clear_error();
+         return -1;
+      }
+      /* A non application record, such as a session ticket */
+   }
+}
@@ -0,0 +1,134 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+
+  TLS backend for se_send, se_recv, and se_close using OpenSSL 1.1.1
+  or later.
+
+  Enabled by compiling selib.c, SMQClient.c, and seTls.c with the
+  macro SE_TLS (make TLS=1). SMQ_init then accepts https:// URLs. See
+  README.txt in this directory for session resumption and kernel TLS
+  offload.
+ */
+
+#ifndef _seTls_h
+#define _seTls_h
+
+#if defined(SE_URING) || defined(SE_ZEROCOPY)
+#error SE_TLS cannot be combined with SE_URING or SE_ZEROCOPY
+#endif
+
+/* The TLS versions of these functions are in seTls.c */
+#define X_se_send
+#define X_se_recv
+#define X_se_close
+
+/* Number of sessions cached for resumption; one per host and port */
+#ifndef SE_TLS_SESSIONS
+#define SE_TLS_SESSIONS 16
+#endif
+
+/* Max time in milliseconds for the TLS handshake */
+#ifndef SE_TLS_HANDSHAKE_TMO
+#define SE_TLS_HANDSHAKE_TMO 10000
+#endif
+
+/* se_sendv copies regions smaller than this into one TLS record
+   instead of sending one record per region. Not used with kernel TLS.
+*/
+#ifndef SE_TLS_COALESCE
+#define SE_TLS_COALESCE 2048
+#endif
+
+typedef struct
+{
+   U32 handshakes; /* Completed handshakes */
+   U32 resumed; /* Handshakes that resumed a cached session */
+   U32 failed; /* Failed handshakes */
+   U32 ktlsSend; /* Connections with kernel TLS send offload */
+   U32 ktlsRecv; /* Connections with kernel TLS receive offload */
+} SeTlsStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern SeTlsStats se_tlsStats;
+
+/** Configure certificate verification. Calling this function is
+    optional; by default, the broker's certificate is verified with the
+    system's trusted CA certificates and must match the host name.
+    \param caFile PEM file with the trusted CA certificates or NULL for
+    the system default.
+    \param verify FALSE disables certificate verification. For
+    testing only.
+    \returns zero on success or -1 if 'caFile' cannot be loaded.
+*/
+int se_tlsInit(const char* caFile, BaBool verify);
+
+/** Release the TLS context and all cached sessions. */
+void se_tlsClose(void);
+
+/** Perform the TLS handshake on the connected socket 'sock'. A session
+    cached for 'host' and 'port' by an earlier connection is resumed
+    if the server accepts it, and the session tickets received on
+    this connection replace the cached session. SMQ_init calls this
+    function for https:// URLs. TCP_NODELAY is set on 'sock'.
+    \returns zero on success, -4 if the handshake failed or timed out,
+    or -5 if the certificate could not be verified.
+*/
+int se_tlsConnect(int* sock, const char* host, U16 port);
+
+/** Enable or disable the session cache. Disabling the cache
+    releases all cached sessions and every handshake is then a full
+    handshake.
+*/
+void se_tlsSessionCache(BaBool enable);
+
+/** Returns TRUE if the TLS connection on 'sock' was resumed. */
+BaBool se_tlsResumed(int* sock);
+
+/** Returns TRUE if records sent on 'sock' are encrypted by the kernel
+    (Linux kernel TLS). se_send and se_sendv then write directly to the
+    socket and se_sendv sends all regions with one sendmsg call.
+*/
+BaBool se_tlsKtls(int* sock);
+
+/* The sendmsg implementation in selibplat.h, used by se_sendv for
+   sockets without TLS and with kernel TLS.
+*/
+S32 se_sendmsgv(int* sock, const SeIoVec* iov, int cnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,818 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *   PROGRAM MODULE
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+  io_uring backend for se_send, se_recv, and se_close (Linux 6.0 or later).
+
+  One ring is shared by all sockets in the process. Each socket has
+  one multishot receive that fills buffers taken from a provided
+  buffer ring; the completions are queued per socket and se_recv
+  copies from the queue. Sends are queued per socket so that only one
+  send per socket is in flight, which keeps the byte stream in order.
+
+  The ring is not thread safe. Use it from the thread that drives all
+  SMQ sessions.
+ */
+
+#include "../../selib.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef SE_URING
+#error SE_URING not defined -> Using incorrect selibplat.h
+#endif
+
+#if (SE_URING_RBUFS & (SE_URING_RBUFS-1)) || SE_URING_RBUFS > 0x8000
+#error SE_URING_RBUFS must be a power of 2 and not larger than 0x8000
+#endif
+
+#define SEU_BGID 0x5E /* Provided buffer group ID */
+#define SEU_NONE 0xFFFF
+
+/* user_data layout: kind:8 | generation:24 | fd or op index:32 */
+#define SEU_RECV   1
+#define SEU_SEND   2
+#define SEU_CANCEL 3
+#define SEU_UDATA(kind, gen, ix) \
+   (((U64)(kind) << 56) | ((U64)((gen) & 0xFFFFFF) << 32) | (U32)(ix))
+#define SEU_KIND(ud) ((U8)((ud) >> 56))
+#define SEU_GEN(ud)  ((U32)((ud) >> 32) & 0xFFFFFF)
+#define SEU_IX(ud)   ((U32)(ud))
+
+
+typedef struct
+{
+   U32 gen; /* Incremented on close: detects stale completions */
+   U32 rBytes; /* Bytes queued in the receive buffer list */
+   S32 err; /* Sticky error code */
+   U16 rHead; /* Receive buffer list (buffer IDs) */
+   U16 rTail;
+   U16 rOff; /* Bytes consumed in rHead */
+   U16 sHead; /* Send queue (op index); only sHead is in flight */
+   U16 sTail;
+   U8 used;
+   U8 armed; /* Multishot receive active */
+   U8 starved; /* Multishot stopped: out of receive buffers */
+} SeUringSock;
+
+
+typedef struct
+{
+   const U8* data;
+   U32 len;
+   U32 done;
+   S32 res;
+   int fd; /* -1 when the socket was closed with the op in flight */
+   U16 next;
+   S16 bufIx; /* Registered buffer index or -1 */
+   U8 deferred; /* Data is in a staging slot; free op on completion */
+   U8 complete;
+} SeUringOp;
+
+
+typedef struct
+{
+   int fd;
+   U32 sqEntries;
+   unsigned* sqHead;
+   unsigned* sqTail;
+   unsigned* sqMask;
+   unsigned* sqArray;
+   unsigned* cqHead;
+   unsigned* cqTail;
+   unsigned* cqMask;
+   struct io_uring_sqe* sqes;
+   struct io_uring_cqe* cqes;
+   void* sqMap;
+   void* cqMap;
+   size_t sqMapLen;
+   size_t cqMapLen;
+   size_t sqesLen;
+   struct io_uring_buf_ring* br;
+   U8* rBufs;
+   U8* slots;
+   struct iovec* regs;
+   SeUringSock* socks;
+   int nSocks;
+   U32 nRegs;
+   U32 rFree; /* Buffers available to the kernel */
+   U32 starved; /* Number of sockets with starved set */
+   U16 brTail;
+   U16 freeOp;
+   U16 bNext[SE_URING_RBUFS];
+   U16 bLen[SE_URING_RBUFS];
+   SeUringOp ops[SE_URING_OPS];
+   BaBool defer;
+   BaBool noFixedSend; /* Kernel rejects IORING_RECVSEND_FIXED_BUF */
+} SeUring;
+
+static SeUring seu;
+
+
+static U64
+seu_now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/* Submit queued SQEs and optionally wait for 'minComplete' CQEs.
+   Returns zero on success, timeout, or signal, and -errno on error.
+ */
+static int
+seu_enter(U32 minComplete, U32 tmo)
+{
+   struct io_uring_getevents_arg arg;
+   struct __kernel_timespec ts;
+   unsigned flags = 0;
+   unsigned toSubmit;
+   int ret;
+   toSubmit = *seu.sqTail - __atomic_load_n(seu.sqHead, __ATOMIC_ACQUIRE);
+   if(!toSubmit && !minComplete)
+      return 0;
+   if(minComplete)
+   {
+      flags = IORING_ENTER_GETEVENTS;
+      if(tmo != INFINITE_TMO)
+      {
+         memset(&arg, 0, sizeof(arg));
+         ts.tv_sec = tmo / 1000;
+         ts.tv_nsec = (long long)(tmo % 1000) * 1000000;
+         arg.ts = (U64)(uintptr_t)&ts;
+         flags |= IORING_ENTER_EXT_ARG;
+      }
+   }
+   ret = (int)syscall(__NR_io_uring_enter, seu.fd, toSubmit, minComplete,
+                      flags, flags & IORING_ENTER_EXT_ARG ? &arg : 0,
+                      flags & IORING_ENTER_EXT_ARG ? sizeof(arg) : 0);
+   if(ret < 0)
+   {
+      ret = -errno;
+      if(ret == -ETIME || ret == -EINTR || ret == -EAGAIN || ret == -EBUSY)
+         ret = 0;
+   }
+   else
+      ret = 0;
+   return ret;
+}
+
+
+static struct io_uring_sqe*
+seu_getSqe(void)
+{
+   unsigned tail = *seu.sqTail;
+   unsigned ix;
+   struct io_uring_sqe* sqe;
+   if(tail - __atomic_load_n(seu.sqHead, __ATOMIC_ACQUIRE) >= seu.sqEntries)
+   {
+      /* Full: submit what we have to make room */
+      if(seu_enter(0, 0) ||
+         tail - __atomic_load_n(seu.sqHead,__ATOMIC_ACQUIRE) >= seu.sqEntries)
+      {
+         return 0;
+      }
+   }
+   ix = tail & *seu.sqMask;
+   sqe = &seu.sqes[ix];
+   memset(sqe, 0, sizeof(struct io_uring_sqe));
+   seu.sqArray[ix] = ix;
+   __atomic_store_n(seu.sqTail, tail + 1, __ATOMIC_RELEASE);
+   return sqe;
+}
+
+
+/* Give receive buffer 'bid' back to the kernel */
+static void
+seu_putRBuf(U16 bid)
+{
+   struct io_uring_buf* b = &seu.br->bufs[seu.brTail & (SE_URING_RBUFS-1)];
+   b->addr = (U64)(uintptr_t)(seu.rBufs + (size_t)bid * SE_URING_RBUF_SIZE);
+   b->len = SE_URING_RBUF_SIZE;
+   b->bid = bid;
+   seu.brTail++;
+   seu.rFree++;
+   __atomic_store_n(&seu.br->tail, seu.brTail, __ATOMIC_RELEASE);
+}
+
+
+static SeUringSock*
+seu_sock(int fd)
+{
+   SeUringSock* s;
+   if(fd < 0)
+      return 0;
+   if(fd >= seu.nSocks)
+   {
+      int i, n = seu.nSocks ? seu.nSocks * 2 : 64;
+      if(n <= fd)
+         n = fd + 1;
+      s = (SeUringSock*)baRealloc(seu.socks, n * sizeof(SeUringSock));
+      if(!s)
+         return 0;
+      memset(s + seu.nSocks, 0, (n - seu.nSocks) * sizeof(SeUringSock));
+      for(i = seu.nSocks ; i < n ; i++)
+         s[i].rHead = s[i].rTail = s[i].sHead = s[i].sTail = SEU_NONE;
+      seu.socks = s;
+      seu.nSocks = n;
+   }
+   s = seu.socks + fd;
+   if(!s->used)
+   {
+      s->used = TRUE;
+      s->err = 0;
+   }
+   return s;
+}
+
+
+static int
+seu_arm(int fd, SeUringSock* s)
+{
+   struct io_uring_sqe* sqe;
+   if(!seu.rFree)
+   {
+      if(!s->starved)
+      {
+         s->starved = TRUE;
+         seu.starved++;
+      }
+      return 0;
+   }
+   sqe = seu_getSqe();
+   if(!sqe)
+      return -1;
+   sqe->opcode = IORING_OP_RECV;
+   sqe->fd = fd;
+   sqe->ioprio = IORING_RECV_MULTISHOT;
+   sqe->flags = IOSQE_BUFFER_SELECT;
+   sqe->buf_group = SEU_BGID;
+   sqe->user_data = SEU_UDATA(SEU_RECV, s->gen, fd);
+   s->armed = TRUE;
+   if(s->starved)
+   {
+      s->starved = FALSE;
+      seu.starved--;
+   }
+   return 0;
+}
+
+
+static void
+seu_rearmStarved(void)
+{
+   int fd;
+   for(fd = 0 ; fd < seu.nSocks && seu.starved && seu.rFree ; fd++)
+   {
+      SeUringSock* s = seu.socks + fd;
+      if(s->starved)
+         seu_arm(fd, s);
+   }
+}
+
+
+static int
+seu_issue(SeUringOp* op, U16 ix)
+{
+   struct io_uring_sqe* sqe = seu_getSqe();
+   if(!sqe)
+      return -1;
+   /* Always a send, not a write, so MSG_NOSIGNAL turns a reset by the
+    * peer into -EPIPE instead of SIGPIPE.
+    */
+   sqe->opcode = IORING_OP_SEND;
+   sqe->msg_flags = MSG_NOSIGNAL;
+   if(op->bufIx >= 0 && !seu.noFixedSend)
+   {
+      sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+      sqe->buf_index = (U16)op->bufIx;
+   }
+   sqe->fd = op->fd;
+   sqe->addr = (U64)(uintptr_t)(op->data + op->done);
+   sqe->len = op->len - op->done;
+   sqe->user_data = SEU_UDATA(SEU_SEND, 0, ix);
+   return 0;
+}
+
+
+static void
+seu_freeOp(U16 ix)
+{
+   seu.ops[ix].next = seu.freeOp;
+   seu.freeOp = ix;
+}
+
+
+/* Send op 'ix' completed with 'res' (bytes sent or -errno) */
+static void
+seu_opDone(U16 ix, S32 res)
+{
+   SeUringOp* op = seu.ops + ix;
+   op->res = res;
+   op->complete = TRUE;
+   if(op->fd >= 0)
+   {
+      SeUringSock* s = seu.socks + op->fd;
+      baAssert(s->sHead == ix);
+      s->sHead = op->next;
+      if(s->sHead == SEU_NONE)
+         s->sTail = SEU_NONE;
+      if(res < 0)
+      {
+         if(!s->err)
+            s->err = res;
+      }
+      else if(s->sHead != SEU_NONE && seu_issue(seu.ops + s->sHead, s->sHead))
+         s->err = -1;
+   }
+   if(op->deferred || op->fd < 0)
+      seu_freeOp(ix);
+}
+
+
+static void
+seu_dispatch(U64 ud, S32 res, U32 flags)
+{
+   U32 ix = SEU_IX(ud);
+   switch(SEU_KIND(ud))
+   {
+      case SEU_RECV: {
+         SeUringSock* s = (int)ix < seu.nSocks ? seu.socks + ix : 0;
+         BaBool stale = !s || !s->used || s->gen != SEU_GEN(ud);
+         if(flags & IORING_CQE_F_BUFFER)
+         {
+            U16 bid = (U16)(flags >> IORING_CQE_BUFFER_SHIFT);
+            seu.rFree--;
+            if(stale || res <= 0)
+               seu_putRBuf(bid);
+            else
+            {
+               seu.bLen[bid] = (U16)res;
+               seu.bNext[bid] = SEU_NONE;
+               if(s->rTail == SEU_NONE)
+                  s->rHead = bid;
+               else
+                  seu.bNext[s->rTail] = bid;
+               s->rTail = bid;
+               s->rBytes += (U32)res;
+            }
+         }
+         if(stale || (flags & IORING_CQE_F_MORE))
+            break;
+         s->armed = FALSE;
+         if(res > 0 || res == -ENOBUFS)
+            seu_arm((int)ix, s); /* Multishot terminated: restart */
+         else if(!s->err)
+            s->err = res ? res : -1; /* zero: closed by peer */
+         break;
+      }
+
+      case SEU_SEND: {
+         SeUringOp* op = seu.ops + ix;
+         if(res > 0)
+         {
+            op->done += (U32)res;
+            if(op->done < op->len && op->fd >= 0)
+            {
+               if(!seu_issue(op, (U16)ix))
+                  break;
+               res = -1;
+            }
+         }
+         else if(res == 0)
+            res = -EPIPE;
+         else if(res == -EINVAL && op->bufIx >= 0 && !seu.noFixedSend &&
+                 op->fd >= 0)
+         {
+            /* Older kernel without fixed buffer sends: use plain sends */
+            seu.noFixedSend = TRUE;
+            if(!seu_issue(op, (U16)ix))
+               break;
+            res = -1;
+         }
+         seu_opDone((U16)ix, res < 0 ? res : (S32)op->done);
+         break;
+      }
+
+      default: /* SEU_CANCEL */
+         break;
+   }
+}
+
+
+static int
+seu_reap(void)
+{
+   int n = 0;
+   unsigned head = *seu.cqHead;
+   while(head != __atomic_load_n(seu.cqTail, __ATOMIC_ACQUIRE))
+   {
+      struct io_uring_cqe* cqe = &seu.cqes[head & *seu.cqMask];
+      U64 ud = cqe->user_data;
+      S32 res = cqe->res;
+      U32 flags = cqe->flags;
+      __atomic_store_n(seu.cqHead, ++head, __ATOMIC_RELEASE);
+      seu_dispatch(ud, res, flags);
+      n++;
+   }
+   return n;
+}
+
+
+static int
+seu_start(void)
+{
+   return seu.sqes ? 0 : se_uringInit(256, 0, 0);
+}
+
+
+int
+se_uringInit(U32 entries, const struct iovec* bufs, U32 nBufs)
+{
+   struct io_uring_params p;
+   struct io_uring_buf_reg reg;
+   U32 i;
+   if(seu.sqes)
+      return -EBUSY;
+   memset(&seu, 0, sizeof(seu));
+   memset(&p, 0, sizeof(p));
+   p.flags = IORING_SETUP_CQSIZE;
+   p.cq_entries = (entries < 64 ? 64 : entries) * 4;
+   seu.fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+   if(seu.fd < 0)
+      return -errno;
+   seu.sqEntries = p.sq_entries;
+   seu.sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+   seu.cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   if(p.features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if(seu.cqMapLen > seu.sqMapLen)
+         seu.sqMapLen = seu.cqMapLen;
+      seu.cqMapLen = 0;
+   }
+   seu.sqMap = mmap(0, seu.sqMapLen, PROT_READ|PROT_WRITE,
+                    MAP_SHARED|MAP_POPULATE, seu.fd, IORING_OFF_SQ_RING);
+   if(seu.sqMap == MAP_FAILED)
+      goto L_err;
+   if(seu.cqMapLen)
+   {
+      seu.cqMap = mmap(0, seu.cqMapLen, PROT_READ|PROT_WRITE,
+                       MAP_SHARED|MAP_POPULATE, seu.fd, IORING_OFF_CQ_RING);
+      if(seu.cqMap == MAP_FAILED)
+         goto L_err;
+   }
+   else
+      seu.cqMap = seu.sqMap;
+   seu.sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+   seu.sqes = (struct io_uring_sqe*)mmap(
+      0, seu.sqesLen, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+      seu.fd, IORING_OFF_SQES);
+   if(seu.sqes == MAP_FAILED)
+   {
+      seu.sqes = 0;
+      goto L_err;
+   }
+   seu.sqHead = (unsigned*)((U8*)seu.sqMap + p.sq_off.head);
+   seu.sqTail = (unsigned*)((U8*)seu.sqMap + p.sq_off.tail);
+   seu.sqMask = (unsigned*)((U8*)seu.sqMap + p.sq_off.ring_mask);
+   seu.sqArray = (unsigned*)((U8*)seu.sqMap + p.sq_off.array);
+   seu.cqHead = (unsigned*)((U8*)seu.cqMap + p.cq_off.head);
+   seu.cqTail = (unsigned*)((U8*)seu.cqMap + p.cq_off.tail);
+   seu.cqMask = (unsigned*)((U8*)seu.cqMap + p.cq_off.ring_mask);
+   seu.cqes = (struct io_uring_cqe*)((U8*)seu.cqMap + p.cq_off.cqes);
+
+   /* Provided buffer ring used by the multishot receives */
+   if(posix_memalign((void**)&seu.br, 4096,
+                     SE_URING_RBUFS * sizeof(struct io_uring_buf)) ||
+      (seu.rBufs = (U8*)baMalloc(SE_URING_RBUFS * SE_URING_RBUF_SIZE)) == 0)
+   {
+      goto L_err;
+   }
+   memset(seu.br, 0, SE_URING_RBUFS * sizeof(struct io_uring_buf));
+   memset(&reg, 0, sizeof(reg));
+   reg.ring_addr = (U64)(uintptr_t)seu.br;
+   reg.ring_entries = SE_URING_RBUFS;
+   reg.bgid = SEU_BGID;
+   if(syscall(__NR_io_uring_register,seu.fd,IORING_REGISTER_PBUF_RING,&reg,1))
+      goto L_err;
+   for(i = 0 ; i < SE_URING_RBUFS ; i++)
+      seu_putRBuf((U16)i);
+
+   /* Registered buffers: index 0 is the staging area for deferred
+    * sends, followed by the caller's buffers.
+    */
+   seu.slots = (U8*)baMalloc(SE_URING_OPS * SE_URING_SLOT_SIZE);
+   seu.regs = (struct iovec*)baMalloc((nBufs + 1) * sizeof(struct iovec));
+   if(!seu.slots || !seu.regs)
+      goto L_err;
+   seu.regs[0].iov_base = seu.slots;
+   seu.regs[0].iov_len = SE_URING_OPS * SE_URING_SLOT_SIZE;
+   if(nBufs)
+      memcpy(seu.regs + 1, bufs, nBufs * sizeof(struct iovec));
+   seu.nRegs = nBufs + 1;
+   if(syscall(__NR_io_uring_register, seu.fd, IORING_REGISTER_BUFFERS,
+              seu.regs, seu.nRegs))
+   {
+      goto L_err;
+   }
+
+   seu.freeOp = SEU_NONE;
+   for(i = SE_URING_OPS ; i-- > 0 ; )
+      seu_freeOp((U16)i);
+   return 0;
+
+  L_err:
+   i = errno ? -errno : -ENOMEM;
+   se_uringClose();
+   return (int)i;
+}
+
+
+void
+se_uringClose(void)
+{
+   if(seu.fd > 0)
+      close(seu.fd); /* Cancels everything in flight */
+   if(seu.sqes)
+      munmap(seu.sqes, seu.sqesLen);
+   if(seu.cqMap && seu.cqMap != MAP_FAILED && seu.cqMap != seu.sqMap)
+      munmap(seu.cqMap, seu.cqMapLen);
+   if(seu.sqMap && seu.sqMap != MAP_FAILED)
+      munmap(seu.sqMap, seu.sqMapLen);
+   free(seu.br); /* posix_memalign */
+   if(seu.rBufs)
+      baFree(seu.rBufs);
+   if(seu.slots)
+      baFree(seu.slots);
+   if(seu.regs)
+      baFree(seu.regs);
+   if(seu.socks)
+      baFree(seu.socks);
+   memset(&seu, 0, sizeof(seu));
+}
+
+
+int
+se_uringArm(int* sock)
+{
+   SeUringSock* s;
+   int ret = seu_start();
+   if(ret)
+      return ret;
+   s = seu_sock(*sock);
+   if(!s)
+      return -ENOMEM;
+   return s->armed || s->starved || s->err ? 0 : seu_arm(*sock, s);
+}
+
+
+int
+se_uringPoll(U32 tmo)
+{
+   int n, ret = seu_start();
+   if(ret)
+      return ret;
+   if(seu.starved && seu.rFree)
+      seu_rearmStarved();
+   n = seu_reap();
+   ret = seu_enter(n || !tmo ? 0 : 1, tmo);
+   if(ret < 0)
+      return ret;
+   return n + seu_reap();
+}
+
+
+S32
+se_uringPending(int* sock)
+{
+   SeUringSock* s;
+   if(seu_start() || (s = seu_sock(*sock)) == 0)
+      return -1;
+   if(s->rBytes)
+      return (S32)s->rBytes;
+   return s->err;
+}
+
+
+void
+se_uringDefer(BaBool enable)
+{
+   seu.defer = enable;
+}
+
+
+void
+se_close(int* sock)
+{
+   if(*sock >= 0 && *sock < seu.nSocks && seu.socks[*sock].used)
+   {
+      SeUringSock* s = seu.socks + *sock;
+      if(s->armed || s->sHead != SEU_NONE)
+      {
+         struct io_uring_sqe* sqe = seu_getSqe();
+         if(sqe)
+         {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = *sock;
+            sqe->cancel_flags=IORING_ASYNC_CANCEL_FD|IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = SEU_UDATA(SEU_CANCEL, 0, 0);
+         }
+         /* The send queue head may be in flight: free it on completion */
+         if(s->sHead != SEU_NONE)
+         {
+            U16 ix = seu.ops[s->sHead].next;
+            seu.ops[s->sHead].fd = -1;
+            while(ix != SEU_NONE)
+            {
+               U16 next = seu.ops[ix].next;
+               seu_freeOp(ix);
+               ix = next;
+            }
+         }
+         seu_enter(0, 0);
+      }
+      while(s->rHead != SEU_NONE)
+      {
+         U16 bid = s->rHead;
+         s->rHead = seu.bNext[bid];
+         seu_putRBuf(bid);
+      }
+      if(s->starved)
+         seu.starved--;
+      s->gen++;
+      s->used = s->armed = s->starved = FALSE;
+      s->rTail = s->sHead = s->sTail = SEU_NONE;
+      s->rOff = 0;
+      s->rBytes = 0;
+   }
+   if(*sock >= 0)
+      close(*sock);
+   *sock=-1;
+}
+
+
+S32
+se_send(int* sock, const void* buf, U32 len)
+{
+   SeUringSock* s;
+   SeUringOp* op;
+   U16 ix;
+   if(seu_start() || (s = seu_sock(*sock)) == 0)
+      return -1;
+   if(s->err)
+      return s->err;
+   if(!len)
+      return 0;
+   while(seu.freeOp == SEU_NONE)
+   {
+      if(se_uringPoll(INFINITE_TMO) < 0)
+         return -1;
+   }
+   ix = seu.freeOp;
+   op = seu.ops + ix;
+   seu.freeOp = op->next;
+   op->fd = *sock;
+   op->len = len;
+   op->done = 0;
+   op->complete = FALSE;
+   op->next = SEU_NONE;
+   if(seu.defer && len <= SE_URING_SLOT_SIZE)
+   {
+      U8* slot = seu.slots + (size_t)ix * SE_URING_SLOT_SIZE;
+      memcpy(slot, buf, len);
+      op->data = slot;
+      op->bufIx = 0;
+      op->deferred = TRUE;
+   }
+   else
+   {
+      U32 i;
+      op->data = (const U8*)buf;
+      op->bufIx = -1;
+      op->deferred = FALSE;
+      for(i = 1 ; i < seu.nRegs ; i++)
+      {
+         const U8* base = (const U8*)seu.regs[i].iov_base;
+         if(op->data >= base && op->data + len <= base + seu.regs[i].iov_len)
+         {
+            op->bufIx = (S16)i;
+            break;
+         }
+      }
+   }
+   if(s->sTail == SEU_NONE)
+   {
+      s->sHead = s->sTail = ix;
+      if(seu_issue(op, ix))
+      {
+         s->sHead = s->sTail = SEU_NONE;
+         seu_freeOp(ix);
+         return s->err = -1;
+      }
+   }
+   else
+   {
+      seu.ops[s->sTail].next = ix;
+      s->sTail = ix;
+   }
+   if(op->deferred)
+      return (S32)len;
+   while(!op->complete)
+   {
+      if(se_uringPoll(INFINITE_TMO) < 0)
+      {
+         op->deferred = TRUE; /* Release when the kernel is done */
+         return -1;
+      }
+   }
+   seu_freeOp(ix);
+   return op->res;
+}
+
+
+S32
+se_recv(int* sock, void* buf, U32 len, U32 timeout)
+{
+   SeUringSock* s;
+   U64 start;
+   BaBool polled = FALSE;
+   if(seu_start() || (s = seu_sock(*sock)) == 0)
+      return -1;
+   if(!s->armed && !s->starved && !s->err && seu_arm(*sock, s))
+      return -1;
+   start = timeout == INFINITE_TMO ? 0 : seu_now();
+   for(;;)
+   {
+      U32 tmo = INFINITE_TMO;
+      if(s->rHead != SEU_NONE)
+      {
+         U32 n = 0;
+         while(n < len && s->rHead != SEU_NONE)
+         {
+            U16 bid = s->rHead;
+            U32 chunk = seu.bLen[bid] - s->rOff;
+            if(chunk > len - n)
+               chunk = len - n;
+            memcpy((U8*)buf + n,
+                   seu.rBufs + (size_t)bid*SE_URING_RBUF_SIZE + s->rOff,chunk);
+            n += chunk;
+            s->rOff += (U16)chunk;
+            if(s->rOff == seu.bLen[bid])
+            {
+               s->rHead = seu.bNext[bid];
+               if(s->rHead == SEU_NONE)
+                  s->rTail = SEU_NONE;
+               s->rOff = 0;
+               seu_putRBuf(bid);
+            }
+         }
+         s->rBytes -= n;
+         return (S32)n;
+      }
+      if(s->err)
+         return s->err;
+      if(timeout != INFINITE_TMO)
+      {
+         U64 elapsed = seu_now() - start;
+         if(elapsed >= timeout && polled)
+            return 0;
+         tmo = elapsed >= timeout ? 0 : timeout - (U32)elapsed;
+      }
+      if(se_uringPoll(tmo) < 0)
+         return -1;
+      polled = TRUE;
+   }
+}
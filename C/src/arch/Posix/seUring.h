@@ -0,0 +1,121 @@
+/*
+ *     ____             _________                __                _
+ *    / __ \___  ____ _/ /_  __(_)___ ___  ___  / /   ____  ____ _(_)____
+ *   / /_/ / _ \/ __ `/ / / / / / __ `__ \/ _ \/ /   / __ \/ __ `/ / ___/
+ *  / _, _/  __/ /_/ / / / / / / / / / / /  __/ /___/ /_/ / /_/ / / /__
+ * /_/ |_|\___/\__,_/_/ /_/ /_/_/ /_/ /_/\___/_____/\____/\__, /_/\___/
+ *                                                       /____/
+ *
+ ****************************************************************************
+ *            HEADER
+ *
+ *   COPYRIGHT:  Real Time Logic LLC, 2026
+ *
+ *   This software is copyrighted by and is the sole property of Real
+ *   Time Logic LLC.  All rights, title, ownership, or other interests in
+ *   the software remain the property of Real Time Logic LLC.  This
+ *   software may only be used in accordance with the terms and
+ *   conditions stipulated in the corresponding license agreement under
+ *   which the software has been supplied.  Any unauthorized use,
+ *   duplication, transmission, distribution, or disclosure of this
+ *   software is expressly forbidden.
+ *
+ *   This Copyright notice may not be removed or modified without prior
+ *   written consent of Real Time Logic LLC.
+ *
+ *   Real Time Logic LLC. reserves the right to modify this software
+ *   without notice.
+ *
+ *               https://realtimelogic.com
+ ****************************************************************************
+
+  Linux io_uring backend for se_send, se_recv, and se_close.
+
+  Enabled by compiling selib.c and seUring.c with the macro SE_URING
+  (make URING=1). See README.txt in this directory for how to drive
+  many SMQ sessions from one thread.
+ */
+
+#ifndef _seUring_h
+#define _seUring_h
+
+#include <sys/uio.h>
+
+/* The io_uring versions of these functions are in seUring.c */
+#define X_se_send
+#define X_se_recv
+#define X_se_close
+
+/* Number of provided receive buffers shared by all sockets (power of 2) */
+#ifndef SE_URING_RBUFS
+#define SE_URING_RBUFS 256
+#endif
+
+/* Size of each provided receive buffer */
+#ifndef SE_URING_RBUF_SIZE
+#define SE_URING_RBUF_SIZE 2048
+#endif
+
+/* Number of send operations that can be in flight; each deferred send
+ * borrows one staging slot of SE_URING_SLOT_SIZE bytes.
+ */
+#ifndef SE_URING_OPS
+#define SE_URING_OPS 64
+#endif
+
+#ifndef SE_URING_SLOT_SIZE
+#define SE_URING_SLOT_SIZE 2048
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create the process wide ring. Calling this function is optional;
+    the first se_send/se_recv creates a ring with default settings.
+
+    \param entries submission queue size (rounded up to a power of 2).
+    \param bufs optional buffers registered with the kernel, typically
+    the SMQ::buf of each session. se_send uses a fixed buffer send
+    when the data to send is within one of these buffers.
+    \param nBufs number of entries in 'bufs'.
+    \returns zero on success or a negative errno value.
+*/
+int se_uringInit(U32 entries, const struct iovec* bufs, U32 nBufs);
+
+/** Cancel all outstanding operations and release the ring. */
+void se_uringClose(void);
+
+/** Start the multishot receive for 'sock' so data is queued before
+    the first se_recv call. Call after se_connect.
+*/
+int se_uringArm(int* sock);
+
+/** Submit all queued operations for all sockets with one system call
+    and reap the completions.
+    \param tmo the max time in milliseconds to wait for at least one
+    completion. Zero does not wait. The timeout can be #INFINITE_TMO.
+    \returns the number of completions reaped or a negative errno value.
+*/
+int se_uringPoll(U32 tmo);
+
+/** Returns the number of received bytes queued for 'sock', which
+    se_recv returns without a system call, or a negative value if the
+    connection is closed or in an error state.
+*/
+S32 se_uringPending(int* sock);
+
+/** Enable or disable deferred sends. When enabled, se_send copies
+    data not larger than #SE_URING_SLOT_SIZE into a registered staging
+    slot and returns immediately. The send is submitted by the next
+    se_uringPoll or se_recv call, so replies to many sessions are
+    submitted with one system call. An error from a deferred send is
+    returned by the next se_send or se_recv on the same socket.
+*/
+void se_uringDefer(BaBool enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
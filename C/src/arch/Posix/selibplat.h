@@ -43,6 +43,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/un.h>
 #include <netinet/tcp.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -56,69 +57,719 @@
 #define __linux__ 1
 #endif
 
+#if !defined(baMalloc) && !defined(UMM_MALLOC)
+#include <stdlib.h>
+#define baMalloc(s)        malloc(s)
+#define baRealloc(m, s)    realloc(m, s)
+#define baFree(m)          free(m)
+#endif
+
+/* Linux io_uring backend: compile with SE_URING and add seUring.c */
+#ifdef SE_URING
+#include "seUring.h"
+#endif
+
+/* TLS backend (OpenSSL): compile with SE_TLS and add seTls.c */
+#ifdef SE_TLS
+#include "seTls.h"
+#endif
+
+/* Linux MSG_ZEROCOPY send path: compile with SE_ZEROCOPY.
+   se_send uses sendmsg with MSG_ZEROCOPY when the data is at least
+   se_zcThreshold bytes and returns after the kernel has released the
+   caller's buffer, i.e. when the completion notification is read from
+   the socket's error queue. Zero copy saves the copy into the kernel,
+   but se_send then returns when the data is acknowledged by the peer
+   and not when the data is queued. Use examples/zcbench.c to find the
+   threshold where this pays off on your network; on loopback the
+   kernel always falls back to copying (counted in SeZcStats::copied).
+   Only TCP/IP sockets with SO_ZEROCOPY enabled, i.e. sockets from
+   se_connectEx, use MSG_ZEROCOPY; se_send copies on other sockets,
+   including AF_UNIX sockets from se_connectUnix (unix: URLs). The
+   wait for the notification is limited to the socket's SO_SNDTIMEO, or
+   SE_ZEROCOPY_TMO milliseconds if not set. se_send returns -1 on
+   timeout and the connection must then be closed, since the kernel
+   may still read the buffer.
+   The SO_ZEROCOPY state is cached in a table with one byte per
+   descriptor below SE_ZEROCOPY_MAXFD, set by se_connectEx and cleared
+   by se_close; se_send asks the kernel for higher descriptors only.
+   Close sockets from se_connectEx with se_close.
+*/
+#if defined(SE_ZEROCOPY) && defined(__linux__) && !defined(SE_URING)
+#ifndef SE_ZEROCOPY_THRESHOLD
+#define SE_ZEROCOPY_THRESHOLD (16*1024)
+#endif
+#ifndef SE_ZEROCOPY_TMO
+#define SE_ZEROCOPY_TMO 30000
+#endif
+#ifndef SE_ZEROCOPY_MAXFD
+#define SE_ZEROCOPY_MAXFD 65536
+#endif
+typedef struct
+{
+   U32 sends; /* sendmsg calls using MSG_ZEROCOPY */
+   U32 completions; /* Notifications read from the error queue */
+   U32 copied; /* Notifications where the kernel copied the data anyway */
+   U32 fallbacks; /* Zero copy refused (ENOBUFS): sent with copy */
+} SeZcStats;
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern U32 se_zcThreshold; /* Defaults to SE_ZEROCOPY_THRESHOLD */
+extern SeZcStats se_zcStats;
+#ifdef __cplusplus
+}
+#endif
+#else
+#undef SE_ZEROCOPY
+#endif
+
+/* An address returned by the resolver */
+typedef struct
+{
+   struct sockaddr_storage addr;
+   socklen_t len;
+} SeAddr;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* Copy up to 'max' addresses from 'res' with the address families
+   interleaved as recommended by RFC 8305. Returns the number copied.
+*/
+int se_copyAddrInfo(const struct addrinfo* res, SeAddr* addrs, int max);
+#ifdef __cplusplus
+}
+#endif
+
+/* AF_UNIX stream sockets for a broker on the same host. SMQ_init
+   connects with se_connectUnix when the URL starts with unix:
+*/
+#define SE_UNIX 1
+
+/* Credentials of the process at the other end of an AF_UNIX socket */
+typedef struct
+{
+   pid_t pid; /* Zero when not provided by the OS */
+   uid_t uid;
+   gid_t gid;
+} SePeerCred;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* Connect to the AF_UNIX stream socket 'path'. A path starting with
+   '@' is in the Linux abstract namespace. Returns zero or the error
+   codes documented for se_connect; -2 if 'path' is too long.
+*/
+int se_connectUnix(int* sock, const char* path);
+
+/* Create a listening AF_UNIX stream socket, see se_bind. A stale
+   socket file at 'path' is removed. Accept with se_accept.
+*/
+int se_bindUnix(int* sock, const char* path);
+
+/* Get the credentials of the peer process (SO_PEERCRED or
+   getpeereid). A broker stand-in uses this to authorize local
+   clients without a password. Returns zero or -1.
+*/
+int se_peerCred(int* sock, SePeerCred* cred);
+#ifdef __cplusplus
+}
+#endif
+
+/* Resolver cache: compile with SE_DNS_CACHE and add seDns.c */
+#ifdef SE_DNS_CACHE
+#include "seDns.h"
+#endif
+
 #ifdef SELIB_C
+#ifdef SE_ZEROCOPY
+/* SO_ZEROCOPY state per descriptor, see se_zcEnabled. A byte per
+   descriptor, since threads may set neighbouring descriptors.
+*/
+static U8 se_zcFds[SE_ZEROCOPY_MAXFD];
+
+static void
+se_zcSet(int sock, int enabled)
+{
+   if(sock >= 0 && sock < SE_ZEROCOPY_MAXFD)
+      se_zcFds[sock] = (U8)enabled;
+}
+#endif
+
 #ifndef __CYGWIN__
-#define X_se_connect
-int se_connect(int* sock, const char* address, U16 port)
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+
+int se_setSockOpt(int* sock, const SeSockOpt* opt);
+
+/* poll instead of select: select fails for descriptors >= FD_SETSIZE */
+#define X_readtmo
+static int readtmo(int sock, U32 tmo)
 {
-   int retVal=-3;
-   struct addrinfo* ptr;
+   struct pollfd pfd;
+   pfd.fd = sock;
+   pfd.events = POLLIN;
+   return poll(&pfd, 1, tmo > 0x7FFFFFFF ? 0x7FFFFFFF : (int)tmo) > 0 ? 0 : -1;
+}
+
+/* se_connectEx defaults, see SeSockOpt */
+#ifndef SE_ATTEMPT_TMO
+#define SE_ATTEMPT_TMO 4000
+#endif
+#ifndef SE_ATTEMPT_DELAY
+#define SE_ATTEMPT_DELAY 250
+#endif
+/* Max number of resolved addresses tried */
+#ifndef SE_CONNECT_MAX
+#define SE_CONNECT_MAX 8
+#endif
+
+static U32
+se_msTime(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (U32)ts.tv_sec * 1000 + (U32)(ts.tv_nsec / 1000000);
+}
+
+int se_copyAddrInfo(const struct addrinfo* res, SeAddr* addrs, int max)
+{
+   const struct addrinfo* ptr;
+   const struct addrinfo* pref = res; /* Next address in preferred family */
+   const struct addrinfo* sec; /* Next address in the other family */
+   int n=0;
+   for(sec=res ; sec && sec->ai_family == pref->ai_family ;
+       sec=sec->ai_next);
+   while(n < max)
+   {
+      const struct addrinfo** cur = n & 1 ? &sec : &pref;
+      if( ! *cur )
+         cur = n & 1 ? &pref : &sec;
+      if( ! *cur )
+         break;
+      if((*cur)->ai_addrlen <= sizeof(addrs[n].addr))
+      {
+         memcpy(&addrs[n].addr, (*cur)->ai_addr, (*cur)->ai_addrlen);
+         addrs[n].len = (*cur)->ai_addrlen;
+         n++;
+      }
+      for(ptr=(*cur)->ai_next ; ptr ; ptr=ptr->ai_next)
+      {
+         if(ptr->ai_family == (*cur)->ai_family)
+            break;
+      }
+      *cur = ptr;
+   }
+   return n;
+}
+
+#ifdef SE_DNS_CACHE
+#define se_resolve(host, addrs, max) se_dnsResolve(host, addrs, max, 1)
+#else
+static int
+se_resolve(const char* host, SeAddr* addrs, int max)
+{
+   struct addrinfo hints;
    struct addrinfo* result = 0;
-   if(getaddrinfo(address, 0, 0, &result))
+   int n;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if(getaddrinfo(host, 0, &hints, &result))
+      return -2;
+   n = se_copyAddrInfo(result, addrs, max);
+   freeaddrinfo(result);
+   return n ? n : -2;
+}
+#endif
+
+/* Start a nonblocking connect. Returns the socket or -1 on error. Sets
+   *done if the connection completed immediately.
+*/
+static int
+se_startConnect(SeAddr* a, U16 port, const SeSockOpt* opt, int* done)
+{
+   int nonBlock=1;
+   int sockfd=socket(a->addr.ss_family, SOCK_STREAM, 0);
+   if(sockfd < 0)
+      return -1;
+   if(a->addr.ss_family == AF_INET)
+      ((struct sockaddr_in*)&a->addr)->sin_port = htons(port);
+   else
+      ((struct sockaddr_in6*)&a->addr)->sin6_port = htons(port);
+   if(opt)
+      se_setSockOpt(&sockfd, opt); /* Before connect: see rcvBuf */
+   ioctl(sockfd, FIONBIO, &nonBlock);
+   *done=0;
+   if(connect(sockfd, (struct sockaddr*)&a->addr, a->len) == 0)
+      *done=1;
+   else if(errno != EINPROGRESS)
+   {
+      close(sockfd);
+      return -1;
+   }
+   return sockfd;
+}
+
+#define X_se_connect
+#define X_se_connectEx
+/* Staggered parallel connect (RFC 8305 "Happy Eyeballs"). The resolved
+   addresses are sorted so that the address families alternate,
+   starting with the family getaddrinfo prefers. A new attempt is
+   started every 'attemptDelay' ms, or at once when an attempt fails,
+   while the earlier attempts continue. The first attempt to complete
+   wins and all other attempts are closed.
+*/
+int se_connectEx(int* sock, const char* address, U16 port,
+                 const SeSockOpt* opt)
+{
+   SeAddr addr[SE_CONNECT_MAX];
+   struct pollfd pfd[SE_CONNECT_MAX];
+   U32 started[SE_CONNECT_MAX];
+   U32 connectTmo, attemptTmo, attemptDelay, start, next;
+   int i, nAddr, nextAddr=0, nActive=0, winner=-1, retVal=-3;
+   if((nAddr = se_resolve(address, addr, SE_CONNECT_MAX)) <= 0)
       return -2;
-   for(ptr=result ; ptr ; ptr=ptr->ai_next)
+   connectTmo = opt && opt->connectTmo ? opt->connectTmo : 0;
+   attemptTmo = opt && opt->attemptTmo ? opt->attemptTmo : SE_ATTEMPT_TMO;
+   attemptDelay = opt && opt->attemptDelay ?
+      opt->attemptDelay : SE_ATTEMPT_DELAY;
+   start = next = se_msTime();
+   for(;;)
    {
-      int sockfd;
-      sockfd=socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-      if(sockfd < 0)
+      U32 now = se_msTime();
+      int wait;
+      if(connectTmo && now - start >= connectTmo)
+         break;
+      /* Start the next attempt when due */
+      if(nextAddr < nAddr && (S32)(now - next) >= 0)
       {
-         retVal=-1;
+         int done;
+         int sockfd = se_startConnect(addr + nextAddr++,port,opt,&done);
+         if(sockfd < 0)
+         {
+            if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS)
+               retVal=-1;
+            continue; /* Try next address at once */
+         }
+         pfd[nActive].fd = sockfd;
+         pfd[nActive].events = POLLOUT;
+         started[nActive] = now;
+         if(done)
+         {
+            winner = nActive++;
+            break;
+         }
+         nActive++;
+         next = now + attemptDelay;
       }
-      else
+      /* Close attempts that timed out */
+      for(i=0 ; i < nActive ; )
       {
-         int nonBlock=1;
-         if(ptr->ai_family == AF_INET)
-            ((struct sockaddr_in*)ptr->ai_addr)->sin_port = htons(port);
-         else if(ptr->ai_family == AF_INET6)
-            ((struct sockaddr_in6*)ptr->ai_addr)->sin6_port = htons(port);
+         if(now - started[i] >= attemptTmo)
+         {
+            close(pfd[i].fd);
+            pfd[i] = pfd[--nActive];
+            started[i] = started[nActive];
+            next = now;
+         }
          else
-            goto L_close;
-         ioctl(sockfd, FIONBIO, &nonBlock);
-         if(connect(sockfd, ptr->ai_addr, ptr->ai_addrlen) < 0)
+            i++;
+      }
+      if(!nActive)
+      {
+         if(nextAddr < nAddr)
+            continue;
+         break;
+      }
+      /* Wait for an attempt to complete, the next attempt to be due,
+         or a timeout.
+      */
+      wait = (int)(attemptTmo - (now - started[0]));
+      for(i=1 ; i < nActive ; i++)
+      {
+         if((int)(attemptTmo - (now - started[i])) < wait)
+            wait = (int)(attemptTmo - (now - started[i]));
+      }
+      if(nextAddr < nAddr && (int)(next - now) < wait)
+         wait = (int)(next - now);
+      if(connectTmo && (int)(connectTmo - (now - start)) < wait)
+         wait = (int)(connectTmo - (now - start));
+      if(poll(pfd, nActive, wait < 0 ? 0 : wait) < 0 && errno != EINTR)
+         break;
+      for(i=0 ; i < nActive ; )
+      {
+         if(pfd[i].revents)
          {
-            if(errno == EINPROGRESS)
+            int err=0;
+            socklen_t size=sizeof(err);
+            if(!getsockopt(pfd[i].fd,SOL_SOCKET,SO_ERROR,&err,&size) &&
+               !err)
             {
-               struct timeval tv;
-               fd_set fds;
-               FD_ZERO(&fds);
-               FD_SET(sockfd, &fds);
-               tv.tv_sec = 4;
-               tv.tv_usec = 0;
-               if(select(sockfd + 1, 0, &fds, 0, &tv)==1)
-               {
-                  struct sockaddr_in6 in6;
-                  socklen_t size=sizeof(struct sockaddr_in6);
-                  if(!getpeername(sockfd, (struct sockaddr*)&in6, &size))
-                     goto L_ok;
-               }
+               winner=i;
+               break;
             }
-           L_close:
-            retVal=-3;
-            close(sockfd);
+            /* Failed: start the next attempt without delay */
+            close(pfd[i].fd);
+            pfd[i] = pfd[--nActive];
+            started[i] = started[nActive];
+            next = now;
          }
          else
+            i++;
+      }
+      if(winner >= 0)
+         break;
+   }
+   for(i=0 ; i < nActive ; i++)
+   {
+      if(i != winner)
+         close(pfd[i].fd);
+   }
+   if(winner >= 0)
+   {
+      int sockfd = pfd[winner].fd;
+      int nonBlock=0;
+      ioctl(sockfd, FIONBIO, &nonBlock);
+#ifdef SE_ZEROCOPY
+      /* May fail (old kernel): se_send then copies, see se_zcEnabled */
+      nonBlock=1;
+      se_zcSet(sockfd,
+               !setsockopt(sockfd,SOL_SOCKET,SO_ZEROCOPY,&nonBlock,sizeof(int)));
+#endif
+      *sock=sockfd;
+      retVal=0;
+   }
+   return retVal;
+}
+
+int se_connect(int* sock, const char* address, U16 port)
+{
+   return se_connectEx(sock, address, port, 0);
+}
+
+#if !defined(SE_URING) && !defined(SE_ZEROCOPY)
+/* Max regions per sendmsg call */
+#ifndef SE_SENDV_MAX
+#define SE_SENDV_MAX 8
+#endif
+
+#ifdef SE_TLS
+/* seTls.c implements se_sendv and calls this function for sockets
+   without TLS and for sockets with kernel TLS.
+*/
+#define se_sendv se_sendmsgv
+#endif
+#define X_se_sendv
+S32 se_sendv(int* sock, const SeIoVec* iov, int cnt)
+{
+   struct iovec v[SE_SENDV_MAX];
+   struct msghdr msg;
+   S32 sent=0;
+   int i;
+   while(cnt > 0)
+   {
+      int n = cnt > SE_SENDV_MAX ? SE_SENDV_MAX : cnt;
+      for(i=0 ; i < n ; i++)
+      {
+         v[i].iov_base = (void*)iov[i].data;
+         v[i].iov_len = iov[i].len;
+      }
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = v;
+      msg.msg_iovlen = n;
+      while(msg.msg_iovlen)
+      {
+         ssize_t x = sendmsg(*sock, &msg, 0);
+         if(x < 0)
          {
-           L_ok:
-            nonBlock=0;
-            ioctl(sockfd, FIONBIO, &nonBlock);
-            *sock=sockfd;
-            retVal=0;
-            break;
+            if(errno == EINTR)
+               continue;
+            return -1;
+         }
+         sent += (S32)x;
+         /* Skip the regions sent; adjust a partially sent region */
+         while(msg.msg_iovlen && (size_t)x >= msg.msg_iov->iov_len)
+         {
+            x -= (ssize_t)msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+         }
+         if(msg.msg_iovlen)
+         {
+            msg.msg_iov->iov_base = (U8*)msg.msg_iov->iov_base + x;
+            msg.msg_iov->iov_len -= (size_t)x;
          }
       }
+      iov += n;
+      cnt -= n;
    }
-   freeaddrinfo(result);
-   return retVal;
+   return sent;
+}
+#undef se_sendv
+#endif
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+/* Set 'addr' to 'path'. Returns the address length or -1 if too long */
+static socklen_t
+se_unixAddr(struct sockaddr_un* addr, const char* path)
+{
+   size_t len = strlen(path);
+   if(len == 0 || len >= sizeof(addr->sun_path))
+      return (socklen_t)-1;
+   memset(addr, 0, sizeof(*addr));
+   addr->sun_family = AF_UNIX;
+   memcpy(addr->sun_path, path, len);
+   if(*path == '@') /* Abstract: the name is not zero terminated */
+   {
+      addr->sun_path[0] = 0;
+      return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + len);
+   }
+   return (socklen_t)sizeof(*addr);
+}
+
+int se_connectUnix(int* sock, const char* path)
+{
+   struct sockaddr_un addr;
+   socklen_t len = se_unixAddr(&addr, path);
+   int sockfd;
+   if(len == (socklen_t)-1)
+      return -2;
+   if((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+      return -1;
+#ifdef SE_ZEROCOPY
+   se_zcSet(sockfd, 0); /* In case it was not closed with se_close */
+#endif
+   while(connect(sockfd, (struct sockaddr*)&addr, len))
+   {
+      if(errno != EINTR)
+      {
+         close(sockfd);
+         return -3;
+      }
+   }
+   *sock=sockfd;
+   return 0;
+}
+
+int se_bindUnix(int* sock, const char* path)
+{
+   struct sockaddr_un addr;
+   socklen_t len = se_unixAddr(&addr, path);
+   if(len == (socklen_t)-1)
+      return -3;
+   if((*sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+      return -1;
+   if(*path != '@')
+      unlink(path);
+   if(bind(*sock, (struct sockaddr*)&addr, len))
+   {
+      close(*sock);
+      *sock=-1;
+      return -3;
+   }
+   if(listen(*sock, SOMAXCONN))
+   {
+      close(*sock);
+      *sock=-1;
+      return -2;
+   }
+   return 0;
 }
+
+int se_peerCred(int* sock, SePeerCred* cred)
+{
+#ifdef SO_PEERCRED
+   /* Same layout as struct ucred, which requires _GNU_SOURCE */
+   struct { pid_t pid; uid_t uid; gid_t gid; } uc;
+   socklen_t len = sizeof(uc);
+   if(getsockopt(*sock, SOL_SOCKET, SO_PEERCRED, &uc, &len) ||
+      len != sizeof(uc))
+   {
+      return -1;
+   }
+   cred->pid = uc.pid;
+   cred->uid = uc.uid;
+   cred->gid = uc.gid;
+   return 0;
+#else
+   cred->pid = 0;
+   return getpeereid(*sock, &cred->uid, &cred->gid) ? -1 : 0;
 #endif
+}
+
+#ifdef SE_ZEROCOPY
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/uio.h>
+
+U32 se_zcThreshold = SE_ZEROCOPY_THRESHOLD;
+SeZcStats se_zcStats;
+
+/* Returns TRUE if 'sock' is a TCP/IP socket with SO_ZEROCOPY enabled.
+   The kernel keeps this flag per socket: it is set by se_connectEx and
+   not set for sockets from se_accept. MSG_ZEROCOPY on a socket without
+   the flag copies the data and queues no notification, thus se_zcWait
+   would never return. AF_UNIX sockets (se_connectUnix) never use zero
+   copy: they have no notifications on the IP error queue.
+   se_zcFds caches the flag, so only descriptors beyond the table cost
+   getsockopt calls.
+*/
+static int
+se_zcEnabled(int sock)
+{
+   int val=0;
+   socklen_t size=sizeof(val);
+   if(sock >= 0 && sock < SE_ZEROCOPY_MAXFD)
+      return se_zcFds[sock];
+   if(getsockopt(sock,SOL_SOCKET,SO_DOMAIN,&val,&size) ||
+      (val != AF_INET && val != AF_INET6))
+   {
+      return 0;
+   }
+   val=0;
+   size=sizeof(val);
+   return !getsockopt(sock,SOL_SOCKET,SO_ZEROCOPY,&val,&size) && val;
+}
+
+
+/* Max time in milliseconds to wait for notifications: SO_SNDTIMEO if
+   set, otherwise SE_ZEROCOPY_TMO.
+*/
+static U32
+se_zcTmo(int sock)
+{
+   struct timeval tv;
+   socklen_t size=sizeof(tv);
+   if(!getsockopt(sock,SOL_SOCKET,SO_SNDTIMEO,&tv,&size) &&
+      (tv.tv_sec || tv.tv_usec))
+   {
+      return (U32)tv.tv_sec * 1000 + (U32)(tv.tv_usec / 1000);
+   }
+   return SE_ZEROCOPY_TMO;
+}
+
+
+/* Read zero copy notifications from the error queue until 'pending'
+   sendmsg calls are released. Returns 0, or -1 on socket error or
+   timeout, see se_zcTmo.
+*/
+static int
+se_zcWait(int sock, U32 pending)
+{
+   U8 control[128];
+   U32 tmo = pending ? se_zcTmo(sock) : 0;
+   U32 start = se_msTime();
+   while(pending)
+   {
+      struct msghdr msg;
+      struct cmsghdr* cm;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if(recvmsg(sock, &msg, MSG_ERRQUEUE) < 0)
+      {
+         struct pollfd pfd;
+         U32 elapsed;
+         if(errno == EINTR)
+            continue;
+         if(errno != EAGAIN && errno != EWOULDBLOCK)
+            return -1;
+         elapsed = se_msTime() - start;
+         if(elapsed >= tmo)
+            return -1;
+         pfd.fd = sock;
+         pfd.events = 0; /* POLLERR is always reported */
+         pfd.revents = 0;
+         if(poll(&pfd, 1, (int)(tmo - elapsed)) < 0 && errno != EINTR)
+            return -1;
+         if(pfd.revents & (POLLHUP|POLLNVAL))
+            return -1;
+         continue;
+      }
+      for(cm = CMSG_FIRSTHDR(&msg) ; cm ; cm = CMSG_NXTHDR(&msg, cm))
+      {
+         struct sock_extended_err* ee;
+         if(!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+              (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+         {
+            continue;
+         }
+         ee = (struct sock_extended_err*)CMSG_DATA(cm);
+         if(ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            continue;
+         if(ee->ee_errno)
+            return -1;
+         /* Notification covers the range ee_info..ee_data */
+         se_zcStats.completions++;
+         if(ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            se_zcStats.copied++;
+         pending -= (ee->ee_data - ee->ee_info + 1) > pending ?
+            pending : (ee->ee_data - ee->ee_info + 1);
+      }
+   }
+   return 0;
+}
+
+
+#define X_se_close
+void se_close(int* sock)
+{
+   se_zcSet(*sock, 0);
+   close(*sock);
+   *sock=-1;
+}
+
+
+#define X_se_send
+S32 se_send(int* sock, const void* buf, U32 len)
+{
+   const U8* ptr = (const U8*)buf;
+   U32 left = len;
+   U32 pending = 0;
+   int flags = MSG_ZEROCOPY;
+   if(len < se_zcThreshold || !se_zcEnabled(*sock))
+      return send(*sock,(void*)buf,len,0);
+   while(left)
+   {
+      struct msghdr msg;
+      struct iovec iov;
+      ssize_t x;
+      iov.iov_base = (void*)ptr;
+      iov.iov_len = left;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      x = sendmsg(*sock, &msg, flags);
+      if(x < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         if(errno == ENOBUFS && flags)
+         {  /* Out of optmem for pinned pages: copy the remainder */
+            se_zcStats.fallbacks++;
+            flags = 0;
+            continue;
+         }
+         se_zcWait(*sock, pending);
+         return -1;
+      }
+      if(flags)
+      {
+         se_zcStats.sends++;
+         pending++;
+      }
+      ptr += x;
+      left -= (U32)x;
+   }
+   return se_zcWait(*sock, pending) ? -1 : (S32)len;
+}
+#endif /* SE_ZEROCOPY */
 #endif
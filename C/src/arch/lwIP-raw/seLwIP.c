@@ -476,10 +476,18 @@ SeCtx_run(SeCtx* ctx)
          }
       }
    }
+#ifdef SECTX_SWITCH
+   else
+   {
+      (void)stackMark;
+      return SeCtx_start(ctx); /* Run task on its own stack */
+   }
+#else
    else if( ! SeCtx_setStackTop(ctx, &stackMark) )
    {
       ctx->task(ctx);
       return -1;
    }
+#endif
    return 0;
 }
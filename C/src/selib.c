@@ -89,6 +89,92 @@ int se_connect(SOCKET* sock, const char* address, U16 port)
 #endif
 
 
+#ifndef X_se_connectEx
+int se_connectEx(SOCKET* sock, const char* address, U16 port,
+                 const SeSockOpt* opt)
+{
+   int status = se_connect(sock, address, port);
+   if(!status && opt)
+      se_setSockOpt(sock, opt);
+   return status;
+}
+#endif
+
+
+#ifndef X_se_setSockOpt
+static int
+se_setInt(SOCKET sock, int level, int name, int val)
+{
+   return setsockopt(sock, level, name, (const char*)&val, sizeof(int));
+}
+
+int se_setSockOpt(SOCKET* sock, const SeSockOpt* opt)
+{
+   int status = 0;
+#ifdef SO_SNDBUF
+   if(opt->sndBuf)
+      status |= se_setInt(*sock, SOL_SOCKET, SO_SNDBUF, (int)opt->sndBuf);
+#endif
+#ifdef SO_RCVBUF
+   if(opt->rcvBuf)
+      status |= se_setInt(*sock, SOL_SOCKET, SO_RCVBUF, (int)opt->rcvBuf);
+#endif
+#ifdef TCP_NODELAY
+   if(opt->noDelay)
+      status |= se_setInt(*sock, IPPROTO_TCP, TCP_NODELAY, 1);
+#endif
+#ifdef TCP_QUICKACK
+   if(opt->quickAck)
+      status |= se_setInt(*sock, IPPROTO_TCP, TCP_QUICKACK, 1);
+#endif
+#ifdef SO_KEEPALIVE
+   if(opt->keepAlive)
+   {
+      status |= se_setInt(*sock, SOL_SOCKET, SO_KEEPALIVE, 1);
+#ifdef TCP_KEEPIDLE
+      if(opt->keepIdle)
+         status |= se_setInt(*sock,IPPROTO_TCP,TCP_KEEPIDLE,(int)opt->keepIdle);
+#endif
+#ifdef TCP_KEEPINTVL
+      if(opt->keepIntvl)
+         status|=se_setInt(*sock,IPPROTO_TCP,TCP_KEEPINTVL,(int)opt->keepIntvl);
+#endif
+#ifdef TCP_KEEPCNT
+      if(opt->keepCnt)
+         status |= se_setInt(*sock,IPPROTO_TCP,TCP_KEEPCNT,(int)opt->keepCnt);
+#endif
+   }
+#endif
+#ifdef TCP_USER_TIMEOUT
+   if(opt->userTimeout)
+      status |= se_setInt(*sock, IPPROTO_TCP, TCP_USER_TIMEOUT,
+                          (int)opt->userTimeout);
+#endif
+#if defined(IP_TOS) && defined(IPV6_TCLASS)
+   if(opt->tos >= 0)
+   {  /* IP_TOS succeeds on a Linux AF_INET6 socket, but has no effect */
+      struct sockaddr_storage addr;
+      socklen_t len = sizeof(addr);
+      if(getsockname(*sock, (struct sockaddr*)&addr, &len))
+         status = -1;
+      else if(addr.ss_family == AF_INET6)
+         status |= se_setInt(*sock, IPPROTO_IPV6, IPV6_TCLASS, opt->tos);
+      else if(addr.ss_family == AF_INET)
+         status |= se_setInt(*sock, IPPROTO_IP, IP_TOS, opt->tos);
+   }
+#elif defined(IP_TOS)
+   if(opt->tos >= 0)
+      status |= se_setInt(*sock, IPPROTO_IP, IP_TOS, opt->tos);
+#endif
+#ifdef SO_PRIORITY
+   if(opt->priority >= 0)
+      status |= se_setInt(*sock, SOL_SOCKET, SO_PRIORITY, opt->priority);
+#endif
+   return status ? -1 : 0;
+}
+#endif
+
+
 #ifndef X_se_bind
 int se_bind(SOCKET* sock, U16 port)
 {
@@ -144,11 +230,13 @@ int se_accept(SOCKET** listenSock, U32 timeout, SOCKET** outSock)
 }
 
 
+#ifndef X_se_close
 void se_close(SOCKET* sock)
 {
    closesocket(*sock);
    *sock=-1;
 }
+#endif
 
 
 int se_sockValid(SOCKET* sock)
@@ -157,10 +245,12 @@ int se_sockValid(SOCKET* sock)
 }
 
 
+#ifndef X_se_send
 S32 se_send(SOCKET* sock, const void* buf, U32 len)
 {
    return send(*sock,(void*)buf,len,0);
 }
+#endif
 
 
 #ifndef X_se_recv
@@ -192,6 +282,25 @@ S32 se_recv(SOCKET* sock, void* buf, U32 len, U32 timeout)
 #endif /* NO_BSD_SOCK */
 
 
+#ifndef X_se_sendv
+S32 se_sendv(SOCKET* sock, const SeIoVec* iov, int cnt)
+{
+   S32 sent=0;
+   for( ; cnt > 0 ; iov++, cnt--)
+   {
+      if(iov->len)
+      {
+         S32 x = se_send(sock, iov->data, iov->len);
+         if(x < 0)
+            return x;
+         sent += x;
+      }
+   }
+   return sent;
+}
+#endif
+
+
 #if SE_SHA1
 #include <string.h>
 
@@ -228,29 +337,12 @@ static const U8 sharkSslHashPadding[64] =
  *  SHA-1 implementation based on FIPS PUB 180-3
  *  http://csrc.nist.gov/publications/fips/fips180-3/fips180-3_final.pdf
  */
-static void SharkSslSha1Ctx_process(SharkSslSha1Ctx *ctx, const U8 data[64])
+static void sha1Scalar(U32 state[5], const U8* data, U32 blocks)
 {
    U32 a, b, c, d, e, temp;
    unsigned int i;
    U32 W[16];
 
-   GET_U32_BE(W[0],  data,  0);
-   GET_U32_BE(W[1],  data,  4);
-   GET_U32_BE(W[2],  data,  8);
-   GET_U32_BE(W[3],  data, 12);
-   GET_U32_BE(W[4],  data, 16);
-   GET_U32_BE(W[5],  data, 20);
-   GET_U32_BE(W[6],  data, 24);
-   GET_U32_BE(W[7],  data, 28);
-   GET_U32_BE(W[8],  data, 32);
-   GET_U32_BE(W[9],  data, 36);
-   GET_U32_BE(W[10], data, 40);
-   GET_U32_BE(W[11], data, 44);
-   GET_U32_BE(W[12], data, 48);
-   GET_U32_BE(W[13], data, 52);
-   GET_U32_BE(W[14], data, 56);
-   GET_U32_BE(W[15], data, 60);
-
    #define ROTL(x,n) ((U32)((U32)x << n) | ((U32)x >> (32 - n)))
 
    #define Ft1(x,y,z) ((x & (y ^ z)) ^ z)  /* equivalent to ((x & y) ^ ((~x) & z)) */
@@ -263,49 +355,69 @@ static void SharkSslSha1Ctx_process(SharkSslSha1Ctx *ctx, const U8 data[64])
    #define K3 0x8F1BBCDC
    #define K4 0xCA62C1D6
 
-   a = ctx->state[0];
-   b = ctx->state[1];
-   c = ctx->state[2];
-   d = ctx->state[3];
-   e = ctx->state[4];
-
-   for (i = 0; i < 80; i++)
+   for( ; blocks ; blocks--, data += 64)
    {
-      if (i >= 16)
-      {
-         temp = W[i & 0xF] ^ W[(i + 2) & 0xF] ^ W[(i + 8) & 0xF] ^ W[(i + 13) & 0xF];
-         W[i & 0xF] = temp = ROTL(temp, 1);
-      }
-      temp = W[i & 0xF];
-      temp += e + ROTL(a, 5);
-      if (i < 20)
+      GET_U32_BE(W[0],  data,  0);
+      GET_U32_BE(W[1],  data,  4);
+      GET_U32_BE(W[2],  data,  8);
+      GET_U32_BE(W[3],  data, 12);
+      GET_U32_BE(W[4],  data, 16);
+      GET_U32_BE(W[5],  data, 20);
+      GET_U32_BE(W[6],  data, 24);
+      GET_U32_BE(W[7],  data, 28);
+      GET_U32_BE(W[8],  data, 32);
+      GET_U32_BE(W[9],  data, 36);
+      GET_U32_BE(W[10], data, 40);
+      GET_U32_BE(W[11], data, 44);
+      GET_U32_BE(W[12], data, 48);
+      GET_U32_BE(W[13], data, 52);
+      GET_U32_BE(W[14], data, 56);
+      GET_U32_BE(W[15], data, 60);
+
+      a = state[0];
+      b = state[1];
+      c = state[2];
+      d = state[3];
+      e = state[4];
+
+      for (i = 0; i < 80; i++)
       {
-         temp += Ft1(b,c,d) + K1;
+         if (i >= 16)
+         {
+            temp = W[i & 0xF] ^ W[(i + 2) & 0xF] ^ W[(i + 8) & 0xF] ^ W[(i + 13) & 0xF];
+            W[i & 0xF] = temp = ROTL(temp, 1);
+         }
+         temp = W[i & 0xF];
+         temp += e + ROTL(a, 5);
+         if (i < 20)
+         {
+            temp += Ft1(b,c,d) + K1;
+         }
+         else if (i < 40)
+         {
+            temp += Ft2(b,c,d) + K2;
+         }
+         else if (i < 60)
+         {
+            temp += Ft3(b,c,d) + K3;
+         }
+         else
+         {
+            temp += Ft4(b,c,d) + K4;
+         }
+         e = d;
+         d = c;
+         c = ROTL(b, 30);
+         b = a;
+         a = temp;
       }
-      else if (i < 40)
-      {
-         temp += Ft2(b,c,d) + K2;
-      }
-      else if (i < 60)
-      {
-         temp += Ft3(b,c,d) + K3;
-      }
-      else
-      {
-         temp += Ft4(b,c,d) + K4;
-      }
-      e = d;
-      d = c;
-      c = ROTL(b, 30);
-      b = a;
-      a = temp;
-   }
 
-   ctx->state[0] += a;
-   ctx->state[1] += b;
-   ctx->state[2] += c;
-   ctx->state[3] += d;
-   ctx->state[4] += e;
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+   }
 
    #undef K4
    #undef K3
@@ -321,6 +433,280 @@ static void SharkSslSha1Ctx_process(SharkSslSha1Ctx *ctx, const U8 data[64])
 }
 
 
+#if SE_SHA1_ACCEL
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#include <cpuid.h>
+
+/* SHA-NI: four rounds per sha1rnds4 instruction. Each group of four
+   rounds uses one message vector, and the message schedule for the
+   later groups is computed from the previous four vectors. Groups 0-3
+   load the block and groups 4-19 are identical except for the
+   rotation of the vectors and the round function (g/5).
+ */
+#define SHA1NI_GROUP(g, ma, mb, mc, md, ea, eb)     \
+   ea = _mm_sha1nexte_epu32(ea, ma);                \
+   eb = abcd;                                       \
+   mb = _mm_sha1msg2_epu32(mb, ma);                 \
+   abcd = _mm_sha1rnds4_epu32(abcd, ea, (g) / 5);   \
+   md = _mm_sha1msg1_epu32(md, ma);                 \
+   mc = _mm_xor_si128(mc, ma)
+
+__attribute__((target("sha,sse4.1")))
+static void sha1Hw(U32 state[5], const U8* data, U32 blocks)
+{
+   __m128i abcd, abcdSave, e0, e0Save, e1, m0, m1, m2, m3;
+   const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL,
+                                        0x08090A0B0C0D0E0FLL);
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+   e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+   for( ; blocks ; blocks--, data += 64)
+   {
+      abcdSave = abcd;
+      e0Save = e0;
+      m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), bswap);
+      e0 = _mm_add_epi32(e0, m0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+16)),bswap);
+      e1 = _mm_sha1nexte_epu32(e1, m1);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+      m0 = _mm_sha1msg1_epu32(m0, m1);
+      m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+32)),bswap);
+      e0 = _mm_sha1nexte_epu32(e0, m2);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      m1 = _mm_sha1msg1_epu32(m1, m2);
+      m0 = _mm_xor_si128(m0, m2);
+      m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+48)),bswap);
+      SHA1NI_GROUP(3,  m3, m0, m1, m2, e1, e0);
+      SHA1NI_GROUP(4,  m0, m1, m2, m3, e0, e1);
+      SHA1NI_GROUP(5,  m1, m2, m3, m0, e1, e0);
+      SHA1NI_GROUP(6,  m2, m3, m0, m1, e0, e1);
+      SHA1NI_GROUP(7,  m3, m0, m1, m2, e1, e0);
+      SHA1NI_GROUP(8,  m0, m1, m2, m3, e0, e1);
+      SHA1NI_GROUP(9,  m1, m2, m3, m0, e1, e0);
+      SHA1NI_GROUP(10, m2, m3, m0, m1, e0, e1);
+      SHA1NI_GROUP(11, m3, m0, m1, m2, e1, e0);
+      SHA1NI_GROUP(12, m0, m1, m2, m3, e0, e1);
+      SHA1NI_GROUP(13, m1, m2, m3, m0, e1, e0);
+      SHA1NI_GROUP(14, m2, m3, m0, m1, e0, e1);
+      SHA1NI_GROUP(15, m3, m0, m1, m2, e1, e0);
+      SHA1NI_GROUP(16, m0, m1, m2, m3, e0, e1);
+      SHA1NI_GROUP(17, m1, m2, m3, m0, e1, e0);
+      SHA1NI_GROUP(18, m2, m3, m0, m1, e0, e1);
+      SHA1NI_GROUP(19, m3, m0, m1, m2, e1, e0);
+      e0 = _mm_sha1nexte_epu32(e0, e0Save);
+      abcd = _mm_add_epi32(abcd, abcdSave);
+   }
+   _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+   state[4] = (U32)_mm_extract_epi32(e0, 3);
+}
+#undef SHA1NI_GROUP
+
+
+/* AVX2: the 80 rounds of the portable implementation on 8 independent
+   blocks, one block per 32-bit lane. 'st' is the state of the 8
+   messages, word major.
+ */
+#define SHA1_LANES 8
+
+#define V_ROTL(x,n) _mm256_or_si256(_mm256_slli_epi32(x,n),               \
+                                    _mm256_srli_epi32(x,32-(n)))
+#define V_FT1(x,y,z) _mm256_xor_si256(_mm256_and_si256(x,                  \
+                                      _mm256_xor_si256(y,z)),z)
+#define V_FT2(x,y,z) _mm256_xor_si256(_mm256_xor_si256(x,y),z)
+#define V_FT3(x,y,z) _mm256_or_si256(_mm256_and_si256(x,y),                \
+                        _mm256_and_si256(_mm256_or_si256(x,y),z))
+#define V_ROUND(i, ft, k)                                                 \
+   if((i) >= 16)                                                          \
+   {                                                                      \
+      t = _mm256_xor_si256(_mm256_xor_si256(w[(i)&15], w[((i)+2)&15]),   \
+                           _mm256_xor_si256(w[((i)+8)&15], w[((i)+13)&15]));\
+      w[(i)&15] = V_ROTL(t, 1);                                           \
+   }                                                                      \
+   t = _mm256_add_epi32(_mm256_add_epi32(w[(i)&15], e),                   \
+                        _mm256_add_epi32(V_ROTL(a, 5), k));               \
+   t = _mm256_add_epi32(t, ft(b,c,d));                                    \
+   e = d;                                                                 \
+   d = c;                                                                 \
+   c = V_ROTL(b, 30);                                                     \
+   b = a;                                                                 \
+   a = t
+
+__attribute__((target("avx2")))
+static void sha1Avx2(U32 st[5][SHA1_LANES], const U8* const p[SHA1_LANES])
+{
+   __m256i a, b, c, d, e, t, k, w[16];
+   int i;
+   for(i = 0 ; i < 16 ; i++)
+   {
+      U32 x[SHA1_LANES];
+      int j;
+      for(j = 0 ; j < SHA1_LANES ; j++)
+         GET_U32_BE(x[j], p[j], 4*i);
+      w[i] = _mm256_loadu_si256((const __m256i*)x);
+   }
+   a = _mm256_loadu_si256((const __m256i*)st[0]);
+   b = _mm256_loadu_si256((const __m256i*)st[1]);
+   c = _mm256_loadu_si256((const __m256i*)st[2]);
+   d = _mm256_loadu_si256((const __m256i*)st[3]);
+   e = _mm256_loadu_si256((const __m256i*)st[4]);
+   k = _mm256_set1_epi32(0x5A827999);
+   for(i = 0 ; i < 20 ; i++) { V_ROUND(i, V_FT1, k); }
+   k = _mm256_set1_epi32(0x6ED9EBA1);
+   for( ; i < 40 ; i++) { V_ROUND(i, V_FT2, k); }
+   k = _mm256_set1_epi32((int)0x8F1BBCDC);
+   for( ; i < 60 ; i++) { V_ROUND(i, V_FT3, k); }
+   k = _mm256_set1_epi32((int)0xCA62C1D6);
+   for( ; i < 80 ; i++) { V_ROUND(i, V_FT2, k); }
+   _mm256_storeu_si256((__m256i*)st[0], _mm256_add_epi32(
+      a, _mm256_loadu_si256((const __m256i*)st[0])));
+   _mm256_storeu_si256((__m256i*)st[1], _mm256_add_epi32(
+      b, _mm256_loadu_si256((const __m256i*)st[1])));
+   _mm256_storeu_si256((__m256i*)st[2], _mm256_add_epi32(
+      c, _mm256_loadu_si256((const __m256i*)st[2])));
+   _mm256_storeu_si256((__m256i*)st[3], _mm256_add_epi32(
+      d, _mm256_loadu_si256((const __m256i*)st[3])));
+   _mm256_storeu_si256((__m256i*)st[4], _mm256_add_epi32(
+      e, _mm256_loadu_si256((const __m256i*)st[4])));
+}
+#undef V_ROUND
+#undef V_FT3
+#undef V_FT2
+#undef V_FT1
+#undef V_ROTL
+
+
+static U32 sha1Caps(void)
+{
+   unsigned int a, b, c, d;
+   U32 caps = 1 << SE_SHA1_SCALAR;
+   if(__builtin_cpu_supports("avx2"))
+      caps |= 1 << SE_SHA1_SIMD;
+   if(__get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSSE3) && (c & bit_SSE4_1) &&
+      __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_SHA))
+   {
+      caps |= 1 << SE_SHA1_HW;
+   }
+   return caps;
+}
+
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif
+#endif
+
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#define SHA1_HW_TARGET
+#else
+#define SHA1_HW_TARGET __attribute__((target("+crypto")))
+#endif
+
+/* ARMv8 crypto extension: four rounds per sha1c/sha1p/sha1m
+   instruction. 'ea' is the E value for this group and 'eb' receives
+   the E value for the next group; 'wk' is the message plus round
+   constant for this group and is loaded with the value for the group
+   after the next.
+ */
+#define SHA1A64_GROUP(op, ea, eb, wk, k, m0, m1, m2, m3)   \
+   eb = vsha1h_u32(vgetq_lane_u32(abcd, 0));               \
+   abcd = op(abcd, ea, wk);                                \
+   wk = vaddq_u32(m2, k);                                  \
+   m3 = vsha1su1q_u32(m3, m2);                             \
+   m0 = vsha1su0q_u32(m0, m1, m2)
+
+SHA1_HW_TARGET
+static void sha1Hw(U32 state[5], const U8* data, U32 blocks)
+{
+   uint32x4_t abcd, abcdSave, wk0, wk1, m0, m1, m2, m3;
+   const uint32x4_t k1 = vdupq_n_u32(0x5A827999);
+   const uint32x4_t k2 = vdupq_n_u32(0x6ED9EBA1);
+   const uint32x4_t k3 = vdupq_n_u32(0x8F1BBCDC);
+   const uint32x4_t k4 = vdupq_n_u32(0xCA62C1D6);
+   uint32_t e0, e0Save, e1;
+   abcd = vld1q_u32(state);
+   e0 = state[4];
+   for( ; blocks ; blocks--, data += 64)
+   {
+      abcdSave = abcd;
+      e0Save = e0;
+      m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+      m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+      m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+      m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+      wk0 = vaddq_u32(m0, k1);
+      wk1 = vaddq_u32(m1, k1);
+      e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+      abcd = vsha1cq_u32(abcd, e0, wk0);
+      wk0 = vaddq_u32(m2, k1);
+      m0 = vsha1su0q_u32(m0, m1, m2);
+      SHA1A64_GROUP(vsha1cq_u32, e1, e0, wk1, k1, m1, m2, m3, m0);
+      SHA1A64_GROUP(vsha1cq_u32, e0, e1, wk0, k1, m2, m3, m0, m1);
+      SHA1A64_GROUP(vsha1cq_u32, e1, e0, wk1, k2, m3, m0, m1, m2);
+      SHA1A64_GROUP(vsha1cq_u32, e0, e1, wk0, k2, m0, m1, m2, m3);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k2, m1, m2, m3, m0);
+      SHA1A64_GROUP(vsha1pq_u32, e0, e1, wk0, k2, m2, m3, m0, m1);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k2, m3, m0, m1, m2);
+      SHA1A64_GROUP(vsha1pq_u32, e0, e1, wk0, k3, m0, m1, m2, m3);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k3, m1, m2, m3, m0);
+      SHA1A64_GROUP(vsha1mq_u32, e0, e1, wk0, k3, m2, m3, m0, m1);
+      SHA1A64_GROUP(vsha1mq_u32, e1, e0, wk1, k3, m3, m0, m1, m2);
+      SHA1A64_GROUP(vsha1mq_u32, e0, e1, wk0, k3, m0, m1, m2, m3);
+      SHA1A64_GROUP(vsha1mq_u32, e1, e0, wk1, k4, m1, m2, m3, m0);
+      SHA1A64_GROUP(vsha1mq_u32, e0, e1, wk0, k4, m2, m3, m0, m1);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k4, m3, m0, m1, m2);
+      SHA1A64_GROUP(vsha1pq_u32, e0, e1, wk0, k4, m0, m1, m2, m3);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k4, m1, m2, m3, m0);
+      SHA1A64_GROUP(vsha1pq_u32, e0, e1, wk0, k4, m2, m3, m0, m1);
+      SHA1A64_GROUP(vsha1pq_u32, e1, e0, wk1, k4, m3, m0, m1, m2);
+      e0 += e0Save;
+      abcd = vaddq_u32(abcd, abcdSave);
+   }
+   vst1q_u32(state, abcd);
+   state[4] = e0;
+}
+#undef SHA1A64_GROUP
+
+
+static U32 sha1Caps(void)
+{
+   U32 caps = 1 << SE_SHA1_SCALAR;
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2) || \
+   defined(__APPLE__)
+   caps |= 1 << SE_SHA1_HW;
+#else
+   if(getauxval(AT_HWCAP) & HWCAP_SHA1)
+      caps |= 1 << SE_SHA1_HW;
+#endif
+   return caps;
+}
+#endif /* __aarch64__ */
+
+
+static void sha1Init(U32 state[5], const U8* data, U32 blocks);
+static void (*sha1Blocks)(U32 state[5], const U8* data, U32 blocks) = sha1Init;
+static int sha1Impl = SE_SHA1_AUTO;
+
+/* Select the implementation on first use */
+static void sha1Init(U32 state[5], const U8* data, U32 blocks)
+{
+   se_sha1Select(SE_SHA1_AUTO);
+   sha1Blocks(state, data, blocks);
+}
+
+#define SHA1_BLOCKS(state, data, blocks) sha1Blocks(state, data, blocks)
+#else
+#define SHA1_BLOCKS(state, data, blocks) sha1Scalar(state, data, blocks)
+#endif /* SE_SHA1_ACCEL */
+
+
 void SharkSslSha1Ctx_constructor(SharkSslSha1Ctx *ctx)
 {
    /* ASSERT(((unsigned int)(ctx->buffer) & (sizeof(int)-1)) == 0); */
@@ -352,17 +738,17 @@ void SharkSslSha1Ctx_append(SharkSslSha1Ctx *ctx, const U8 *in, U32 len)
    if((left) && (len >= fill))
    {
       memcpy((ctx->buffer + left), in, fill);
-      SharkSslSha1Ctx_process(ctx, ctx->buffer);
+      SHA1_BLOCKS(ctx->state, ctx->buffer, 1);
       len -= fill;
       in  += fill;
       left = 0;
    }
 
-   while (len >= 64)
+   if (len >= 64)
    {
-      SharkSslSha1Ctx_process(ctx, in);
-      len -= 64;
-      in  += 64;
+      SHA1_BLOCKS(ctx->state, in, len >> 6);
+      in  += len & ~0x3F;
+      len &= 0x3F;
    }
 
    if (len)
@@ -396,4 +782,136 @@ void SharkSslSha1Ctx_finish(SharkSslSha1Ctx *ctx, U8 digest[20])
    PUT_U32_BE(ctx->state[3], digest, 12);
    PUT_U32_BE(ctx->state[4], digest, 16);
 }
+
+
+#if SE_SHA1_ACCEL
+int se_sha1Select(int impl)
+{
+   U32 caps = sha1Caps();
+   if(impl == SE_SHA1_AUTO)
+   {
+      impl = (caps & (1 << SE_SHA1_HW)) ? SE_SHA1_HW :
+         ((caps & (1 << SE_SHA1_SIMD)) ? SE_SHA1_SIMD : SE_SHA1_SCALAR);
+   }
+   else if(impl < SE_SHA1_SCALAR || impl > SE_SHA1_HW || !(caps & (1 << impl)))
+      return -1;
+   sha1Blocks = impl == SE_SHA1_HW ? sha1Hw : sha1Scalar;
+   sha1Impl = impl;
+   return impl;
+}
+#else
+int se_sha1Select(int impl)
+{
+   return impl == SE_SHA1_AUTO || impl == SE_SHA1_SCALAR ? SE_SHA1_SCALAR : -1;
+}
+#endif
+
+
+#if SE_SHA1_ACCEL && defined(__x86_64__)
+
+/* One message in the multi-buffer implementation. The full blocks are
+   read from the message and the last partial block and the padding
+   are assembled in 'tail'.
+ */
+typedef struct
+{
+   const U8* data;
+   U8* digest; /* NULL if the lane is idle */
+   U32 full; /* Number of full blocks in 'data' */
+   U32 blocks; /* Total number of blocks including the padding */
+   U32 ix; /* Next block */
+   U8 tail[128];
+} Sha1Lane;
+
+
+static void
+Sha1Lane_init(Sha1Lane* o, const U8* data, U32 len, U8* digest)
+{
+   U32 rem = len & 0x3F;
+   U32 end = rem < 56 ? 64 : 128;
+   o->data = data;
+   o->digest = digest;
+   o->full = len >> 6;
+   o->blocks = o->full + end / 64;
+   o->ix = 0;
+   memcpy(o->tail, data + (len & ~0x3F), rem);
+   memcpy(o->tail + rem, sharkSslHashPadding, 64);
+   PUT_U32_BE(len >> 29, o->tail, end - 8);
+   PUT_U32_BE(len << 3, o->tail, end - 4);
+}
+
+
+static void
+sha1MultiAvx2(const U8* const data[], const U32 len[], U8* digest, U32 n)
+{
+   static const U32 iv[5] = {
+      0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+   };
+   Sha1Lane lanes[SHA1_LANES];
+   U32 st[5][SHA1_LANES];
+   const U8* p[SHA1_LANES];
+   U32 next = 0, active = 0, i, j;
+   for(i = 0 ; i < SHA1_LANES ; i++)
+      lanes[i].digest = 0;
+   for(;;)
+   {
+      for(i = 0 ; i < SHA1_LANES ; i++)
+      {
+         Sha1Lane* l = lanes + i;
+         if(!l->digest && next < n)
+         {
+            Sha1Lane_init(l, data[next], len[next],
+                          digest + next * SHARKSSL_SHA1_HASH_LEN);
+            next++;
+            active++;
+            for(j = 0 ; j < 5 ; j++)
+               st[j][i] = iv[j];
+         }
+         if(l->digest)
+         {
+            p[i] = l->ix < l->full ? l->data + (l->ix << 6) :
+               l->tail + ((l->ix - l->full) << 6);
+         }
+         else
+            p[i] = sharkSslHashPadding; /* Idle lane: any 64 bytes */
+      }
+      if(!active)
+         break;
+      sha1Avx2(st, p);
+      for(i = 0 ; i < SHA1_LANES ; i++)
+      {
+         Sha1Lane* l = lanes + i;
+         if(l->digest && ++l->ix == l->blocks)
+         {
+            for(j = 0 ; j < 5 ; j++)
+               PUT_U32_BE(st[j][i], l->digest, 4*j);
+            l->digest = 0;
+            active--;
+         }
+      }
+   }
+}
+#endif
+
+
+void se_sha1Multi(const U8* const data[], const U32 len[], U8* digest, U32 n)
+{
+   U32 i;
+#if SE_SHA1_ACCEL && defined(__x86_64__)
+   if(sha1Blocks == sha1Init)
+      se_sha1Select(SE_SHA1_AUTO);
+   if(sha1Impl == SE_SHA1_SIMD)
+   {
+      sha1MultiAvx2(data, len, digest, n);
+      return;
+   }
+#endif
+   for(i = 0 ; i < n ; i++)
+   {
+      SharkSslSha1Ctx ctx;
+      SharkSslSha1Ctx_constructor(&ctx);
+      SharkSslSha1Ctx_append(&ctx, data[i], len[i]);
+      SharkSslSha1Ctx_finish(&ctx, digest + i * SHARKSSL_SHA1_HASH_LEN);
+   }
+}
 #endif
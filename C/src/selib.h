@@ -49,6 +49,23 @@
 #define SE_SHA1 1
 #endif
 
+/*
+  SE_SHA1_ACCEL enables the SHA-NI (x86-64) and ARMv8 crypto extension
+  SHA-1 implementations and the AVX2 multi-buffer implementation. The
+  implementation is selected at runtime with CPUID or HWCAP and the
+  portable implementation is used on CPUs without these extensions.
+*/
+#ifndef SE_SHA1_ACCEL
+#if SE_SHA1 && defined(__GNUC__) && (defined(__x86_64__) ||            \
+   (defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__)) && \
+    (!defined(__clang__) || defined(__ARM_FEATURE_CRYPTO) ||           \
+     defined(__ARM_FEATURE_SHA2))))
+#define SE_SHA1_ACCEL 1
+#else
+#define SE_SHA1_ACCEL 0
+#endif
+#endif
+
 
 /** @addtogroup selib
 @{
@@ -90,8 +107,106 @@ typedef signed   long long S64;
  */
 #define INFINITE_TMO (~((U32)0))
 
+/** Per-connection socket options used by #se_connectEx. Initialize
+    with #SeSockOpt_constructor, which sets all options to "use the
+    TCP/IP stack's default", and then set the options you need. An
+    option not supported by the TCP/IP stack is ignored.
+ */
+typedef struct SeSockOpt
+{
+   /** SO_SNDBUF in bytes, zero for default. A buffer that holds
+       bandwidth x round-trip time increases throughput for large
+       publishes on long links. A small buffer limits the data queued
+       in the kernel, thus reducing latency for messages sent after a
+       large message.
+   */
+   U32 sndBuf;
+   /** SO_RCVBUF in bytes, zero for default. Set before connecting so
+       TCP can negotiate a matching window scale. Increases throughput
+       when receiving large messages on long links.
+   */
+   U32 rcvBuf;
+   /** TCP_KEEPIDLE: seconds of idle time before the first keepalive
+       probe, zero for default. Requires keepAlive. Lower values detect
+       dead connections and NAT timeouts sooner at the cost of some
+       traffic.
+   */
+   U32 keepIdle;
+   /** TCP_KEEPINTVL: seconds between keepalive probes, zero for default.
+    */
+   U32 keepIntvl;
+   /** TCP_USER_TIMEOUT in milliseconds, zero for default. Max time
+       transmitted data may remain unacknowledged before the connection
+       is closed. Makes se_send fail in seconds instead of the default
+       retransmission timeout of up to about 15 minutes, so a dead
+       broker connection is detected and reconnected quickly.
+   */
+   U32 userTimeout;
+   /** Max time in milliseconds for the complete connect, zero for no
+       limit other than attemptTmo. Used by porting layers that
+       implement parallel connection attempts (Posix).
+   */
+   U32 connectTmo;
+   /** Max time in milliseconds for one connection attempt, zero for
+       the default (4 seconds).
+   */
+   U32 attemptTmo;
+   /** Milliseconds to wait for an attempt to complete before the
+       next resolved address is tried in parallel, zero for the default
+       (250 ms, RFC 8305). When a host name resolves to both an
+       unreachable IPv6 address and a working IPv4 address, the connect
+       completes after this delay instead of after attemptTmo.
+   */
+   U16 attemptDelay;
+   /** TCP_KEEPCNT: unacknowledged probes before the connection is
+       dropped, zero for default.
+   */
+   U16 keepCnt;
+   /** IP_TOS (IPv4) or IPV6_TCLASS (IPv6), -1 for default. A DSCP
+       value such as 0xB8 (EF) lets routers prioritize SMQ traffic over
+       bulk traffic.
+   */
+   S16 tos;
+   /** SO_PRIORITY (Linux), -1 for default. Selects the queuing
+       discipline band for outgoing packets on the local host.
+   */
+   S16 priority;
+   /** TCP_NODELAY: set to TRUE to disable the Nagle algorithm. Nagle
+       delays a small segment until the previous segment is
+       acknowledged; combined with delayed ACK at the peer, this can
+       delay a message sent as separate header and payload sends (as
+       done by SMQ_publish for large payloads) by up to 40-200 ms.
+       Disabling Nagle gives the lowest latency at the cost of more
+       small packets.
+   */
+   U8 noDelay;
+   /** TCP_QUICKACK (Linux): set to TRUE to acknowledge immediately
+       instead of delaying the ACK. Reduces latency when the peer uses
+       Nagle. The kernel may fall back to delayed ACK after a while, so
+       this option mainly affects the connection setup phase.
+   */
+   U8 quickAck;
+   /** SO_KEEPALIVE: set to TRUE to enable TCP keepalive probes. */
+   U8 keepAlive;
+} SeSockOpt;
+
+#define SeSockOpt_constructor(o) \
+   (memset(o,0,sizeof(SeSockOpt)),(o)->tos=-1,(o)->priority=-1)
+
+/** A data region sent by #se_sendv. */
+typedef struct
+{
+   const void* data;
+   U32 len;
+} SeIoVec;
+
 #include "selibplat.h"
 
+/* Host builds using the bare metal context manager (set SE_CTX) */
+#if defined(SE_CTX) && !defined(_SeCtx_h)
+#include "SeCtx.h"
+#endif
+
 #ifndef SE_CTX
 #define SeCtx void
 #endif
@@ -165,6 +280,23 @@ extern "C" {
 */
 int se_connect(SOCKET* sock, const char* address, U16 port);
 
+/** Same as #se_connect, but applies the socket options 'opt'. The
+    options are applied before connecting when supported by the
+    porting layer. 'opt' may be NULL.
+*/
+#ifdef NO_BSD_SOCK
+#define se_connectEx(sock, address, port, opt) se_connect(sock, address, port)
+#else
+int se_connectEx(SOCKET* sock, const char* address, U16 port,
+                 const SeSockOpt* opt);
+
+/** Applies the socket options 'opt' to a socket.
+    \returns zero on success and -1 if one or more options could not
+    be set.
+*/
+int se_setSockOpt(SOCKET* sock, const SeSockOpt* opt);
+#endif
+
 /** Initializes a SOCKET object bound to a local port, ready to accept
     client connections.
  \return Zero on success.
@@ -198,6 +330,14 @@ int se_sockValid(SOCKET* sock);
  */
 S32 se_send(SOCKET* sock, const void* buf, U32 len);
 
+/** Sends the regions in 'iov' in order. The porting layer sends all
+    regions with one system call when the TCP/IP stack supports
+    vectored I/O (Posix: sendmsg); other ports call se_send for each
+    region.
+    \returns the number of bytes sent or a negative value on error.
+ */
+S32 se_sendv(SOCKET* sock, const SeIoVec* iov, int cnt);
+
 /** Waits for data sent by peer.
 
     \param sock the SOCKET object.
@@ -276,6 +416,37 @@ typedef struct SharkSslSha1Ctx
 void  SharkSslSha1Ctx_constructor(SharkSslSha1Ctx* ctx);
 void  SharkSslSha1Ctx_append(SharkSslSha1Ctx* ctx, const U8* data, U32 len);
 void  SharkSslSha1Ctx_finish(SharkSslSha1Ctx*,U8 digest[SHARKSSL_SHA1_HASH_LEN]);
+
+/** Calculate the SHA-1 digest of 'n' independent messages. The AVX2
+    implementation hashes 8 messages in parallel; the other
+    implementations hash one message at a time. #SE_SHA1_AUTO prefers
+    SHA-NI, thus the AVX2 implementation is used only on CPUs without
+    SHA-NI or when selected with #se_sha1Select. On CPUs with both,
+    SHA-NI hashing one message at a time is about as fast as AVX2
+    with 8 messages per step (see examples/sha1bench.c).
+    \param data the messages.
+    \param len the length of each message.
+    \param digest n * #SHARKSSL_SHA1_HASH_LEN bytes, the digest of
+    message i is stored at offset i * #SHARKSSL_SHA1_HASH_LEN.
+    \param n the number of messages.
+*/
+void se_sha1Multi(const U8* const data[], const U32 len[], U8* digest, U32 n);
+
+/** SHA-1 implementations for #se_sha1Select */
+#define SE_SHA1_AUTO   -1 /* The fastest implementation on this CPU */
+#define SE_SHA1_SCALAR  0 /* Portable C */
+#define SE_SHA1_SIMD    1 /* AVX2 for se_sha1Multi, portable C otherwise */
+#define SE_SHA1_HW      2 /* SHA-NI or ARMv8 crypto extension */
+
+/** Select the SHA-1 implementation. The fastest implementation is
+    selected by default; this function is for benchmarks and tests.
+    \param impl #SE_SHA1_AUTO, #SE_SHA1_SCALAR, #SE_SHA1_SIMD, or
+    #SE_SHA1_HW.
+    \returns the selected implementation or -1 if 'impl' is not
+    supported by this CPU or build, in which case the current
+    implementation is kept.
+*/
+int se_sha1Select(int impl);
 #endif
 
 
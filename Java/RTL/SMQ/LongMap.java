@@ -0,0 +1,107 @@
+package RTL.SMQ;
+
+/* Map with primitive long keys, used for the tables indexed by topic
+   and subtopic ID. A read probes an immutable snapshot published
+   through a volatile field, without locking and without boxing the
+   key. A write copies the snapshot. This suits the SMQ tables, which
+   change on subscribe and create but are read for every received
+   message.
+
+   Writes must be serialized by the caller (SMQ._lock).
+ */
+final class LongMap<V>
+{
+  @SuppressWarnings("unchecked")
+  final V get(long key)
+  {
+    Table t = _table;
+    if(key == 0)
+      return (V)t.zero;
+    long[] keys = t.keys;
+    int mask = keys.length - 1;
+    for(int i = hash(key) & mask ; keys[i] != 0 ; i = (i+1) & mask) {
+      if(keys[i] == key)
+        return (V)t.vals[i];
+    }
+    return null;
+  }
+
+  final void put(long key, V val)
+  {
+    _table = copy(key, val, false);
+  }
+
+  final V remove(long key)
+  {
+    V val = get(key);
+    if(val != null)
+      _table = copy(key, null, true);
+    return val;
+  }
+
+  final void clear()
+  {
+    _table = EMPTY;
+  }
+
+  // Returns a new table with 'key' set to 'val' or removed.
+  private Table copy(long key, Object val, boolean remove)
+  {
+    Table t = _table;
+    Object zero = key == 0 ? (remove ? null : val) : t.zero;
+    int cap = 8;
+    while(cap < 2 * (t.size + 1))
+      cap <<= 1;
+    Table n = new Table(cap, zero);
+    int count = zero == null ? 0 : 1;
+    for(int i=0 ; i < t.keys.length ; i++) {
+      if(t.keys[i] != 0 && t.keys[i] != key) {
+        n.insert(t.keys[i], t.vals[i]);
+        count++;
+      }
+    }
+    if(key != 0 && ! remove) {
+      n.insert(key, val);
+      count++;
+    }
+    n.size = count;
+    return n;
+  }
+
+  // Package-private for the collision check in TopicMapBench.
+  static int hash(long key)
+  {
+    long h = key * 0x9E3779B97F4A7C15L;
+    return (int)(h ^ (h >>> 32));
+  }
+
+  // Open addressing with linear probing; key 0 marks an empty slot
+  // and is stored in 'zero'. Not modified after it is published.
+  private static final class Table
+  {
+    Table(int cap, Object zero)
+    {
+      keys = new long[cap];
+      vals = new Object[cap];
+      this.zero = zero;
+    }
+
+    final void insert(long key, Object val)
+    {
+      int mask = keys.length - 1;
+      int i = hash(key) & mask;
+      while(keys[i] != 0)
+        i = (i+1) & mask;
+      keys[i] = key;
+      vals[i] = val;
+    }
+
+    final long[] keys;
+    final Object[] vals;
+    final Object zero;
+    int size;
+  };
+
+  private static final Table EMPTY = new Table(8, null);
+  private volatile Table _table = EMPTY;
+}
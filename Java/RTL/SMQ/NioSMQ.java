@@ -0,0 +1,866 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.net.*;
+import java.nio.*;
+import java.nio.channels.*;
+import java.security.*;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.*;
+import javax.net.ssl.*;
+
+/**
+   NioSMQ is an SMQ client that runs its connection on a shared
+   {@link SMQSelector} I/O thread instead of on an upstream and a
+   downstream thread per instance. A process can therefore run
+   thousands of connections on a few threads, for example when
+   simulating a fleet of devices.
+   <p>
+   The API is the one of {@link SMQ}: publish, subscribe, create,
+   observe, and the IntfOnMsg, IntfOnCreateAck, IntfOnChange, and
+   IntfOnClose callbacks work the same way. The callbacks run on the
+   Executor passed to the constructor, or on the I/O thread if the
+   executor is null. Callbacks running on the I/O thread must not
+   block, since that delays all connections handled by the same
+   thread. Use an executor that runs one task at a time per NioSMQ
+   instance if the callbacks must run in message order.
+   <p>
+   Both https:// and http:// broker URLs are accepted. Proxies are
+   not supported.
+   <p>
+   The blocking {@link NioSMQ#init} and {@link NioSMQ#connect} methods
+   work as in SMQ. Use {@link NioSMQ#connectAsync} to open many
+   connections without a thread per pending connect.
+ */
+public class NioSMQ extends SMQ
+{
+  /** Callback interface for {@link NioSMQ#connectAsync}.
+   */
+  public interface OnSmqConnectionListener
+  {
+    /** Called when the broker accepted the connection. */
+    void onSmqConnected();
+
+    /** Called if the connection could not be established.
+        @param e the reason.
+     */
+    void onSmqConnectionErr(SmqException e);
+  };
+
+  /**
+     Create an SMQ client instance.
+
+     @param smqUrl the broker URL, an HTTPS or HTTP type URL.
+
+     @param trustMgr Optional TrustManager. See {@link SMQ#SMQ}.
+
+     @param hostVerifier Optional HostnameVerifier. The server
+     certificate must match the URL's host name if this parameter is
+     null.
+
+     @param onClose See {@link SMQ#SMQ}.
+
+     @param selector the I/O thread pool running the connection, or
+     null for {@link SMQSelector#getDefault}.
+
+     @param executor runs the user callbacks, or null to run them on
+     the I/O thread.
+   */
+  public NioSMQ(URL smqUrl, TrustManager[] trustMgr,
+                HostnameVerifier hostVerifier, IntfOnClose onClose,
+                SMQSelector selector, Executor executor)
+    throws IOException
+  {
+    super(smqUrl, trustMgr, hostVerifier, null, onClose, false);
+    if(selector == null)
+      selector = SMQSelector.getDefault();
+    _loop = selector.next();
+    _resolver = selector.resolver;
+    _executor = executor;
+  }
+
+  /**
+     See {@link SMQ#init}. The method blocks until the broker has sent
+     the Init message.
+   */
+  @Override
+  public void init() throws SmqException
+  {
+    Waiter w = new Waiter();
+    initAsync(w);
+    w.await();
+  }
+
+  /**
+     See {@link SMQ#connect}. The method blocks until the broker has
+     accepted or refused the connection.
+   */
+  @Override
+  public void connect(byte[] uid, String credentials, String info)
+    throws SmqException
+  {
+    Waiter w = new Waiter();
+    connectInternal(uid, credentials, info, w);
+    w.await();
+  }
+
+  /**
+     Non blocking version of {@link NioSMQ#connect}. The listener runs
+     on the callback executor.
+
+     @param listener optional; called when the connection is
+     established or when it fails.
+   */
+  public void connectAsync(byte[] uid, String credentials, String info,
+                           final OnSmqConnectionListener listener)
+  {
+    connectInternal(uid, credentials, info, new OnSmqConnectionListener() {
+        public void onSmqConnected() {
+          if(listener != null) {
+            callback(new Runnable() {
+                public void run() { listener.onSmqConnected(); }
+              });
+          }
+        }
+        public void onSmqConnectionErr(final SmqException e) {
+          if(listener != null) {
+            callback(new Runnable() {
+                public void run() { listener.onSmqConnectionErr(e); }
+              });
+          }
+        }
+      });
+  }
+
+  /**
+     Close the broker connection. See {@link SMQ#close}. The instance
+     can be connected again after close returns.
+   */
+  @Override
+  public void close(final boolean flush, final IntfOnClose onClose)
+  {
+    _isRunning = false;
+    final Runnable finish = new Runnable() {
+        public void run() {
+          _onFlushed = null;
+          sockClose();
+          if(onClose != null)
+            smqOnClose(onClose, null);
+        }
+      };
+    _loop.execute(new Runnable() {
+        public void run() {
+          if(flush && _conState == 2 && _channel != null) {
+            try {
+              _outQ.add(outMsg(MSG_DISCONNECT));
+              if( ! flush() ) {
+                _onFlushed = finish; // Close when the socket is writable
+                updateInterest();
+                return;
+              }
+            }
+            catch(IOException ignore) {}
+          }
+          finish.run();
+        }
+      });
+  }
+
+  @Override
+  void add2UpstreamQ(final OutMsg msg)
+  {
+    _outQ.add(msg);
+    if(_flushPending.compareAndSet(false, true))
+      _loop.execute(_flushTask);
+  }
+
+  @Override
+  void closeTransport()
+  {
+    SocketChannel ch = _channel;
+    _channel = null;
+    if(ch != null) {
+      try { ch.close(); } // Also cancels the selection key
+      catch(IOException ignore) {}
+    }
+  }
+
+  @Override
+  void smqOnCreateAck(final IntfOnCreateAck ack,final boolean accepted,
+                      final String topic, final long tid,
+                      final String subtopic, final long subtid)
+  {
+    callback(new Runnable() {
+        public void run() {
+          ack.smqOnCreateAck(accepted,topic, tid, subtopic, subtid);
+        }
+      });
+  }
+
+  @Override
+  void smqOnCreatesubAck(final IntfOnCreatsubeAck ca, final boolean accepted,
+                         final String subtopic, final long subtid)
+  {
+    callback(new Runnable() {
+        public void run() {
+          ca.smqOnCreatesubAck(accepted,subtopic,subtid);
+        }
+      });
+  }
+
+  @Override
+  void smqOnMsg(final IntfOnMsg om, final Msg msg)
+  {
+    if(_executor == null) {
+      try { om.smqOnMsg(msg); }
+      catch(RuntimeException e) { e.printStackTrace(); }
+    }
+    else {
+      _executor.execute(new Runnable() {
+          public void run() {
+            om.smqOnMsg(msg);
+          }
+        });
+    }
+  }
+
+  @Override
+  void smqOnChange(final IntfOnChange oc,final long subscribers,final long tid)
+  {
+    callback(new Runnable() {
+        public void run() {
+          oc.smqOnChange(subscribers, tid);
+        }
+      });
+  }
+
+  @Override
+  void smqOnClose(final IntfOnClose oc, final SmqException e)
+  {
+    if(oc != null) {
+      callback(new Runnable() {
+          public void run() {
+            oc.smqOnClose(e);
+          }
+        });
+    }
+  }
+
+  /* Run a user callback on the executor, or on this thread if there
+     is no executor. An exception thrown by the callback must not
+     terminate the I/O thread.
+   */
+  private void callback(Runnable r)
+  {
+    if(_executor != null)
+      _executor.execute(r);
+    else {
+      try { r.run(); }
+      catch(RuntimeException e) { e.printStackTrace(); }
+    }
+  }
+
+  private void connectInternal(final byte[] uid, final String credentials,
+                               final String info,
+                               final OnSmqConnectionListener listener)
+  {
+    if(_conState == 0) {
+      initAsync(new OnSmqConnectionListener() {
+          public void onSmqConnected() {
+            sendConnect(uid, credentials, info, listener);
+          }
+          public void onSmqConnectionErr(SmqException e) {
+            listener.onSmqConnectionErr(e);
+          }
+        });
+    }
+    else if(_conState == 1)
+      sendConnect(uid, credentials, info, listener);
+    else
+      listener.onSmqConnectionErr(new SmqException(SmqException.INVALID_STATE));
+  }
+
+  private void sendConnect(byte[] uid, String credentials, String info,
+                           OnSmqConnectionListener listener)
+  {
+    OutMsg msg;
+    try { msg = connectMsg(uid, credentials, info); }
+    catch(IOException e) {
+      listener.onSmqConnectionErr(new SmqException(SmqException.INVALID_ARG,e));
+      return;
+    }
+    _deadline = System.currentTimeMillis() + _connectTmo;
+    _connackListener = listener;
+    add2UpstreamQ(msg);
+  }
+
+  /* Resolve the broker address on the selector's resolver thread and
+     let the I/O thread open the connection. The DNS lookup blocks, so
+     it runs neither on the caller's thread nor on the I/O thread.
+   */
+  private void initAsync(OnSmqConnectionListener listener)
+  {
+    String proto = _smqUrl.getProtocol();
+    boolean tls = proto.equalsIgnoreCase("https");
+    if( ! tls && ! proto.equalsIgnoreCase("http") ) {
+      listener.onSmqConnectionErr(new SmqException(SmqException.INVALID_ARG));
+      return;
+    }
+    final String host = _smqUrl.getHost();
+    final int port = _smqUrl.getPort() < 0 ? _smqUrl.getDefaultPort() : _smqUrl.getPort();
+    SSLEngine engine=null;
+    if(tls) {
+      try {
+        SSLContext sc = SSLContext.getInstance("TLS");
+        sc.init(null,_trustMgr,null);
+        engine = sc.createSSLEngine(host, port);
+        engine.setUseClientMode(true);
+        if(_hostVerifier == null) {
+          SSLParameters params = engine.getSSLParameters();
+          params.setEndpointIdentificationAlgorithm("HTTPS");
+          engine.setSSLParameters(params);
+        }
+      }
+      catch(NoSuchAlgorithmException e) {
+        listener.onSmqConnectionErr(new SmqException(SmqException.SSL_NOT_SUPPORTED,e));
+        return;
+      }
+      catch(KeyManagementException e) {
+        listener.onSmqConnectionErr(new SmqException(SmqException.SSL_NOT_SUPPORTED,e));
+        return;
+      }
+    }
+    synchronized(_lock) {
+      if(_conState != 0 || _initListener != null || _connackListener != null) {
+        listener.onSmqConnectionErr(new SmqException(SmqException.INVALID_STATE));
+        return;
+      }
+      _initListener = listener;
+    }
+    _recTimeStamp = System.currentTimeMillis();
+    _deadline = _recTimeStamp + _connectTmo;
+    _isRunning = false;
+    final SSLEngine eng = engine;
+    _resolver.execute(new Runnable() {
+        public void run() {
+          final InetSocketAddress addr = new InetSocketAddress(host, port);
+          _loop.execute(new Runnable() {
+              public void run() {
+                if(addr.isUnresolved())
+                  fail(new SmqException(SmqException.CANNOT_CONNECT,
+                                        new UnknownHostException(host)));
+                else
+                  open(addr, eng);
+              }
+            });
+        }
+      });
+  }
+
+  // I/O thread: start the non blocking TCP connect.
+  private void open(InetSocketAddress addr, SSLEngine engine)
+  {
+    _engine = engine;
+    _in = ByteBuffer.allocate(engine == null ? _bufSize :
+      Math.max(_bufSize, engine.getSession().getApplicationBufferSize()));
+    if(engine != null) {
+      _netIn = ByteBuffer.allocate(engine.getSession().getPacketBufferSize());
+      _netOut = ByteBuffer.allocate(engine.getSession().getPacketBufferSize());
+    }
+    for(int i=0 ; i < _batchLen ; i++) {
+      _batch[i] = null;
+      _batchMsg[i] = null;
+    }
+    _batchLen = 0;
+    while(_outQ.poll() != null)
+      ; // Drop frames queued for a closed connection
+    _onFlushed = null;
+    _state = S_CONNECTING;
+    _is = _frameIs;
+    try {
+      SocketChannel ch = SocketChannel.open();
+      _channel = ch;
+      ch.configureBlocking(false);
+      ch.socket().setTcpNoDelay(true);
+      _key = ch.register(_loop.selector, SelectionKey.OP_CONNECT, this);
+      if(ch.connect(addr))
+        tcpConnected();
+      updateInterest();
+    }
+    catch(IOException e) {
+      fail(new SmqException(SmqException.CANNOT_CONNECT,e));
+    }
+  }
+
+  // I/O thread: called by SMQSelector when the channel is ready.
+  final void ready(SelectionKey key)
+  {
+    SocketChannel ch = _channel; // Set to null by sockClose on any thread
+    if(ch == null || ! key.isValid() || key.channel() != ch)
+      return; // Key of a closed connection
+    try {
+      if(_state == S_CONNECTING) {
+        if(ch.finishConnect())
+          tcpConnected();
+      }
+      else {
+        if(key.isWritable())
+          writeReady();
+        if(key.isValid() && key.isReadable())
+          readReady();
+      }
+      updateInterest();
+    }
+    catch(CancelledKeyException ignore) {} // Closed by another thread
+    catch(IOException e) {
+      fail(new SmqException(_conState == 2 ?
+                            SmqException.DISCONNECT :
+                            SmqException.CANNOT_CONNECT, e));
+    }
+  }
+
+  // I/O thread: called by SMQSelector once a second.
+  final void tick(long now)
+  {
+    if(_initListener != null || _connackListener != null) {
+      if(now > _deadline)
+        fail(new SmqException(SmqException.CANNOT_CONNECT,
+                              new SocketTimeoutException()));
+    }
+    else
+      checkPing();
+  }
+
+  private void tcpConnected() throws IOException
+  {
+    if(_engine != null) {
+      _state = S_TLS;
+      _engine.beginHandshake();
+      handshake();
+    }
+    else
+      sendBootstrap();
+  }
+
+  // Send the HTTP request that the broker morphs into an SMQ connection.
+  private void sendBootstrap() throws IOException
+  {
+    _state = S_HTTP;
+    String path = _smqUrl.getFile();
+    if(path.length() == 0)
+      path = "/";
+    String host = _smqUrl.getHost();
+    if(_smqUrl.getPort() >= 0)
+      host = host + ":" + _smqUrl.getPort();
+    String req = "GET " + path + " HTTP/1.1\r\n" +
+      "Host: " + host + "\r\n" +
+      "SimpleMQ: true\r\n" +
+      "SendSmqHttpResponse: true\r\n\r\n";
+    _batchMsg[_batchLen] = null;
+    _batch[_batchLen++] = ByteBuffer.wrap(req.getBytes("ISO-8859-1"));
+    flush();
+  }
+
+  // Drive the TLS handshake until it needs network I/O or completes.
+  private void handshake() throws IOException
+  {
+    SocketChannel ch = _channel;
+    if(ch == null)
+      return;
+    for(;;) {
+      SSLEngineResult.HandshakeStatus hs = _engine.getHandshakeStatus();
+      if(hs == SSLEngineResult.HandshakeStatus.NEED_TASK) {
+        Runnable task;
+        while((task = _engine.getDelegatedTask()) != null)
+          task.run();
+      }
+      else if(hs == SSLEngineResult.HandshakeStatus.NEED_WRAP) {
+        if( ! writeNet(ch) )
+          return;
+        SSLEngineResult r = _engine.wrap(_empty, _netOut);
+        if(r.getStatus() == SSLEngineResult.Status.BUFFER_OVERFLOW)
+          _netOut = grow(_netOut, _engine.getSession().getPacketBufferSize());
+        else if(r.getStatus() == SSLEngineResult.Status.CLOSED)
+          throw new SSLException("TLS connection closed");
+      }
+      else if(hs == SSLEngineResult.HandshakeStatus.NEED_UNWRAP) {
+        SSLEngineResult.Status st = unwrap();
+        if(st == SSLEngineResult.Status.CLOSED)
+          throw new SSLException("TLS connection closed");
+        if(st == SSLEngineResult.Status.BUFFER_UNDERFLOW) {
+          if( ! writeNet(ch) )
+            return;
+          int n = ch.read(_netIn);
+          if(n < 0)
+            throw new EOFException("Connection closed during TLS handshake");
+          if(n == 0)
+            return;
+        }
+      }
+      else { // Finished, or not handshaking
+        if( ! writeNet(ch) )
+          return;
+        if(_state == S_TLS) {
+          if(_hostVerifier != null &&
+             ! _hostVerifier.verify(_smqUrl.getHost(), _engine.getSession()))
+            throw new SSLPeerUnverifiedException(_smqUrl.getHost());
+          sendBootstrap();
+        }
+        return;
+      }
+    }
+  }
+
+  private void writeReady() throws IOException
+  {
+    if(_state == S_TLS)
+      handshake();
+    else if(flush() && _onFlushed != null)
+      _onFlushed.run();
+  }
+
+  private void readReady() throws IOException
+  {
+    if(_state == S_TLS) {
+      handshake();
+      return;
+    }
+    SocketChannel ch = _channel;
+    if(ch == null)
+      return;
+    int n;
+    if(_engine == null) {
+      if( ! _in.hasRemaining() )
+        _in = grow(_in, _bufSize);
+      n = ch.read(_in);
+    }
+    else {
+      n = ch.read(_netIn);
+      if(unwrap() == SSLEngineResult.Status.CLOSED)
+        n = -1;
+      SSLEngineResult.HandshakeStatus hs = _engine.getHandshakeStatus();
+      if(hs == SSLEngineResult.HandshakeStatus.NEED_TASK ||
+         hs == SSLEngineResult.HandshakeStatus.NEED_WRAP)
+        handshake(); // For example a TLS 1.3 key update
+    }
+    if(_state == S_HTTP)
+      parseHttp();
+    if(_state == S_SMQ)
+      processFrames();
+    if(n < 0 && _channel != null)
+      throw new EOFException("Connection closed by broker");
+  }
+
+  // Consume the HTTP response header that precedes the SMQ frames.
+  private void parseHttp() throws IOException
+  {
+    int len = _in.position();
+    int end = -1;
+    for(int i=3 ; i < len ; i++) {
+      if(_in.get(i) == '\n' && _in.get(i-1) == '\r' &&
+         _in.get(i-2) == '\n' && _in.get(i-3) == '\r') {
+        end = i+1;
+        break;
+      }
+    }
+    if(end < 0) {
+      if(len > _bufSize)
+        fail(new SmqException(SmqException.PROTOCOL_ERROR));
+      return;
+    }
+    String[] lines = new String(_in.array(), 0, end, "ISO-8859-1").split("\r\n");
+    boolean broker=false;
+    for(String line : lines) {
+      if(line.regionMatches(true, 0, "SmqBroker:", 0, 10))
+        broker=true;
+    }
+    String[] status = lines[0].split(" ");
+    if( ! broker ) {
+      fail(new SmqException(SmqException.URL_NOT_A_BROKER));
+      return;
+    }
+    if(status.length < 2 || ! status[1].equals("200")) {
+      fail(new SmqException(SmqException.NON_200_RESPONSE_CODE));
+      return;
+    }
+    _in.flip();
+    _in.position(end);
+    _in.compact();
+    _state = S_SMQ;
+  }
+
+  // Dispatch all complete frames in _in.
+  private void processFrames()
+  {
+    _in.flip();
+    while(_in.remaining() >= 3 && _channel != null) {
+      int pos = _in.position();
+      int len = _in.getShort(pos) & 0xFFFF;
+      if(len < 3) {
+        _in.clear();
+        fail(new SmqException(SmqException.PROTOCOL_ERROR));
+        return;
+      }
+      if(_in.remaining() < len)
+        break;
+      int limit = _in.limit();
+      _in.limit(pos + len); // The frame is read through _frameIs
+      short msgType;
+      try { msgType = dispatchDownstreamMsg(); }
+      catch(SmqException e) {
+        _in.clear();
+        fail(e);
+        return;
+      }
+      catch(RuntimeException e) {
+        _in.clear();
+        fail(new SmqException(SmqException.PROTOCOL_ERROR,e));
+        return;
+      }
+      _in.limit(limit);
+      _in.position(pos + len);
+      if(_initListener != null) {
+        if(msgType != MSG_INIT) {
+          _in.clear();
+          fail(new SmqException(SmqException.PROTOCOL_ERROR));
+          return;
+        }
+        _conState = 1;
+        OnSmqConnectionListener l = _initListener;
+        _initListener = null;
+        l.onSmqConnected();
+      }
+      else if(_connackListener != null && msgType == MSG_CONNACK) {
+        setConnected();
+        OnSmqConnectionListener l = _connackListener;
+        _connackListener = null;
+        l.onSmqConnected();
+      }
+    }
+    _in.compact();
+    if(_in.position() >= 2) {
+      int len = _in.getShort(0) & 0xFFFF;
+      if(len > _in.capacity())
+        _in = grow(_in, len - _in.capacity());
+    }
+  }
+
+  /* Write the queued frames with gathering writes, encrypted if the
+     connection uses TLS. Returns false if the socket send buffer is
+     full; the rest is written when the channel is writable. Returns
+     true if the connection was closed, as nothing is left to write.
+   */
+  private boolean flush() throws IOException
+  {
+    SocketChannel ch = _channel;
+    if(ch == null)
+      return true;
+    for(;;) {
+      if(_engine != null && ! writeNet(ch) )
+        return false;
+      OutMsg msg;
+      while(_batchLen < _batch.length && (msg = _outQ.poll()) != null) {
+        _batchMsg[_batchLen] = msg;
+        _batch[_batchLen++] = msg.frame();
+      }
+      if(_batchLen == 0)
+        return true;
+      if(_engine == null)
+        ch.write(_batch, 0, _batchLen);
+      else {
+        SSLEngineResult r = _engine.wrap(_batch, 0, _batchLen, _netOut);
+        if(r.getStatus() == SSLEngineResult.Status.BUFFER_OVERFLOW)
+          _netOut = grow(_netOut, _engine.getSession().getPacketBufferSize());
+        else if(r.getStatus() == SSLEngineResult.Status.CLOSED)
+          throw new SSLException("TLS connection closed");
+      }
+      int done=0;
+      while(done < _batchLen && ! _batch[done].hasRemaining()) {
+        if(_batchMsg[done] != null)
+          releaseOutMsg(_batchMsg[done]);
+        done++;
+      }
+      System.arraycopy(_batch, done, _batch, 0, _batchLen - done);
+      System.arraycopy(_batchMsg, done, _batchMsg, 0, _batchLen - done);
+      for(int i=_batchLen - done ; i < _batchLen ; i++) {
+        _batch[i] = null;
+        _batchMsg[i] = null;
+      }
+      _batchLen -= done;
+      if(_engine == null && _batchLen > 0)
+        return false;
+    }
+  }
+
+  // Write pending TLS records. Returns true when all are written.
+  private boolean writeNet(SocketChannel ch) throws IOException
+  {
+    if(_netOut.position() == 0)
+      return true;
+    _netOut.flip();
+    ch.write(_netOut);
+    _netOut.compact();
+    return _netOut.position() == 0;
+  }
+
+  // Decrypt the TLS records received in _netIn into _in.
+  private SSLEngineResult.Status unwrap() throws IOException
+  {
+    _netIn.flip();
+    try {
+      for(;;) {
+        SSLEngineResult r = _engine.unwrap(_netIn, _in);
+        SSLEngineResult.Status st = r.getStatus();
+        SSLEngineResult.HandshakeStatus hs = r.getHandshakeStatus();
+        if(st == SSLEngineResult.Status.BUFFER_OVERFLOW)
+          _in = grow(_in, _engine.getSession().getApplicationBufferSize());
+        else if(st != SSLEngineResult.Status.OK || ! _netIn.hasRemaining() ||
+                (r.bytesConsumed() == 0 && r.bytesProduced() == 0) ||
+                hs == SSLEngineResult.HandshakeStatus.NEED_TASK ||
+                hs == SSLEngineResult.HandshakeStatus.NEED_WRAP)
+          return st;
+      }
+    }
+    finally {
+      _netIn.compact();
+      if( ! _netIn.hasRemaining() )
+        _netIn = grow(_netIn, _engine.getSession().getPacketBufferSize());
+    }
+  }
+
+  private void updateInterest()
+  {
+    SelectionKey key = _key;
+    if(key == null || ! key.isValid() || _state == S_CONNECTING)
+      return;
+    boolean write = _batchLen > 0 ||
+      (_netOut != null && _netOut.position() > 0) ||
+      (_state >= S_HTTP && ! _outQ.isEmpty());
+    key.interestOps(SelectionKey.OP_READ | (write ? SelectionKey.OP_WRITE : 0));
+  }
+
+  // Close the connection and report 'e' to the pending init/connect
+  // listener, or to the onClose callback if the client was connected.
+  private void fail(SmqException e)
+  {
+    OnSmqConnectionListener l = _initListener != null ?
+      _initListener : _connackListener;
+    _initListener = null;
+    _connackListener = null;
+    Runnable onFlushed = _onFlushed;
+    if(l != null) {
+      sockClose();
+      l.onSmqConnectionErr(e);
+    }
+    else {
+      manageUnexpectedClose(e);
+      closeTransport();
+    }
+    if(onFlushed != null)
+      onFlushed.run();
+  }
+
+  // Copy 'b', which is in write mode, to a buffer 'extra' bytes larger.
+  private static ByteBuffer grow(ByteBuffer b, int extra)
+  {
+    ByteBuffer n = ByteBuffer.allocate(b.capacity() + extra);
+    b.flip();
+    n.put(b);
+    return n;
+  }
+
+  // Makes dispatchDownstreamMsg read the current frame from _in.
+  private final class FrameInputStream extends InputStream
+  {
+    public int read()
+    {
+      return _in.hasRemaining() ? (_in.get() & 0xFF) : -1;
+    }
+
+    public int read(byte[] b, int off, int len)
+    {
+      if(len == 0)
+        return 0;
+      if( ! _in.hasRemaining() )
+        return -1;
+      len = Math.min(len, _in.remaining());
+      _in.get(b, off, len);
+      return len;
+    }
+  };
+
+  // Blocks init() and connect() until the I/O thread reports the result.
+  private static final class Waiter implements OnSmqConnectionListener
+  {
+    public void onSmqConnected() { _latch.countDown(); }
+
+    public void onSmqConnectionErr(SmqException e)
+    {
+      _err = e;
+      _latch.countDown();
+    }
+
+    final void await() throws SmqException
+    {
+      try { _latch.await(); }
+      catch(InterruptedException e) {
+        throw new SmqException(SmqException.CANNOT_CONNECT,e);
+      }
+      if(_err != null)
+        throw _err;
+    }
+
+    private final CountDownLatch _latch = new CountDownLatch(1);
+    private volatile SmqException _err=null;
+  };
+
+  private final Runnable _flushTask = new Runnable() {
+      public void run() {
+        _flushPending.set(false);
+        if(_channel == null || _state < S_HTTP)
+          return;
+        try {
+          if(flush() && _onFlushed != null)
+            _onFlushed.run();
+          updateInterest();
+        }
+        catch(IOException e) {
+          fail(new SmqException(SmqException.DISCONNECT,e));
+        }
+      }
+    };
+
+  private final SMQSelector.Loop _loop;
+  private final Executor _resolver;
+  private final Executor _executor;
+  private final DataInputStream _frameIs =
+    new DataInputStream(new FrameInputStream());
+  private final OutQ _outQ = new OutQ();
+  private final AtomicBoolean _flushPending = new AtomicBoolean();
+
+  // The fields below are used by the I/O thread only.
+  private final ByteBuffer[] _batch = new ByteBuffer[64]; // Gathering write
+  private final OutMsg[] _batchMsg = new OutMsg[64]; // Released when sent
+  private int _batchLen=0;
+  private SelectionKey _key=null;
+  private SSLEngine _engine=null;
+  private ByteBuffer _in;     // Received SMQ data, in write mode
+  private ByteBuffer _netIn;  // Received TLS records
+  private ByteBuffer _netOut; // TLS records to send
+  private int _state=S_CONNECTING;
+  private Runnable _onFlushed=null;
+
+  private volatile SocketChannel _channel=null;
+  private volatile long _deadline=0;
+  private volatile OnSmqConnectionListener _initListener=null;
+  private volatile OnSmqConnectionListener _connackListener=null;
+
+  private static final int S_CONNECTING = 0; // Waiting for TCP connect
+  private static final int S_TLS        = 1; // TLS handshake
+  private static final int S_HTTP       = 2; // Waiting for the HTTP response
+  private static final int S_SMQ        = 3; // SMQ frames
+
+  private static final int _bufSize     = 16 * 1024;
+  private static final long _connectTmo = 30 * 1000;
+  private static final ByteBuffer _empty = ByteBuffer.allocate(0);
+}
@@ -1,8 +1,12 @@
 package RTL.SMQ;
 
 import java.util.*;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.*;
+import java.util.concurrent.locks.LockSupport;
 import java.net.*;
 import java.io.*;
+import java.nio.ByteBuffer;
 import javax.net.ssl.*;
 import java.security.*;
 
@@ -24,6 +28,9 @@ import java.security.*;
 
    The SMQ instance will not garbage collect unless method
    {@link SMQ#close} is called, which terminates the two threads.
+   <p>
+   Use {@link NioSMQ} when a process needs many connections: it runs
+   all connections on a small shared pool of I/O threads instead.
    
 <p>
    All methods sending messages to the broker (such as publish) return
@@ -67,6 +74,16 @@ public class SMQ
    */
   public SMQ(URL smqUrl, TrustManager[] trustMgr,
              HostnameVerifier hostVerifier, Proxy proxy, IntfOnClose onClose)
+  {
+    this(smqUrl, trustMgr, hostVerifier, proxy, onClose, true);
+  }
+
+  /* Used by NioSMQ with 'threads' set to false: the connection is then
+     run by an SMQSelector I/O thread and not by the upstream and
+     downstream threads.
+   */
+  SMQ(URL smqUrl, TrustManager[] trustMgr, HostnameVerifier hostVerifier,
+      Proxy proxy, IntfOnClose onClose, boolean threads)
   {
     _smqUrl=smqUrl;
     _proxy = proxy;
@@ -74,10 +91,12 @@ public class SMQ
     _hostVerifier=hostVerifier;
     _onClose = onClose;
     _lock=this;
-    _upstreamThread = new Thread() { public void run() {upstreamThreadFunc();} };
-    _downstreamThread = new Thread() { public void run() {downstreamThreadFunc();} };
-    _upstreamThread.start();
-    _downstreamThread.start();
+    if(threads) {
+      _upstreamThread = new Thread() { public void run() {upstreamThreadFunc();} };
+      _downstreamThread = new Thread() { public void run() {downstreamThreadFunc();} };
+      _upstreamThread.start();
+      _downstreamThread.start();
+    }
   }
 
 
@@ -179,23 +198,35 @@ public class SMQ
       init();
     else if(_conState != 1)
       doEx(SmqException.INVALID_STATE);
-    try {
-      OutMsg msg = new OutMsg(MSG_CONNECT);
-      msg.dos.writeByte(_version);
-      msg.dos.writeByte(uid.length);
-      msg.dos.write(uid);
-      msg.writeString(credentials, true);
-      msg.writeString(info, false);
-      msg.send(_sock);
-    }
+    try { connectMsg(uid, credentials, info).send(_sock); }
     catch(IOException e) { doEx(SmqException.DISCONNECT,e); }
     if(MSG_CONNACK != dispatchDownstreamMsg())
       doEx(SmqException.PROTOCOL_ERROR);
+    setConnected();
+    synchronized(_downstreamThread) { _downstreamThread.notify(); }
+  }
+
+  final OutMsg connectMsg(byte[] uid, String credentials, String info)
+    throws IOException
+  {
+    OutMsg msg = outMsg(MSG_CONNECT);
+    msg.writeByte(_version);
+    msg.writeByte(uid.length);
+    msg.write(uid, 0, uid.length);
+    msg.writeString(credentials, true);
+    msg.writeString(info, false);
+    return msg;
+  }
+
+  // Called when the broker accepted the connection (MSG_CONNACK).
+  final void setConnected()
+  {
     _conState=2;
     _isRunning = true;
-    _topic2tidM.put("self",_etid);
-    _tid2topicM.put(_etid,"self");
-    synchronized(_downstreamThread) { _downstreamThread.notify(); }
+    synchronized(_lock) {
+      _topic2tidM.put("self",_etid);
+      _tid2topicM.put(_etid,"self");
+    }
   }
 
   /** Returns true if the client is connected.
@@ -215,10 +246,8 @@ public class SMQ
    */
   public long topic2tid(String topic)
   {
-    synchronized(_lock) {
-      Long x = _topic2tidM.get(topic);
-      return x == null ? 0 : x.longValue();
-    }
+    Long x = _topic2tidM.get(topic);
+    return x == null ? 0 : x.longValue();
   }
 
   /** Translates a subtopic name known to the client to subtopic ID.
@@ -232,10 +261,8 @@ public class SMQ
    */
   public long subtopic2tid(String subtopic)
   {
-    synchronized(_lock) {
-      Long x = _subtopic2tidM.get(subtopic);
-      return x == null ? 0 : x.longValue();
-    }
+    Long x = _subtopic2tidM.get(subtopic);
+    return x == null ? 0 : x.longValue();
   }
 
   /** Translates topic ID known to the client to topic name.
@@ -249,9 +276,7 @@ public class SMQ
    */
   public String tid2topic(long tid)
   {
-    synchronized(_lock) {
-      return _tid2topicM.get(tid);
-    }
+    return _tid2topicM.get(tid);
   }
 
   /** Translates subtopic ID known to the client to subtopic name.
@@ -265,9 +290,7 @@ public class SMQ
    */
   public String tid2subtopic(long subtid)
   {
-    synchronized(_lock) {
-      return _tid2subtopicM.get(subtid);
-    }
+    return _tid2subtopicM.get(subtid);
   }
 
   /** 
@@ -347,7 +370,7 @@ public class SMQ
             }
           };
         if(add2AckM(_createSubAckM, subtopic, action) == false) {
-          try {add2UpstreamQ(new OutMsg(MSG_CREATESUB,subtopic));}
+          try {add2UpstreamQ(outMsg(MSG_CREATESUB,subtopic));}
           catch(IOException e){}
         }
       }
@@ -560,19 +583,23 @@ public class SMQ
      if not used.
      @param b the data to published.
      @param off the start offset in the data.
-     @param len the number of bytes to write.
+     @param len the number of bytes to write, at most 65520, the
+     largest payload that fits in an SMQ frame. A larger message fails
+     with INVALID_ARG and leaves the connection open.
    */
   public void publish(long tid, long subtid, byte[] b, int off, int len)
     throws SmqException
   {
     if(_conState != 2)
       doEx(SmqException.INVALID_STATE);
+    if(len > 0xFFFF - 15) // Size, type, tid, etid, and subtid
+      throw new SmqException(SmqException.INVALID_ARG);
     try {
-      OutMsg msg = new OutMsg(MSG_PUBLISH);
+      OutMsg msg = outMsg(MSG_PUBLISH);
       msg.writeUnsignedInt(tid);
       msg.writeUnsignedInt(_etid);
       msg.writeUnsignedInt(subtid);
-      msg.dos.write(b,off,len);
+      msg.write(b,off,len);
       add2UpstreamQ(msg);
     }
     catch(IOException e) { doEx(SmqException.DISCONNECT,e); }
@@ -606,8 +633,10 @@ public class SMQ
       doEx(SmqException.INVALID_STATE);
     if(tid != 0) {
       if(sendTidMsg(MSG_UNSUBSCRIBE, tid)) {
-        _callbackSubM.remove(tid);
-        _callbackM.remove(tid);
+        synchronized(_lock) {
+          _callbackSubM.remove(tid);
+          _callbackM.remove(tid);
+        }
       }
     }
   }
@@ -659,12 +688,12 @@ public class SMQ
     if(_conState != 2)
       doEx(SmqException.INVALID_STATE);
     if(tid != 0 && sendTidMsg(MSG_OBSERVE, tid)) {
-      LinkedList<IntfOnChange> l = _changeM.get(tid);
-      if(l == null) {
-        l = new  LinkedList<IntfOnChange>();
-        _changeM.put(tid, l);
+      synchronized(_lock) {
+        IntfOnChange[] a = _changeM.get(tid);
+        a = a == null ? new IntfOnChange[1] : Arrays.copyOf(a, a.length+1);
+        a[a.length-1] = ch;
+        _changeM.put(tid, a);
       }
-      l.add(ch);
     }
   }
 
@@ -689,8 +718,11 @@ public class SMQ
   {
     if(_conState != 2)
       doEx(SmqException.INVALID_STATE);
-    if(tid != 0 && sendTidMsg(MSG_UNOBSERVE, tid))
-      _changeM.remove(tid);
+    if(tid != 0 && sendTidMsg(MSG_UNOBSERVE, tid)) {
+      synchronized(_lock) {
+        _changeM.remove(tid);
+      }
+    }
   }
 
 
@@ -713,15 +745,12 @@ public class SMQ
           }
           Runnable r = new Runnable() {
               public void run() {
-                  synchronized (_upstreamThread) {
-                      Thread t = _upstreamThread;
-                      _upstreamThread = null;
-                      t.notify();
-                  }
+                  Thread t = _upstreamThread;
+                  _upstreamThread = null;
+                  LockSupport.unpark(t);
                   if (flush && _conState == 2) {
                       try {
-                          OutMsg msg = new OutMsg(MSG_DISCONNECT);
-                          msg.send(_sock);
+                          outMsg(MSG_DISCONNECT).send(_sock);
                       } catch (IOException ignore) {
                       }
                   }
@@ -742,15 +771,14 @@ public class SMQ
           onClose.smqOnClose(null);
   }
 
-  private void createAndPut(Map<Long,LinkedList<IntfOnMsg>> map,
-                            Long key,IntfOnMsg val)
+  // The callback arrays are replaced, not modified, since the
+  // dispatcher reads them without locking. Called with _lock held.
+  private void createAndPut(LongMap<IntfOnMsg[]> map, long key, IntfOnMsg val)
   {
-    LinkedList<IntfOnMsg> l = map.get(key);
-    if(l == null) {
-      l = new  LinkedList<IntfOnMsg>();
-      map.put(key, l);
-    }
-    l.add(val);
+    IntfOnMsg[] a = map.get(key);
+    a = a == null ? new IntfOnMsg[1] : Arrays.copyOf(a, a.length+1);
+    a[a.length-1] = val;
+    map.put(key, a);
   }
 
   private void createOrSub(final String topic, final String subtopic,
@@ -792,10 +820,9 @@ public class SMQ
                         createAndPut(_callbackM, tid, onMsg);
                       }
                       else {
-                        Map<Long,LinkedList<IntfOnMsg>> m = 
-                          _callbackSubM.get(tid);
+                        LongMap<IntfOnMsg[]> m = _callbackSubM.get(tid);
                         if(m == null) {
-                          m = new HashMap<Long,LinkedList<IntfOnMsg>>();
+                          m = new LongMap<IntfOnMsg[]>();
                           _callbackSubM.put(tid, m);
                         }
                         createAndPut(m, subtid, onMsg);  
@@ -815,8 +842,8 @@ public class SMQ
           else if(add2AckM(onMsg == null ? _createAckM : _SubAckM,topic,action)
                   == false || onMsg != null) {
             try {
-              add2UpstreamQ(new OutMsg(onMsg == null?
-                                       MSG_CREATE:MSG_SUBSCRIBE,topic));
+              add2UpstreamQ(outMsg(onMsg == null?
+                                   MSG_CREATE:MSG_SUBSCRIBE,topic));
             }
             catch(IOException e) {
               smqOnCreateAck(ack,false,topic,0,subtopic,subtid);
@@ -856,60 +883,126 @@ public class SMQ
   }
 
 
-  private final void add2UpstreamQ(final OutMsg msg)
+  // Overridden by NioSMQ, which queues the frame on its channel.
+  void add2UpstreamQ(final OutMsg msg)
   {
-    Runnable r = new Runnable() {
-        public void run() {
-          try { msg.send(_sock); }
-          catch(IOException e){ manageUnexpectedClose(e); }
-        }
-      };
-    add2UpstreamQ(r);
+    upstreamPut(msg);
   }
 
   private final void add2UpstreamQ(Runnable r)
   {
-    synchronized(_lock) { _upstreamQ.add(r); }
-    synchronized(_upstreamThread) { _upstreamThread.notify(); }
+    upstreamPut(new OutMsg(r));
   }
 
+  private final void upstreamPut(OutMsg msg)
+  {
+    _upstreamQ.add(msg);
+    if(_upstreamParked)
+      LockSupport.unpark(_upstreamThread);
+  }
+
+  /* The upstream thread copies the frames it drains from the queue
+     into one buffer and sends them with one write call, which also
+     makes one TLS record of many small frames.
+   */
   private final void upstreamThreadFunc()
   {
-    for(;;) {
-      if(_upstreamThread == null)
-        break;
-      synchronized(_upstreamThread) {
-        try { _upstreamThread.wait(60*1000); }
-        catch(InterruptedException e) {continue;}
-        if(_conState == 2 && System.currentTimeMillis() >
-           (_pingTmo+_recTimeStamp)) {
-          if(_pingActive) {
-            long max=_pingTmo+_recTimeStamp+_pongRespTmo;
-            if(System.currentTimeMillis() > max) {
-              manageUnexpectedClose(new SmqException(SmqException.PONG_TMO));
-            }
-          }
-          else {
-            _pingActive=true;
-            try {add2UpstreamQ(new OutMsg(MSG_PING));}
-            catch(IOException ignore) {}
-          }
-        }
+    byte[] buf = new byte[0x10000];
+    int len=0;
+    int gen=0; // _connGen of the frames in 'buf'
+    while(_upstreamThread != null) {
+      OutMsg msg = _upstreamQ.poll();
+      if(msg == null) {
+        len = upstreamWrite(buf, len, gen);
+        _upstreamParked = true;
+        if(_upstreamQ.isEmpty())
+          LockSupport.parkNanos(60*1000*1000000L);
+        _upstreamParked = false;
+        checkPing();
       }
-      for(;;) {
-        Runnable r=null;
-        synchronized(_lock) {
-          try { r=_upstreamQ.removeFirst(); }
-          catch(NoSuchElementException e) { break; }
-        }
-        if(r==null)
-          break;
-        r.run();
+      else if(msg.task != null) {
+        len = upstreamWrite(buf, len, gen);
+        msg.task.run();
+      }
+      else if(msg.gen != _connGen) {
+        releaseOutMsg(msg); // Queued before the connection was closed
+      }
+      else {
+        ByteBuffer frame = msg.frame();
+        int n = frame.remaining();
+        if(len + n > buf.length || msg.gen != gen)
+          len = upstreamWrite(buf, len, gen);
+        gen = msg.gen;
+        frame.get(buf, len, n);
+        len += n;
+        releaseOutMsg(msg);
       }
     }
     //System.out.println("Closing upstreamThreadFunc");
   }
 
+  // Frames queued before a close are dropped: they must not be sent
+  // on the next connection.
+  private final int upstreamWrite(byte[] buf, int len, int gen)
+  {
+    Socket sock = _sock;
+    if(len != 0 && sock != null && gen == _connGen) {
+      try { sock.getOutputStream().write(buf, 0, len); }
+      catch(IOException e) { manageUnexpectedClose(e); }
+    }
+    return 0;
+  }
+
+  // Returns a pooled OutMsg with the header for 'msgType' written.
+  final OutMsg outMsg(int msgType)
+  {
+    OutMsg msg = null;
+    for(int i=0 ; msg == null && i < _outMsgPool.length() ; i++) {
+      if(_outMsgPool.get(i) != null)
+        msg = _outMsgPool.getAndSet(i, null);
+    }
+    if(msg == null)
+      msg = new OutMsg();
+    msg.gen = _connGen;
+    return msg.begin(msgType);
+  }
+
+  final OutMsg outMsg(int msgType, String s) throws IOException
+  {
+    OutMsg msg = outMsg(msgType);
+    msg.writeString(s, false);
+    return msg;
+  }
+
+  // Called when the frame is sent. The pool keeps at most
+  // _outMsgPool.length() messages; the others are garbage collected.
+  final void releaseOutMsg(OutMsg msg)
+  {
+    for(int i=0 ; i < _outMsgPool.length() ; i++) {
+      if(_outMsgPool.get(i) == null && _outMsgPool.compareAndSet(i, null, msg))
+        return;
+    }
+  }
+
+  // Send MSG_PING when the connection has been idle for _pingTmo and
+  // close it if the broker does not respond within _pongRespTmo.
+  final void checkPing()
+  {
+    if(_conState == 2 && System.currentTimeMillis() >
+       (_pingTmo+_recTimeStamp)) {
+      if(_pingActive) {
+        long max=_pingTmo+_recTimeStamp+_pongRespTmo;
+        if(System.currentTimeMillis() > max) {
+          manageUnexpectedClose(new SmqException(SmqException.PONG_TMO));
+        }
+      }
+      else {
+        _pingActive=true;
+        add2UpstreamQ(outMsg(MSG_PING));
+      }
+    }
+  }
+
   private final void downstreamThreadFunc()
   {
     for(;;) {
@@ -933,16 +1026,14 @@ public class SMQ
     //System.out.println("Closing downstreamThreadFunc");
   }
 
-  private final void sockClose()
+  final void sockClose()
   {
     synchronized(_lock) {
-      try { if(_sock != null) _sock.close(); }
-      catch(IOException e) {}
-      _sock=null;
+      closeTransport();
+      _connGen++; // Drop the queued frames, see upstreamThreadFunc
       _is=null;
       _conState=0;
       _pingActive=false;
-      _upstreamQ.clear();
       _createAckM.clear();
       _SubAckM.clear();
       _createSubAckM.clear();
@@ -957,7 +1048,15 @@ public class SMQ
   }
 
 
-  private final short dispatchDownstreamMsg() throws SmqException
+  // Overridden by NioSMQ, which closes its channel.
+  void closeTransport()
+  {
+    try { if(_sock != null) _sock.close(); }
+    catch(IOException e) {}
+    _sock=null;
+  }
+
+  final short dispatchDownstreamMsg() throws SmqException
   {
     long tid;
     int len = readUnsignedShort();
@@ -1013,8 +1112,7 @@ public class SMQ
       doEx(SmqException.SERVER_DISCONNECT, e);
 
     case MSG_PING:
-      try { add2UpstreamQ(new OutMsg(MSG_PONG)); }
-      catch(IOException ignore) {}
+      add2UpstreamQ(outMsg(MSG_PONG));
       break;
 
     case MSG_PONG:
@@ -1035,7 +1133,7 @@ public class SMQ
   private final boolean sendTidMsg(short msgType, long tid)
   {
     try {
-      OutMsg msg = new OutMsg(msgType);
+      OutMsg msg = outMsg(msgType);
       msg.writeUnsignedInt(tid);
       add2UpstreamQ(msg);
       return true;
@@ -1047,12 +1145,9 @@ public class SMQ
 
   private final void manageOnChange(long subscribers, long tid)
   {
-    LinkedList<IntfOnChange> l;
-    synchronized(_lock) {
-      l = _changeM.get(tid);
-    }
-    if(l != null) {
-      for(IntfOnChange on : l)
+    IntfOnChange[] a = _changeM.get(tid);
+    if(a != null) {
+      for(IntfOnChange on : a)
         smqOnChange(on, subscribers, tid);
       if(tid2topic(tid) == null) { // if ephemeral ID
         assert subscribers == 0;
@@ -1106,12 +1201,12 @@ public class SMQ
     throw new SmqException(reason,cause);
   }
 
-  private final void manageUnexpectedClose(Throwable cause)
+  final void manageUnexpectedClose(Throwable cause)
   {
     manageUnexpectedClose(new SmqException(SmqException.DISCONNECT, cause));
   }
 
-  private final void manageUnexpectedClose(SmqException e)
+  final void manageUnexpectedClose(SmqException e)
   {
     boolean isRunning;
     synchronized(_lock) {
@@ -1164,14 +1259,9 @@ public class SMQ
 
   // Lookup key in Map and call the user callback smqOnMsg if found.
   // Used by runOnMsg below
-  private boolean runOnMsg(long key,Map<Long,LinkedList<IntfOnMsg>> map,Msg msg)
+  private boolean runOnMsg(long key,LongMap<IntfOnMsg[]> map,Msg msg)
   {
-    IntfOnMsg[] a = null;
-    synchronized(_lock) {
-      LinkedList<IntfOnMsg> l = map.get(key);
-      if(l != null)
-        a = l.toArray(new IntfOnMsg[0]);
-    }
+    IntfOnMsg[] a = map.get(key);
     //System.out.println("runOnMsg2 key "+key+", "+a);
     if(a != null) {
       for(IntfOnMsg on : a)
@@ -1187,10 +1277,7 @@ public class SMQ
     boolean found=false;
     Msg msg = new Msg(ptid, tid, subtid, data);
     if(subtid != 0) {
-      Map<Long,LinkedList<IntfOnMsg>> m = null;
-      synchronized(_lock) {
-        m = _callbackSubM.get(tid);
-      }
+      LongMap<IntfOnMsg[]> m = _callbackSubM.get(tid);
       if(m != null)
         found=runOnMsg(subtid, m, msg);
       //System.out.println("runOnMsg subtid "+tid+", "+subtid+", "+m+", "+found);
@@ -1219,25 +1306,51 @@ public class SMQ
   }
 
 
-  private class OutMsg {
-    ByteArrayOutputStream baos;
-    DataOutputStream dos;
-    public OutMsg(int msgType) throws IOException
+  /* An upstream frame, encoded in place in a reused buffer. OutMsg
+     objects are taken from the pool with outMsg() and returned with
+     releaseOutMsg() when sent. The 'next' field links the message in
+     an OutQ.
+   */
+  static final class OutMsg {
+    ByteBuffer buf;
+    Runnable task; // Queued close action instead of a frame
+    int gen; // SMQ._connGen when the message was taken from the pool
+    volatile OutMsg next;
+
+    OutMsg()
+    {
+      buf = ByteBuffer.allocate(256);
+    }
+
+    OutMsg(Runnable task)
+    {
+      this.task = task;
+    }
+
+    final OutMsg begin(int msgType)
     {
-      baos = new ByteArrayOutputStream();
-      dos = new DataOutputStream(baos); 
-      dos.writeShort(0); // Space for size
-      dos.writeByte(msgType);
+      buf.clear();
+      buf.putShort((short)0); // Space for size
+      buf.put((byte)msgType);
+      return this;
     }
-    public OutMsg(int msgType, String s) throws IOException
+
+    final void writeByte(int b) throws IOException
     {
-      this(msgType);
-      writeString(s, false);
+      ensure(1);
+      buf.put((byte)b);
     }
 
     final void writeUnsignedInt(long i) throws IOException
     {
-      dos.writeInt((int)i);
+      ensure(4);
+      buf.putInt((int)i);
+    }
+
+    final void write(byte[] b, int off, int len) throws IOException
+    {
+      ensure(len);
+      buf.put(b, off, len);
     }
 
     final void writeString(String s, boolean setLen) throws IOException
@@ -1245,25 +1358,94 @@ public class SMQ
       if(s != null) {
         byte[] bc = s.getBytes("UTF-8");
         if(setLen)
-          dos.writeByte(bc.length);
-        dos.write(bc);
+          writeByte(bc.length);
+        write(bc, 0, bc.length);
       }
       else if(setLen)
-        dos.writeByte(0);
+        writeByte(0);
+    }
+
+    // Grow the buffer, which is kept when the message is pooled.
+    private final void ensure(int len) throws IOException
+    {
+      if(buf.remaining() < len) {
+        int size = buf.position() + len;
+        if(size > 0xFFFF)
+          throw new IOException("Message overflow");
+        ByteBuffer b = ByteBuffer.allocate(Math.min(0xFFFF,
+                                           Math.max(size, buf.capacity()*2)));
+        buf.flip();
+        b.put(buf);
+        buf = b;
+      }
+    }
+
+    // Sets the frame size and returns the frame, ready to be sent.
+    final ByteBuffer frame()
+    {
+      buf.putShort(0, (short)buf.position());
+      buf.flip();
+      return buf;
     }
 
     final void send(Socket sock) throws IOException
     {
       if(sock == null)
         return;
-      dos.flush();
-      byte[] b = baos.toByteArray();
-      int len = b.length;
-      if(len > 0xFFFF)
-        throw new IOException("Message overflow");
-      b[0] = (byte)(len >> 8);
-      b[1] = (byte)len;
-      sock.getOutputStream().write(b);
+      ByteBuffer b = frame();
+      sock.getOutputStream().write(b.array(), 0, b.limit());
+    }
+  };
+
+  /* Lock free multi-producer single-consumer queue of OutMsg, linked
+     through OutMsg.next so that adding a message does not allocate
+     (Dmitry Vyukov's intrusive MPSC queue).
+   */
+  static final class OutQ {
+    private final OutMsg _stub = new OutMsg(null);
+    private final AtomicReference<OutMsg> _tail =
+      new AtomicReference<OutMsg>(_stub);
+    private OutMsg _head = _stub; // Consumer only
+
+    // Any thread.
+    final void add(OutMsg msg)
+    {
+      msg.next = null;
+      _tail.getAndSet(msg).next = msg;
+    }
+
+    // Any thread. False may be returned while a message is being added.
+    final boolean isEmpty()
+    {
+      return _tail.get() == _stub;
+    }
+
+    // Consumer thread. Returns null if the queue is empty, or if the
+    // next message is still being added.
+    final OutMsg poll()
+    {
+      OutMsg head = _head;
+      OutMsg next = head.next;
+      if(head == _stub) {
+        if(next == null)
+          return null;
+        _head = next;
+        head = next;
+        next = next.next;
+      }
+      if(next != null) {
+        _head = next;
+        return head;
+      }
+      if(head != _tail.get())
+        return null;
+      add(_stub);
+      next = head.next;
+      if(next != null) {
+        _head = next;
+        return head;
+      }
+      return null;
     }
   };
 
@@ -1272,66 +1454,75 @@ public class SMQ
     public void action(boolean accepted, String topic, long tid);
   };
 
-  private URL _smqUrl;
+  URL _smqUrl;
   private Proxy _proxy;
-  private TrustManager[] _trustMgr;
-  private HostnameVerifier _hostVerifier;
-  private Socket _sock=null;
-  private DataInputStream _is;
+  TrustManager[] _trustMgr;
+  HostnameVerifier _hostVerifier;
+  Socket _sock=null;
+  DataInputStream _is;
   private long _rand;
   private String _ipAddr;
-  private short _conState=0; // 0: not connected, 1: init, 2: connected.
+  volatile short _conState=0; // 0: not connected, 1: init, 2: connected.
   private long _etid=0;
   private Thread _upstreamThread=null;
   private Thread _downstreamThread=null;
   // Set to false in init,manageUnexpectedClose and true at end of connect.
-  private boolean _isRunning=false;
-  private Object _lock;
-  private IntfOnClose _onClose;
-  private long _recTimeStamp=0;
+  boolean _isRunning=false;
+  Object _lock;
+  IntfOnClose _onClose;
+  long _recTimeStamp=0;
   private boolean _pingActive=false;
 
-  private LinkedList<Runnable> _upstreamQ = new LinkedList<Runnable>();
+  private final OutQ _upstreamQ = new OutQ();
+  private volatile boolean _upstreamParked=false;
+  // Incremented when the connection is closed. Frames with an older
+  // generation are not sent.
+  private volatile int _connGen=0;
+  private final AtomicReferenceArray<OutMsg> _outMsgPool =
+    new AtomicReferenceArray<OutMsg>(32);
   private Map<String,LinkedList<OnMsgAck>> _createAckM = // MSG_CREATEACK
     new HashMap<String,LinkedList<OnMsgAck>>();
   private Map<String,LinkedList<OnMsgAck>> _SubAckM = // MSG_SUBACK
     new HashMap<String,LinkedList<OnMsgAck>>();
   private Map<String,LinkedList<OnMsgAck>> _createSubAckM = // MSG_CREATESUBACK
     new HashMap<String,LinkedList<OnMsgAck>>();
-  private Map<String,Long> _topic2tidM = new HashMap<String,Long>();
-  private Map<String,Long> _subtopic2tidM = new HashMap<String,Long>();
-  private Map<Long,String> _tid2topicM = new HashMap<Long,String>();
-  private Map<Long,String> _tid2subtopicM = new HashMap<Long,String>();
-
-  private Map<Long,Map<Long,LinkedList<IntfOnMsg>>> _callbackSubM =
-    new HashMap<Long,Map<Long,LinkedList<IntfOnMsg>>>();
-  private Map<Long,LinkedList<IntfOnMsg>> _callbackM =
-    new HashMap<Long,LinkedList<IntfOnMsg>>();
-  private Map<Long,LinkedList<IntfOnChange>> _changeM =
-    new HashMap<Long,LinkedList<IntfOnChange>>();
+  // The maps below are read without locking. They are modified with
+  // _lock held, which keeps the name and ID maps consistent.
+  private final Map<String,Long> _topic2tidM =
+    new ConcurrentHashMap<String,Long>();
+  private final Map<String,Long> _subtopic2tidM =
+    new ConcurrentHashMap<String,Long>();
+  private final LongMap<String> _tid2topicM = new LongMap<String>();
+  private final LongMap<String> _tid2subtopicM = new LongMap<String>();
+
+  private final LongMap<LongMap<IntfOnMsg[]>> _callbackSubM =
+    new LongMap<LongMap<IntfOnMsg[]>>();
+  private final LongMap<IntfOnMsg[]> _callbackM = new LongMap<IntfOnMsg[]>();
+  private final LongMap<IntfOnChange[]> _changeM =
+    new LongMap<IntfOnChange[]>();
 
   private static final short _version       = 1;
   private static final long _pingTmo        = 20 * 60 * 1000;
   private static final long _pongRespTmo    = 20 * 1000;
 
-  private static final short MSG_INIT         = 1;
-  private static final short MSG_CONNECT      = 2;
-  private static final short MSG_CONNACK      = 3;
-  private static final short MSG_SUBSCRIBE    = 4;
-  private static final short MSG_SUBACK       = 5;
-  private static final short MSG_CREATE       = 6;
-  private static final short MSG_CREATEACK    = 7;
-  private static final short MSG_PUBLISH      = 8;
-  private static final short MSG_UNSUBSCRIBE  = 9;
-  private static final short MSG_DISCONNECT   = 11;
-  private static final short MSG_PING         = 12;
-  private static final short MSG_PONG         = 13;
-  private static final short MSG_OBSERVE      = 14;
-  private static final short MSG_UNOBSERVE    = 15;
-  private static final short MSG_CHANGE       = 16;
-  private static final short MSG_CREATESUB    = 17;
-  private static final short MSG_CREATESUBACK = 18;
-  private static final short MSG_PUBFRAG      = 19;
+  static final short MSG_INIT         = 1;
+  static final short MSG_CONNECT      = 2;
+  static final short MSG_CONNACK      = 3;
+  static final short MSG_SUBSCRIBE    = 4;
+  static final short MSG_SUBACK       = 5;
+  static final short MSG_CREATE       = 6;
+  static final short MSG_CREATEACK    = 7;
+  static final short MSG_PUBLISH      = 8;
+  static final short MSG_UNSUBSCRIBE  = 9;
+  static final short MSG_DISCONNECT   = 11;
+  static final short MSG_PING         = 12;
+  static final short MSG_PONG         = 13;
+  static final short MSG_OBSERVE      = 14;
+  static final short MSG_UNOBSERVE    = 15;
+  static final short MSG_CHANGE       = 16;
+  static final short MSG_CREATESUB    = 17;
+  static final short MSG_CREATESUBACK = 18;
+  static final short MSG_PUBFRAG      = 19;
 
 }
 
@@ -0,0 +1,153 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.nio.channels.*;
+import java.util.*;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.*;
+
+/**
+   A small pool of I/O threads shared by {@link NioSMQ} instances. Each
+   thread runs one java.nio Selector and handles all socket I/O,
+   frame parsing, and ping/pong supervision for the connections
+   assigned to it. Connections are assigned to the threads round
+   robin when they connect.
+   <p>
+   The I/O threads are daemon threads. A process typically uses the
+   pool returned by {@link SMQSelector#getDefault}, which has one
+   thread per available processor, up to four.
+   <p>
+   Broker host names are resolved on separate daemon threads, created
+   as needed and kept for a minute, since a DNS lookup blocks and
+   would stall all connections handled by an I/O thread.
+ */
+public class SMQSelector
+{
+  /**
+     Create a pool with 'threads' I/O threads.
+     @param threads the number of I/O threads, at least one.
+   */
+  public SMQSelector(int threads) throws IOException
+  {
+    if(threads < 1)
+      throw new IllegalArgumentException("threads < 1");
+    _loops = new Loop[threads];
+    for(int i=0 ; i < threads ; i++)
+      _loops[i] = new Loop(i);
+  }
+
+  /** Returns the shared default pool, creating it on first use.
+   */
+  public static synchronized SMQSelector getDefault() throws IOException
+  {
+    if(_default == null) {
+      int threads = Math.min(4, Runtime.getRuntime().availableProcessors());
+      _default = new SMQSelector(Math.max(1, threads));
+    }
+    return _default;
+  }
+
+  /**
+     Stop the I/O threads. Connections still open when the pool is
+     closed are closed without notification.
+   */
+  public void close()
+  {
+    for(Loop loop : _loops)
+      loop.stop();
+    _resolverPool.shutdown();
+  }
+
+  final Loop next()
+  {
+    return _loops[(_next.getAndIncrement() & 0x7FFFFFFF) % _loops.length];
+  }
+
+  /* One I/O thread and its Selector. Tasks posted with execute() run
+     on the I/O thread before the ready keys are handled.
+   */
+  static final class Loop implements Runnable
+  {
+    Loop(int ix) throws IOException
+    {
+      selector = Selector.open();
+      _thread = new Thread(this, "SMQSelector-"+ix);
+      _thread.setDaemon(true);
+      _thread.start();
+    }
+
+    final void execute(Runnable r)
+    {
+      _tasks.add(r);
+      selector.wakeup();
+    }
+
+    final boolean inLoop()
+    {
+      return Thread.currentThread() == _thread;
+    }
+
+    final void stop()
+    {
+      _running = false;
+      selector.wakeup();
+    }
+
+    public void run()
+    {
+      long nextTick = System.currentTimeMillis() + _tickTmo;
+      while(_running) {
+        try { selector.select(_tickTmo); }
+        catch(IOException e) { break; }
+        Runnable r;
+        while((r = _tasks.poll()) != null) {
+          try { r.run(); }
+          catch(RuntimeException e) { e.printStackTrace(); }
+        }
+        Iterator<SelectionKey> it = selector.selectedKeys().iterator();
+        while(it.hasNext()) {
+          SelectionKey key = it.next();
+          it.remove();
+          try { ((NioSMQ)key.attachment()).ready(key); }
+          catch(RuntimeException e) { e.printStackTrace(); }
+        }
+        long now = System.currentTimeMillis();
+        if(now >= nextTick) {
+          nextTick = now + _tickTmo;
+          for(SelectionKey key : selector.keys().toArray(new SelectionKey[0])) {
+            if(key.isValid())
+              ((NioSMQ)key.attachment()).tick(now);
+          }
+        }
+      }
+      for(SelectionKey key : selector.keys()) {
+        try { key.channel().close(); }
+        catch(IOException ignore) {}
+      }
+      try { selector.close(); }
+      catch(IOException ignore) {}
+    }
+
+    final Selector selector;
+    private final Thread _thread;
+    private final ConcurrentLinkedQueue<Runnable> _tasks =
+      new ConcurrentLinkedQueue<Runnable>();
+    private volatile boolean _running=true;
+  };
+
+  private final ThreadPoolExecutor _resolverPool = new ThreadPoolExecutor(
+    0, Integer.MAX_VALUE, 60, TimeUnit.SECONDS,
+    new SynchronousQueue<Runnable>(), new ThreadFactory() {
+        public Thread newThread(Runnable r) {
+          Thread t = new Thread(r, "SMQResolver");
+          t.setDaemon(true);
+          return t;
+        }
+      });
+
+  final Executor resolver = _resolverPool; // Used by NioSMQ.initAsync
+  private final Loop[] _loops;
+  private final AtomicInteger _next = new AtomicInteger();
+  private static SMQSelector _default=null;
+  private static final long _tickTmo = 1000; // Ping and connect timeout check
+}
@@ -0,0 +1,30 @@
+package RTL.SMQ;
+
+import org.openjdk.jmh.results.format.ResultFormatType;
+import org.openjdk.jmh.runner.Runner;
+import org.openjdk.jmh.runner.options.*;
+
+/**
+   Runs the SMQ benchmarks and writes the results as JSON to
+   smq-bench.json. Accepts the JMH command line options; for example,
+   a benchmark name regexp selects benchmarks and -rff names another
+   result file.
+ */
+public class BenchMain
+{
+  public static void main(String[] args) throws Exception
+  {
+    CommandLineOptions cmd = new CommandLineOptions(args);
+    if(cmd.shouldHelp() || cmd.shouldList() || cmd.shouldListWithParams() ||
+       cmd.shouldListProfilers() || cmd.shouldListResultFormats()) {
+      org.openjdk.jmh.Main.main(args);
+      return;
+    }
+    ChainedOptionsBuilder opts = new OptionsBuilder().parent(cmd);
+    if( ! cmd.getResultFormat().hasValue() )
+      opts.resultFormat(ResultFormatType.JSON);
+    if( ! cmd.getResult().hasValue() )
+      opts.result("smq-bench.json");
+    new Runner(opts.build()).run();
+  }
+}
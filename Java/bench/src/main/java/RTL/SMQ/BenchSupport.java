@@ -0,0 +1,112 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.net.*;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+
+/* Helpers for benchmarks that drive an SMQ instance without a broker.
+ */
+final class BenchSupport
+{
+  private BenchSupport() {}
+
+  /* Returns an SMQ instance in the connected state, but without a
+     socket: the upstream thread drops the frames and the benchmark
+     feeds downstream frames through SMQ._is.
+   */
+  static SMQ offline() throws IOException
+  {
+    SMQ smq = new SMQ(new URL("http://localhost/"), null, null, null, null);
+    smq._conState = 2;
+    smq._isRunning = true;
+    return smq;
+  }
+
+  static byte[] frame(int msgType, byte[] body)
+  {
+    byte[] b = new byte[3 + body.length];
+    b[0] = (byte)(b.length >> 8);
+    b[1] = (byte)b.length;
+    b[2] = (byte)msgType;
+    System.arraycopy(body, 0, b, 3, body.length);
+    return b;
+  }
+
+  static byte[] publishFrame(long tid, long ptid, long subtid, byte[] data)
+  {
+    ByteArrayOutputStream baos = new ByteArrayOutputStream();
+    DataOutputStream dos = new DataOutputStream(baos);
+    try {
+      dos.writeInt((int)tid);
+      dos.writeInt((int)ptid);
+      dos.writeInt((int)subtid);
+      dos.write(data);
+    }
+    catch(IOException e) { throw new RuntimeException(e); }
+    return frame(SMQ.MSG_PUBLISH, baos.toByteArray());
+  }
+
+  /* Answer a pending create() or subscribe() by dispatching a
+     MSG_CREATEACK or MSG_SUBACK frame, as the broker would.
+   */
+  static void ack(SMQ smq, int msgType, long tid, String topic)
+    throws IOException, SmqException
+  {
+    ByteArrayOutputStream baos = new ByteArrayOutputStream();
+    DataOutputStream dos = new DataOutputStream(baos);
+    dos.writeByte(0); // Accepted
+    dos.writeInt((int)tid);
+    dos.write(topic.getBytes("UTF-8"));
+    smq._is = new DataInputStream(
+      new ByteArrayInputStream(frame(msgType, baos.toByteArray())));
+    smq.dispatchDownstreamMsg();
+  }
+
+  /* Spin until 'count' reaches 'target'. Throws IllegalStateException
+     after 10 seconds, for example if the sink thread or the broker
+     stand-in died, so that the benchmark fails instead of hanging.
+   */
+  static void await(AtomicLong count, long target, String what)
+  {
+    long deadline = System.nanoTime() + TimeUnit.SECONDS.toNanos(10);
+    while(count.get() < target) {
+      if(System.nanoTime() - deadline > 0)
+        throw new IllegalStateException(what + ": " + count.get() +
+                                        " of " + target);
+      Thread.yield();
+    }
+  }
+
+  /* Returns the same frame over and over, so dispatchDownstreamMsg()
+     can be called any number of times.
+   */
+  static final class Replay extends InputStream
+  {
+    Replay(byte[] frame)
+    {
+      _frame = frame;
+    }
+
+    public int read()
+    {
+      int b = _frame[_pos++] & 0xFF;
+      if(_pos == _frame.length)
+        _pos = 0;
+      return b;
+    }
+
+    public int read(byte[] b, int off, int len)
+    {
+      len = Math.min(len, _frame.length - _pos);
+      System.arraycopy(_frame, _pos, b, off, len);
+      _pos += len;
+      if(_pos == _frame.length)
+        _pos = 0;
+      return len;
+    }
+
+    private final byte[] _frame;
+    private int _pos=0;
+  };
+}
@@ -0,0 +1,232 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.net.*;
+import java.util.*;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+
+/* A minimal in-JVM SMQ broker for the end-to-end benchmarks. It
+   accepts http:// connections on the loopback interface, runs one
+   thread per connection, and implements what the benchmarks use: the
+   HTTP bootstrap, Connect, Subscribe, Create, Publish routing, Ping,
+   and Disconnect. Python/smqbroker.py is the complete stand-in.
+ */
+final class BrokerStandIn implements Runnable
+{
+  BrokerStandIn() throws IOException
+  {
+    _server = new ServerSocket(0, 50, InetAddress.getLoopbackAddress());
+    Thread t = new Thread(this, "BrokerStandIn");
+    t.setDaemon(true);
+    t.start();
+  }
+
+  URL url() throws MalformedURLException
+  {
+    return new URL("http://127.0.0.1:" + _server.getLocalPort() + "/");
+  }
+
+  void close()
+  {
+    try { _server.close(); }
+    catch(IOException ignore) {}
+    for(Peer p : _peers.values())
+      p.close();
+  }
+
+  public void run()
+  {
+    try {
+      for(;;) {
+        Thread t = new Thread(new Peer(_server.accept()), "BrokerStandIn-peer");
+        t.setDaemon(true);
+        t.start();
+      }
+    }
+    catch(IOException ignore) {} // Closed
+  }
+
+  private long topicId(String name)
+  {
+    Long tid = _topics.get(name);
+    if(tid == null) {
+      Long newTid = _ids.incrementAndGet();
+      tid = _topics.putIfAbsent(name, newTid);
+      if(tid == null)
+        tid = newTid;
+    }
+    return tid;
+  }
+
+  private final class Peer implements Runnable
+  {
+    Peer(Socket sock) throws IOException
+    {
+      _sock = sock;
+      sock.setTcpNoDelay(true);
+      _in = new DataInputStream(new BufferedInputStream(sock.getInputStream()));
+      _out = new BufferedOutputStream(sock.getOutputStream(), 0x10000);
+    }
+
+    public void run()
+    {
+      try {
+        bootstrap();
+        for(;;) {
+          int len = _in.readUnsignedShort();
+          if(len < 3)
+            break;
+          byte[] f = new byte[len];
+          f[0] = (byte)(len >> 8);
+          f[1] = (byte)len;
+          _in.readFully(f, 2, len - 2);
+          if( ! handle(f[2] & 0xFF, f) )
+            break;
+          if(_in.available() == 0) { // Flush when the input is drained
+            for(Peer p : _written)
+              p.flush();
+            _written.clear();
+          }
+        }
+      }
+      catch(IOException ignore) {}
+      close();
+    }
+
+    private void bootstrap() throws IOException
+    {
+      int last = 0; // The last four bytes, looking for CRLF CRLF
+      while(last != 0x0D0A0D0A) {
+        int b = _in.read();
+        if(b < 0)
+          throw new EOFException();
+        last = (last << 8) | b;
+      }
+      _out.write("HTTP/1.1 200 OK\r\nSmqBroker: 1\r\nContent-Length: 0\r\n\r\n"
+                 .getBytes("ISO-8859-1"));
+      byte[] ip = "127.0.0.1".getBytes("ISO-8859-1");
+      byte[] init = new byte[5 + ip.length];
+      init[0] = 1; // Version
+      System.arraycopy(ip, 0, init, 5, ip.length);
+      _out.write(BenchSupport.frame(SMQ.MSG_INIT, init));
+      _out.flush();
+    }
+
+    private boolean handle(int msgType, byte[] f) throws IOException
+    {
+      switch(msgType) {
+      case SMQ.MSG_CONNECT:
+        _etid = _ids.incrementAndGet();
+        _peers.put(_etid, this);
+        reply(SMQ.MSG_CONNACK, 0, _etid, null);
+        break;
+
+      case SMQ.MSG_SUBSCRIBE:
+      case SMQ.MSG_CREATE:
+      case SMQ.MSG_CREATESUB:
+        byte[] name = Arrays.copyOfRange(f, 3, f.length);
+        long tid = topicId((msgType == SMQ.MSG_CREATESUB ? "/" : "") +
+                           new String(name, "UTF-8"));
+        if(msgType == SMQ.MSG_SUBSCRIBE) {
+          List<Peer> l = _subscribers.get(tid);
+          if(l == null) {
+            _subscribers.putIfAbsent(tid, new CopyOnWriteArrayList<Peer>());
+            l = _subscribers.get(tid);
+          }
+          l.add(this);
+        }
+        reply(msgType == SMQ.MSG_SUBSCRIBE ? SMQ.MSG_SUBACK :
+              msgType == SMQ.MSG_CREATE ? SMQ.MSG_CREATEACK :
+              SMQ.MSG_CREATESUBACK, 0, tid, name);
+        break;
+
+      case SMQ.MSG_PUBLISH:
+        if(f.length < 15)
+          return false;
+        long dst = ((f[3] & 0xFFL) << 24) | ((f[4] & 0xFF) << 16) |
+          ((f[5] & 0xFF) << 8) | (f[6] & 0xFF);
+        List<Peer> subscribers = _subscribers.get(dst);
+        if(subscribers != null) {
+          for(Peer p : subscribers)
+            p.send(f, _written);
+        }
+        else {
+          Peer p = _peers.get(dst);
+          if(p != null)
+            p.send(f, _written);
+        }
+        break;
+
+      case SMQ.MSG_PING:
+        send(BenchSupport.frame(SMQ.MSG_PONG, new byte[0]), _written);
+        break;
+
+      case SMQ.MSG_DISCONNECT:
+        return false;
+
+      default: // Unsubscribe, observe, pong: not needed by the benchmarks
+        break;
+      }
+      return true;
+    }
+
+    private void reply(int msgType, int status, long tid, byte[] name)
+      throws IOException
+    {
+      byte[] b = new byte[5 + (name == null ? 0 : name.length)];
+      b[0] = (byte)status;
+      b[1] = (byte)(tid >> 24);
+      b[2] = (byte)(tid >> 16);
+      b[3] = (byte)(tid >> 8);
+      b[4] = (byte)tid;
+      if(name != null)
+        System.arraycopy(name, 0, b, 5, name.length);
+      send(BenchSupport.frame(msgType, b), _written);
+    }
+
+    // Buffer a frame; the sender flushes the peers it wrote to.
+    private void send(byte[] f, List<Peer> written)
+    {
+      try {
+        synchronized(this) { _out.write(f); }
+        if( ! written.contains(this) )
+          written.add(this);
+      }
+      catch(IOException e) { close(); }
+    }
+
+    private void flush()
+    {
+      try {
+        synchronized(this) { _out.flush(); }
+      }
+      catch(IOException e) { close(); }
+    }
+
+    void close()
+    {
+      if(_etid != 0)
+        _peers.remove(_etid);
+      for(List<Peer> l : _subscribers.values())
+        l.remove(this);
+      try { _sock.close(); }
+      catch(IOException ignore) {}
+    }
+
+    private final Socket _sock;
+    private final DataInputStream _in;
+    private final BufferedOutputStream _out;
+    private final List<Peer> _written = new ArrayList<Peer>(); // Reader only
+    private volatile long _etid=0;
+  };
+
+  private final ServerSocket _server;
+  private final AtomicLong _ids = new AtomicLong();
+  private final ConcurrentMap<String,Long> _topics =
+    new ConcurrentHashMap<String,Long>();
+  private final ConcurrentMap<Long,Peer> _peers =
+    new ConcurrentHashMap<Long,Peer>();
+  private final ConcurrentMap<Long,List<Peer>> _subscribers =
+    new ConcurrentHashMap<Long,List<Peer>>();
+}
@@ -0,0 +1,52 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.*;
+
+/**
+   Measures downstream decoding and dispatch: dispatchDownstreamMsg()
+   reading a MSG_PUBLISH frame and calling the subscriber's callback.
+ */
+@State(Scope.Thread)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations=3, time=1)
+@Measurement(iterations=5, time=1)
+@Fork(1)
+public class DispatchBench
+{
+  static final long TID = 1000;
+
+  @Param({"16", "1024", "16384"})
+  public int size;
+
+  private SMQ _smq;
+  private long _received=0;
+
+  @Setup
+  public void setup() throws IOException, SmqException
+  {
+    _smq = BenchSupport.offline();
+    _smq.subscribe("bench", new IntfOnMsg() {
+        public void smqOnMsg(Msg msg) { _received++; }
+      }, null);
+    BenchSupport.ack(_smq, SMQ.MSG_SUBACK, TID, "bench");
+    _smq._is = new DataInputStream(new BenchSupport.Replay(
+      BenchSupport.publishFrame(TID, 2, 0, new byte[size])));
+  }
+
+  @TearDown
+  public void tearDown()
+  {
+    if(_received == 0)
+      throw new IllegalStateException("No message dispatched");
+    _smq.close(false, null);
+  }
+
+  @Benchmark
+  public short publish() throws SmqException
+  {
+    return _smq.dispatchDownstreamMsg();
+  }
+}
@@ -0,0 +1,61 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.nio.ByteBuffer;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.*;
+
+/**
+   Measures upstream frame encoding: taking an OutMsg from the pool,
+   encoding a frame in place, and returning the message to the pool.
+ */
+@State(Scope.Thread)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations=3, time=1)
+@Measurement(iterations=5, time=1)
+@Fork(1)
+public class EncodeBench
+{
+  @Param({"16", "1024", "16384"})
+  public int size;
+
+  private SMQ _smq;
+  private byte[] _data;
+
+  @Setup
+  public void setup() throws IOException
+  {
+    _smq = BenchSupport.offline();
+    _data = new byte[size];
+  }
+
+  @TearDown
+  public void tearDown()
+  {
+    _smq.close(false, null);
+  }
+
+  @Benchmark
+  public int publishFrame() throws IOException
+  {
+    SMQ.OutMsg msg = _smq.outMsg(SMQ.MSG_PUBLISH);
+    msg.writeUnsignedInt(1);
+    msg.writeUnsignedInt(2);
+    msg.writeUnsignedInt(0);
+    msg.write(_data, 0, _data.length);
+    ByteBuffer frame = msg.frame();
+    int len = frame.remaining();
+    _smq.releaseOutMsg(msg);
+    return len;
+  }
+
+  @Benchmark
+  public int subscribeFrame() throws IOException
+  {
+    SMQ.OutMsg msg = _smq.outMsg(SMQ.MSG_SUBSCRIBE, "sensors/temperature");
+    int len = msg.frame().remaining();
+    _smq.releaseOutMsg(msg);
+    return len;
+  }
+}
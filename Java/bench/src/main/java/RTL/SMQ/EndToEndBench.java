@@ -0,0 +1,100 @@
+package RTL.SMQ;
+
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+import org.openjdk.jmh.annotations.*;
+
+/**
+   Publish to receive over loopback, through the in-JVM broker
+   stand-in, with one NioSMQ publisher and one NioSMQ subscriber. The
+   threaded SMQ client is not used since its bootstrap requires HTTPS.
+ */
+@State(Scope.Benchmark)
+@Warmup(iterations=3, time=2)
+@Measurement(iterations=5, time=2)
+@Fork(1)
+public class EndToEndBench
+{
+  static final int BATCH = 1000;
+
+  @Param({"16", "1024"})
+  public int size;
+
+  private BrokerStandIn _broker;
+  private SMQSelector _selector;
+  private NioSMQ _pub;
+  private NioSMQ _sub;
+  private long _tid;
+  private byte[] _data;
+  private long _sent=0;
+  private final AtomicLong _received = new AtomicLong();
+
+  @Setup
+  public void setup() throws Exception
+  {
+    _data = new byte[size];
+    _broker = new BrokerStandIn();
+    _selector = new SMQSelector(2);
+    _sub = new NioSMQ(_broker.url(), null, null, null, _selector, null);
+    _sub.connect("sub".getBytes("UTF-8"), null, null);
+    _pub = new NioSMQ(_broker.url(), null, null, null, _selector, null);
+    _pub.connect("pub".getBytes("UTF-8"), null, null);
+    final CountDownLatch acks = new CountDownLatch(2);
+    final long[] tid = new long[1];
+    _sub.subscribe("bench", new IntfOnMsg() {
+        public void smqOnMsg(Msg msg) { _received.incrementAndGet(); }
+      }, new IntfOnCreateAck() {
+          public void smqOnCreateAck(boolean accepted, String topic, long t,
+                                     String subtopic, long subtid) {
+            acks.countDown();
+          }
+        });
+    _pub.create("bench", new IntfOnCreateAck() {
+        public void smqOnCreateAck(boolean accepted, String topic, long t,
+                                   String subtopic, long subtid) {
+          tid[0] = t;
+          acks.countDown();
+        }
+      });
+    if( ! acks.await(10, TimeUnit.SECONDS) )
+      throw new IllegalStateException("No response from the broker stand-in");
+    _tid = tid[0];
+  }
+
+  @TearDown
+  public void tearDown()
+  {
+    _pub.close(false, null);
+    _sub.close(false, null);
+    _selector.close();
+    _broker.close();
+  }
+
+  private void await()
+  {
+    BenchSupport.await(_received, _sent,
+                       "Messages received from the broker stand-in");
+  }
+
+  @Benchmark
+  @BenchmarkMode(Mode.Throughput)
+  @OutputTimeUnit(TimeUnit.SECONDS)
+  @OperationsPerInvocation(BATCH)
+  public void throughput() throws SmqException
+  {
+    for(int i=0 ; i < BATCH ; i++)
+      _pub.publish(_tid, 0, _data, 0, _data.length);
+    _sent += BATCH;
+    await();
+  }
+
+  @Benchmark
+  @BenchmarkMode(Mode.SampleTime)
+  @OutputTimeUnit(TimeUnit.MICROSECONDS)
+  public void latency() throws SmqException
+  {
+    _pub.publish(_tid, 0, _data, 0, _data.length);
+    _sent++;
+    await();
+  }
+}
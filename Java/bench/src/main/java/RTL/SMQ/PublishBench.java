@@ -0,0 +1,96 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.net.*;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+import org.openjdk.jmh.annotations.*;
+
+/**
+   Measures SMQ.publish(long tid, long subtid, byte[] b, int off, int
+   len) through the upstream thread to a loopback socket. The socket is
+   drained by a sink thread, so no broker is needed.
+   <p>
+   Each invocation publishes BATCH messages and waits until the sink
+   has received them. The score is therefore the rate at which the
+   upstream path delivers messages to the socket, and the queue cannot
+   grow without bound when the publishers are faster than the writer.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations=3, time=2)
+@Measurement(iterations=5, time=2)
+@Fork(1)
+public class PublishBench
+{
+  static final int BATCH = 1000;
+  static final int HEADER = 15; // Size, type, tid, etid, subtid
+
+  @Param({"16", "256", "4096"})
+  public int size;
+
+  private ServerSocket _server;
+  private SMQ _smq;
+  private byte[] _data;
+  private final AtomicLong _sent = new AtomicLong();
+  private final AtomicLong _received = new AtomicLong();
+
+  @Setup
+  public void setup() throws IOException
+  {
+    _server = new ServerSocket(0, 1, InetAddress.getLoopbackAddress());
+    Thread sink = new Thread() {
+        public void run() {
+          try {
+            Socket s = _server.accept();
+            InputStream in = s.getInputStream();
+            byte[] b = new byte[0x10000];
+            int n;
+            while((n = in.read(b)) > 0)
+              _received.addAndGet(n);
+          }
+          catch(IOException ignore) {}
+        }
+      };
+    sink.setDaemon(true);
+    sink.start();
+    _smq = new SMQ(new URL("http://localhost/"), null, null, null, null);
+    _smq._sock = new Socket(InetAddress.getLoopbackAddress(),
+                            _server.getLocalPort());
+    _smq._sock.setTcpNoDelay(true);
+    _smq._conState = 2; // As if connect() succeeded
+    _smq._isRunning = true;
+    _data = new byte[size];
+  }
+
+  @TearDown
+  public void tearDown() throws IOException
+  {
+    _smq.close(false, null);
+    _server.close();
+  }
+
+  @Benchmark
+  @OperationsPerInvocation(BATCH)
+  public void publish() throws SmqException
+  {
+    publishBatch();
+  }
+
+  @Benchmark
+  @OperationsPerInvocation(BATCH)
+  @Threads(4)
+  public void publish4Threads() throws SmqException
+  {
+    publishBatch();
+  }
+
+  private void publishBatch() throws SmqException
+  {
+    for(int i=0 ; i < BATCH ; i++)
+      _smq.publish(1, 0, _data, 0, _data.length);
+    long target = _sent.addAndGet((long)BATCH * (HEADER + size));
+    BenchSupport.await(_received, target, "Bytes received by the sink");
+  }
+}
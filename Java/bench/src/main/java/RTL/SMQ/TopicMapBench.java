@@ -0,0 +1,139 @@
+package RTL.SMQ;
+
+import java.io.*;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.*;
+
+/**
+   Measures topic2tid() and tid2topic() from several threads, alone
+   and while another thread dispatches published messages, which
+   uses the same client state.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations=3, time=1)
+@Measurement(iterations=5, time=1)
+@Fork(1)
+public class TopicMapBench
+{
+  static final int TOPICS = 64; // Power of two
+  static final long TID = 1000;
+
+  private SMQ _smq;
+  private final String[] _topics = new String[TOPICS];
+
+  @State(Scope.Thread)
+  public static class Cursor
+  {
+    int ix=0;
+  }
+
+  @Setup
+  public void setup() throws IOException, SmqException
+  {
+    _smq = BenchSupport.offline();
+    IntfOnCreateAck ack = new IntfOnCreateAck() {
+        public void smqOnCreateAck(boolean accepted, String topic, long tid,
+                                   String subtopic, long subtid) {}
+      };
+    for(int i=0 ; i < TOPICS ; i++) {
+      _topics[i] = "sensors/" + i;
+      _smq.create(_topics[i], ack);
+      BenchSupport.ack(_smq, SMQ.MSG_CREATEACK, TID + i, _topics[i]);
+    }
+    _smq.subscribe(_topics[0], new IntfOnMsg() {
+        public void smqOnMsg(Msg msg) {}
+      }, null);
+    BenchSupport.ack(_smq, SMQ.MSG_SUBACK, TID, _topics[0]);
+    for(int i=0 ; i < TOPICS ; i++) {
+      check(_smq.topic2tid(_topics[i]) == TID + i, "topic2tid " + _topics[i]);
+      check(_topics[i].equals(_smq.tid2topic(TID + i)), "tid2topic " + (TID+i));
+    }
+    checkLongMap();
+    _smq._is = new DataInputStream(new BenchSupport.Replay(
+      BenchSupport.publishFrame(TID, 2, 0, new byte[16])));
+  }
+
+  @TearDown
+  public void tearDown()
+  {
+    _smq.close(false, null);
+  }
+
+  /* Checks that LongMap round-trips put, get, and remove, including
+     key 0, which is stored outside the table, and the removal of a key
+     in the middle of a probe sequence. The benchmark fails instead of
+     measuring a broken map.
+   */
+  static void checkLongMap()
+  {
+    LongMap<Long> m = new LongMap<Long>();
+    check(m.get(0) == null && m.get(1) == null, "empty map");
+    m.put(0, -1L);
+    check(m.get(0) == -1L, "key 0");
+    // Three keys in the same slot of the initial 8 slot table.
+    long[] c = new long[3];
+    int n=0;
+    for(long k=1 ; n < c.length ; k++) {
+      if((LongMap.hash(k) & 7) == (LongMap.hash(1) & 7))
+        c[n++] = k;
+    }
+    for(long k : c)
+      m.put(k, k);
+    check(m.remove(c[1]) == c[1], "remove colliding key");
+    check(m.get(c[1]) == null, "removed colliding key");
+    check(m.get(c[0]) == c[0] && m.get(c[2]) == c[2], "collision chain");
+    check(m.remove(c[1]) == null, "remove missing key");
+    m.put(c[2], -2L);
+    check(m.get(c[2]) == -2L, "replace");
+    for(long k=1 ; k <= 1000 ; k++)
+      m.put(k * 0x100000000L + k, k); // Grows the table
+    check(m.get(0) == -1L, "key 0 after growing");
+    for(long k=1 ; k <= 1000 ; k += 2)
+      check(m.remove(k * 0x100000000L + k) == k, "remove " + k);
+    for(long k=1 ; k <= 1000 ; k++) {
+      Long v = m.get(k * 0x100000000L + k);
+      check(k % 2 == 0 ? v != null && v == k : v == null, "get " + k);
+    }
+    check(m.remove(0) == -1L && m.get(0) == null, "remove key 0");
+    check(m.get(c[0]) == c[0] && m.get(c[2]) == -2L, "keys after removals");
+    m.clear();
+    check(m.get(c[0]) == null && m.get(0) == null, "clear");
+  }
+
+  private static void check(boolean ok, String what)
+  {
+    if( ! ok )
+      throw new IllegalStateException("Check failed: " + what);
+  }
+
+  private long lookupOnce(Cursor c)
+  {
+    long tid = _smq.topic2tid(_topics[c.ix++ & (TOPICS-1)]);
+    return _smq.tid2topic(tid) != null ? tid : -1;
+  }
+
+  @Benchmark
+  @Threads(4)
+  public long lookup4Threads(Cursor c)
+  {
+    return lookupOnce(c);
+  }
+
+  @Benchmark
+  @Group("withDispatch")
+  @GroupThreads(3)
+  public long lookup(Cursor c)
+  {
+    return lookupOnce(c);
+  }
+
+  @Benchmark
+  @Group("withDispatch")
+  @GroupThreads(1)
+  public short dispatch() throws SmqException
+  {
+    return _smq.dispatchDownstreamMsg();
+  }
+}
@@ -0,0 +1,840 @@
+/*
+  Optional accelerator for smqclient.py (CPython C API, no other
+  dependencies). smqclient.py uses the pure-Python versions of these
+  objects when the module is not built.
+
+  Build in place:
+    python setup.py build_ext --inplace
+
+  FrameReader   splits SMQ packets from received data. Data can be
+                received straight into its buffer, and packet bodies
+                returned as bytes copies or as memoryview slices.
+  CallbackTable maps (tid, subtid) and (tid, catch-all) to the
+                subscription entry and decodes publish packets in the
+                same call.
+  encode_packet, encode_publish, decode_publish
+                build and parse packets with one allocation.
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_BUFFER 0x4000
+#define MAX_PACKET 0xFFFF
+
+
+static uint32_t
+getU32(const unsigned char* p)
+{
+   return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+      ((uint32_t)p[2] << 8) | p[3];
+}
+
+
+static void
+putU32(unsigned char* p, uint32_t v)
+{
+   p[0] = (unsigned char)(v >> 24);
+   p[1] = (unsigned char)(v >> 16);
+   p[2] = (unsigned char)(v >> 8);
+   p[3] = (unsigned char)v;
+}
+
+
+/* Convert a Python int to a 32-bit ID. Returns -1 with an exception set. */
+static int
+toU32(PyObject* obj, uint32_t* v)
+{
+   unsigned long x = PyLong_AsUnsignedLong(obj);
+   if(x == (unsigned long)-1 && PyErr_Occurred())
+      return -1;
+   if(x > 0xFFFFFFFFUL)
+   {
+      PyErr_SetString(PyExc_OverflowError, "ID does not fit in 32 bits");
+      return -1;
+   }
+   *v = (uint32_t)x;
+   return 0;
+}
+
+
+/****************************************************************************
+                                 FrameReader
+ ****************************************************************************/
+
+/* The received data is kept in a bytearray, 'store', between 'start'
+   and 'end'. Bytes are appended at 'end' by feed() or by filling the
+   writable() view with recv_into(). Packets are consumed at 'start'.
+   When the free space at the end runs low, the unconsumed tail is moved
+   to the front, so a packet is always contiguous and next_view() can
+   return it as a memoryview slice without copying.
+
+   A view returned by next_view() is valid until the next call to
+   feed() or writable(), which may move the data it points to. The
+   store is replaced, not resized, when it must grow; old views keep
+   the old store alive.
+*/
+typedef struct
+{
+   PyObject_HEAD
+   PyObject* store; /* bytearray */
+   PyObject* view; /* memoryview of 'store' */
+   Py_ssize_t start;
+   Py_ssize_t end;
+} FrameReader;
+
+
+static char*
+FrameReader_data(FrameReader* o)
+{
+   return PyByteArray_AS_STRING(o->store);
+}
+
+
+static Py_ssize_t
+FrameReader_cap(FrameReader* o)
+{
+   return o->store ? PyByteArray_GET_SIZE(o->store) : 0;
+}
+
+
+/* Make room for 'extra' bytes at the end of the buffered data */
+static int
+FrameReader_reserve(FrameReader* o, Py_ssize_t extra)
+{
+   Py_ssize_t cap = FrameReader_cap(o);
+   Py_ssize_t len = o->end - o->start;
+   PyObject* store;
+   PyObject* view;
+   if(cap - o->end >= extra)
+      return 0;
+   if(len + extra <= cap)
+   {
+      memmove(FrameReader_data(o), FrameReader_data(o) + o->start, len);
+      o->start = 0;
+      o->end = len;
+      return 0;
+   }
+   if(cap < MIN_BUFFER)
+      cap = MIN_BUFFER;
+   while(cap < len + extra)
+   {
+      if(cap > PY_SSIZE_T_MAX / 2)
+      {
+         PyErr_NoMemory();
+         return -1;
+      }
+      cap *= 2;
+   }
+   store = PyByteArray_FromStringAndSize(NULL, cap);
+   if(!store)
+      return -1;
+   view = PyMemoryView_FromObject(store);
+   if(!view)
+   {
+      Py_DECREF(store);
+      return -1;
+   }
+   if(len)
+      memcpy(PyByteArray_AS_STRING(store), FrameReader_data(o) + o->start, len);
+   Py_XSETREF(o->view, view);
+   Py_XSETREF(o->store, store);
+   o->start = 0;
+   o->end = len;
+   return 0;
+}
+
+
+static PyObject*
+FrameReader_feed(FrameReader* o, PyObject* arg)
+{
+   Py_buffer view;
+   if(PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE))
+      return NULL;
+   if(FrameReader_reserve(o, view.len))
+   {
+      PyBuffer_Release(&view);
+      return NULL;
+   }
+   if(view.len)
+   {
+      memcpy(FrameReader_data(o) + o->end, view.buf, view.len);
+      o->end += view.len;
+   }
+   PyBuffer_Release(&view);
+   Py_RETURN_NONE;
+}
+
+
+/* The free space is at least half of MIN_BUFFER and at least what the
+   partially received packet at 'start' still needs.
+*/
+static PyObject*
+FrameReader_writable(FrameReader* o, PyObject* Py_UNUSED(ignored))
+{
+   Py_ssize_t len = o->end - o->start;
+   Py_ssize_t extra = MIN_BUFFER / 2;
+   if(len >= 2)
+   {
+      const unsigned char* p =
+         (const unsigned char*)FrameReader_data(o) + o->start;
+      Py_ssize_t missing = (((Py_ssize_t)p[0] << 8) | p[1]) - len;
+      if(missing > extra)
+         extra = missing;
+   }
+   if(FrameReader_reserve(o, extra))
+      return NULL;
+   return PySequence_GetSlice(o->view, o->end, FrameReader_cap(o));
+}
+
+
+static PyObject*
+FrameReader_commit(FrameReader* o, PyObject* arg)
+{
+   Py_ssize_t n = PyLong_AsSsize_t(arg);
+   if(n == -1 && PyErr_Occurred())
+      return NULL;
+   if(n < 0 || n > FrameReader_cap(o) - o->end)
+   {
+      PyErr_SetString(PyExc_ValueError, "commit size out of range");
+      return NULL;
+   }
+   o->end += n;
+   Py_RETURN_NONE;
+}
+
+
+/* Returns a new (msg_type, body) tuple, NULL without an exception if
+   no complete packet is buffered, or NULL with an exception. The body
+   is a bytes copy or, if 'asView' is set, a memoryview slice.
+*/
+static PyObject*
+FrameReader_take(FrameReader* o, int asView)
+{
+   const unsigned char* p;
+   Py_ssize_t length;
+   PyObject* body;
+   if(o->end - o->start < 3)
+      return NULL;
+   p = (const unsigned char*)FrameReader_data(o) + o->start;
+   length = ((Py_ssize_t)p[0] << 8) | p[1];
+   if(length < 3)
+   {
+      PyErr_SetString(PyExc_ValueError, "invalid SMQ packet length");
+      return NULL;
+   }
+   if(o->end - o->start < length)
+      return NULL;
+   body = asView ?
+      PySequence_GetSlice(o->view, o->start + 3, o->start + length) :
+      PyBytes_FromStringAndSize((const char*)p + 3, length - 3);
+   if(!body)
+      return NULL;
+   o->start += length;
+   if(o->start == o->end)
+      o->start = o->end = 0;
+   return Py_BuildValue("(iN)", (int)p[2], body);
+}
+
+
+static PyObject*
+FrameReader_iternext(FrameReader* o)
+{
+   return FrameReader_take(o, 0);
+}
+
+
+static PyObject*
+FrameReader_next(FrameReader* o, PyObject* Py_UNUSED(ignored))
+{
+   PyObject* packet = FrameReader_take(o, 0);
+   if(packet || PyErr_Occurred())
+      return packet;
+   Py_RETURN_NONE;
+}
+
+
+static PyObject*
+FrameReader_nextView(FrameReader* o, PyObject* Py_UNUSED(ignored))
+{
+   PyObject* packet = FrameReader_take(o, 1);
+   if(packet || PyErr_Occurred())
+      return packet;
+   Py_RETURN_NONE;
+}
+
+
+static PyObject*
+FrameReader_clear(FrameReader* o, PyObject* Py_UNUSED(ignored))
+{
+   o->start = o->end = 0;
+   Py_RETURN_NONE;
+}
+
+
+static Py_ssize_t
+FrameReader_length(FrameReader* o)
+{
+   return o->end - o->start;
+}
+
+
+static void
+FrameReader_dealloc(FrameReader* o)
+{
+   Py_XDECREF(o->view);
+   Py_XDECREF(o->store);
+   Py_TYPE(o)->tp_free((PyObject*)o);
+}
+
+
+static PyMethodDef FrameReader_methods[] = {
+   {"feed", (PyCFunction)FrameReader_feed, METH_O,
+    "feed(data)\n--\n\nAppend received bytes."},
+   {"writable", (PyCFunction)FrameReader_writable, METH_NOARGS,
+    "writable()\n--\n\n"
+    "Return a memoryview of free buffer space for recv_into(), large\n"
+    "enough for the rest of a partially received packet;\n"
+    "call commit() with the number of bytes received."},
+   {"commit", (PyCFunction)FrameReader_commit, METH_O,
+    "commit(n)\n--\n\nAppend n bytes written to the writable() view."},
+   {"next", (PyCFunction)FrameReader_next, METH_NOARGS,
+    "next()\n--\n\nReturn the next (msg_type, body) packet or None."},
+   {"next_view", (PyCFunction)FrameReader_nextView, METH_NOARGS,
+    "next_view()\n--\n\n"
+    "Return the next (msg_type, memoryview body) packet or None. The view\n"
+    "is valid until the next feed() or writable() call."},
+   {"clear", (PyCFunction)FrameReader_clear, METH_NOARGS,
+    "clear()\n--\n\nDiscard all buffered bytes."},
+   {NULL}
+};
+
+static PySequenceMethods FrameReader_sequence = {
+   .sq_length = (lenfunc)FrameReader_length,
+};
+
+static PyTypeObject FrameReaderType = {
+   PyVarObject_HEAD_INIT(NULL, 0)
+   .tp_name = "_smqaccel.FrameReader",
+   .tp_doc = "Split SMQ packets from a byte stream.\n"
+   "Iterating yields the buffered (msg_type, body) packets.",
+   .tp_basicsize = sizeof(FrameReader),
+   .tp_flags = Py_TPFLAGS_DEFAULT,
+   .tp_new = PyType_GenericNew,
+   .tp_dealloc = (destructor)FrameReader_dealloc,
+   .tp_iter = PyObject_SelfIter,
+   .tp_iternext = (iternextfunc)FrameReader_iternext,
+   .tp_methods = FrameReader_methods,
+   .tp_as_sequence = &FrameReader_sequence,
+};
+
+
+/****************************************************************************
+                                CallbackTable
+ ****************************************************************************/
+
+/* Open addressing hash map, linear probing, with backward shift
+   deletion. Catch-all entries use a separate map keyed by tid.
+*/
+typedef struct
+{
+   uint64_t key;
+   PyObject* value; /* NULL: empty slot */
+} Slot;
+
+typedef struct
+{
+   Slot* slots;
+   Py_ssize_t cap; /* Power of 2 or 0 */
+   Py_ssize_t used;
+} Map;
+
+typedef struct
+{
+   PyObject_HEAD
+   Map exact; /* (tid << 32) | subtid */
+   Map all; /* tid */
+} CallbackTable;
+
+
+static Py_ssize_t
+Map_index(const Map* m, uint64_t key)
+{
+   return (Py_ssize_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (m->cap - 1);
+}
+
+
+static PyObject*
+Map_get(const Map* m, uint64_t key)
+{
+   Py_ssize_t i;
+   if(!m->used)
+      return NULL;
+   for(i = Map_index(m, key) ; m->slots[i].value ; i = (i + 1) & (m->cap - 1))
+   {
+      if(m->slots[i].key == key)
+         return m->slots[i].value;
+   }
+   return NULL;
+}
+
+
+static int
+Map_grow(Map* m)
+{
+   Py_ssize_t i, cap = m->cap ? m->cap * 2 : 16;
+   Slot* old = m->slots;
+   Py_ssize_t oldCap = m->cap;
+   Slot* slots = (Slot*)PyMem_Calloc(cap, sizeof(Slot));
+   if(!slots)
+   {
+      PyErr_NoMemory();
+      return -1;
+   }
+   m->slots = slots;
+   m->cap = cap;
+   for(i = 0 ; i < oldCap ; i++)
+   {
+      if(old[i].value)
+      {
+         Py_ssize_t j = Map_index(m, old[i].key);
+         while(slots[j].value)
+            j = (j + 1) & (cap - 1);
+         slots[j] = old[i];
+      }
+   }
+   PyMem_Free(old);
+   return 0;
+}
+
+
+/* Steals a reference to 'value' on success */
+static int
+Map_set(Map* m, uint64_t key, PyObject* value)
+{
+   Py_ssize_t i;
+   if((m->used + 1) * 4 > m->cap * 3 && Map_grow(m))
+      return -1;
+   for(i = Map_index(m, key) ; m->slots[i].value ; i = (i + 1) & (m->cap - 1))
+   {
+      if(m->slots[i].key == key)
+      {
+         Py_SETREF(m->slots[i].value, value);
+         return 0;
+      }
+   }
+   m->slots[i].key = key;
+   m->slots[i].value = value;
+   m->used++;
+   return 0;
+}
+
+
+/* Remove slot 'i' and shift the following cluster entries back */
+static void
+Map_removeAt(Map* m, Py_ssize_t i)
+{
+   Py_ssize_t j = i;
+   PyObject* value = m->slots[i].value;
+   m->slots[i].value = NULL;
+   m->used--;
+   for(;;)
+   {
+      Py_ssize_t home;
+      j = (j + 1) & (m->cap - 1);
+      if(!m->slots[j].value)
+         break;
+      home = Map_index(m, m->slots[j].key);
+      /* Move the entry if its home slot is not within (i, j] */
+      if((i <= j) ? (home <= i || home > j) : (home <= i && home > j))
+      {
+         m->slots[i] = m->slots[j];
+         m->slots[j].value = NULL;
+         i = j;
+      }
+   }
+   Py_DECREF(value);
+}
+
+
+static void
+Map_clear(Map* m)
+{
+   Py_ssize_t i;
+   Slot* slots = m->slots;
+   Py_ssize_t cap = m->cap;
+   m->slots = NULL;
+   m->cap = m->used = 0;
+   for(i = 0 ; i < cap ; i++)
+      Py_XDECREF(slots[i].value);
+   PyMem_Free(slots);
+}
+
+
+static int
+CallbackTable_traverse(CallbackTable* o, visitproc visit, void* arg)
+{
+   Py_ssize_t i;
+   for(i = 0 ; i < o->exact.cap ; i++)
+      Py_VISIT(o->exact.slots[i].value);
+   for(i = 0 ; i < o->all.cap ; i++)
+      Py_VISIT(o->all.slots[i].value);
+   return 0;
+}
+
+
+static int
+CallbackTable_tpclear(CallbackTable* o)
+{
+   Map_clear(&o->exact);
+   Map_clear(&o->all);
+   return 0;
+}
+
+
+static void
+CallbackTable_dealloc(CallbackTable* o)
+{
+   PyObject_GC_UnTrack(o);
+   CallbackTable_tpclear(o);
+   Py_TYPE(o)->tp_free((PyObject*)o);
+}
+
+
+/* Parse (tid, subtid) where subtid None is the catch-all entry */
+static int
+CallbackTable_key(PyObject* args, uint32_t* tid, uint32_t* subtid, int* all)
+{
+   PyObject* t;
+   PyObject* s;
+   if(!PyArg_UnpackTuple(args, "key", 2, 2, &t, &s) || toU32(t, tid))
+      return -1;
+   *all = s == Py_None;
+   return *all ? 0 : toU32(s, subtid);
+}
+
+
+static PyObject*
+CallbackTable_set(CallbackTable* o, PyObject* args)
+{
+   PyObject* key;
+   PyObject* value;
+   uint32_t tid, subtid = 0;
+   int all;
+   if(!PyArg_ParseTuple(args, "OO:set", &key, &value) ||
+      !PyTuple_Check(key) || CallbackTable_key(key, &tid, &subtid, &all))
+   {
+      if(!PyErr_Occurred())
+         PyErr_SetString(PyExc_TypeError, "key must be (tid, subtid)");
+      return NULL;
+   }
+   Py_INCREF(value);
+   if(all ? Map_set(&o->all, tid, value) :
+      Map_set(&o->exact, ((uint64_t)tid << 32) | subtid, value))
+   {
+      Py_DECREF(value);
+      return NULL;
+   }
+   Py_RETURN_NONE;
+}
+
+
+/* Borrowed reference or NULL */
+static PyObject*
+CallbackTable_find(CallbackTable* o, uint32_t tid, uint32_t subtid)
+{
+   PyObject* value = Map_get(&o->exact, ((uint64_t)tid << 32) | subtid);
+   return value ? value : Map_get(&o->all, tid);
+}
+
+
+static PyObject*
+CallbackTable_lookup(CallbackTable* o, PyObject* args)
+{
+   PyObject* t;
+   PyObject* s;
+   PyObject* value;
+   uint32_t tid, subtid;
+   if(!PyArg_UnpackTuple(args, "lookup", 2, 2, &t, &s) ||
+      toU32(t, &tid) || toU32(s, &subtid))
+   {
+      return NULL;
+   }
+   value = CallbackTable_find(o, tid, subtid);
+   if(!value)
+      Py_RETURN_NONE;
+   Py_INCREF(value);
+   return value;
+}
+
+
+static PyObject*
+CallbackTable_discard(CallbackTable* o, PyObject* arg)
+{
+   Py_ssize_t i;
+   uint32_t tid;
+   if(toU32(arg, &tid))
+      return NULL;
+   for(i = 0 ; i < o->all.cap ; i++)
+   {
+      if(o->all.slots[i].value && o->all.slots[i].key == tid)
+      {
+         Map_removeAt(&o->all, i);
+         break;
+      }
+   }
+   /* Backward shift may move an unvisited entry to 'i': rescan it */
+   for(i = 0 ; i < o->exact.cap ; )
+   {
+      if(o->exact.slots[i].value && (o->exact.slots[i].key >> 32) == tid)
+         Map_removeAt(&o->exact, i);
+      else
+         i++;
+   }
+   Py_RETURN_NONE;
+}
+
+
+static PyObject*
+CallbackTable_clear(CallbackTable* o, PyObject* Py_UNUSED(ignored))
+{
+   CallbackTable_tpclear(o);
+   Py_RETURN_NONE;
+}
+
+
+/* dispatch(body) -> (entry or None, payload, ptid, tid, subtid) */
+static PyObject*
+CallbackTable_dispatch(CallbackTable* o, PyObject* arg)
+{
+   Py_buffer view;
+   const unsigned char* p;
+   uint32_t tid, ptid, subtid;
+   PyObject* value;
+   PyObject* payload;
+   if(PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE))
+      return NULL;
+   if(view.len < 12)
+   {
+      PyBuffer_Release(&view);
+      PyErr_SetString(PyExc_ValueError, "short publish");
+      return NULL;
+   }
+   p = (const unsigned char*)view.buf;
+   tid = getU32(p);
+   ptid = getU32(p + 4);
+   subtid = getU32(p + 8);
+   /* A memoryview body (FrameReader.next_view) gives a memoryview payload */
+   payload = PyMemoryView_Check(arg) ?
+      PySequence_GetSlice(arg, 12, view.len) :
+      PyBytes_FromStringAndSize((const char*)p + 12, view.len - 12);
+   PyBuffer_Release(&view);
+   if(!payload)
+      return NULL;
+   value = CallbackTable_find(o, tid, subtid);
+   return Py_BuildValue("(ONkkk)", value ? value : Py_None, payload,
+                        (unsigned long)ptid, (unsigned long)tid,
+                        (unsigned long)subtid);
+}
+
+
+static Py_ssize_t
+CallbackTable_length(CallbackTable* o)
+{
+   return o->exact.used + o->all.used;
+}
+
+
+static PyMethodDef CallbackTable_methods[] = {
+   {"set", (PyCFunction)CallbackTable_set, METH_VARARGS,
+    "set(key, entry)\n--\n\n"
+    "Set the entry for key (tid, subtid); subtid None is the catch-all."},
+   {"lookup", (PyCFunction)CallbackTable_lookup, METH_VARARGS,
+    "lookup(tid, subtid)\n--\n\n"
+    "Return the (tid, subtid) entry, else the tid catch-all, else None."},
+   {"discard", (PyCFunction)CallbackTable_discard, METH_O,
+    "discard(tid)\n--\n\nRemove all entries for tid."},
+   {"clear", (PyCFunction)CallbackTable_clear, METH_NOARGS,
+    "clear()\n--\n\nRemove all entries."},
+   {"dispatch", (PyCFunction)CallbackTable_dispatch, METH_O,
+    "dispatch(body)\n--\n\n"
+    "Decode a publish body and look up its entry. Returns\n"
+    "(entry or None, payload, ptid, tid, subtid). The payload is a\n"
+    "memoryview if body is a memoryview, otherwise bytes."},
+   {NULL}
+};
+
+static PySequenceMethods CallbackTable_sequence = {
+   .sq_length = (lenfunc)CallbackTable_length,
+};
+
+static PyTypeObject CallbackTableType = {
+   PyVarObject_HEAD_INIT(NULL, 0)
+   .tp_name = "_smqaccel.CallbackTable",
+   .tp_doc = "Map (tid, subtid) to subscription entries.",
+   .tp_basicsize = sizeof(CallbackTable),
+   .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+   .tp_new = PyType_GenericNew,
+   .tp_dealloc = (destructor)CallbackTable_dealloc,
+   .tp_traverse = (traverseproc)CallbackTable_traverse,
+   .tp_clear = (inquiry)CallbackTable_tpclear,
+   .tp_methods = CallbackTable_methods,
+   .tp_as_sequence = &CallbackTable_sequence,
+};
+
+
+/****************************************************************************
+                              Packet functions
+ ****************************************************************************/
+
+/* Allocate a packet of 'hdrLen' header bytes plus 'body' */
+static PyObject*
+newPacket(int msgType, Py_ssize_t hdrLen, const Py_buffer* body,
+          unsigned char** hdr)
+{
+   Py_ssize_t len = hdrLen + body->len;
+   PyObject* packet;
+   if(len > MAX_PACKET)
+   {
+      PyErr_SetString(PyExc_ValueError, "SMQ packet too large");
+      return NULL;
+   }
+   packet = PyBytes_FromStringAndSize(NULL, len);
+   if(!packet)
+      return NULL;
+   *hdr = (unsigned char*)PyBytes_AS_STRING(packet);
+   (*hdr)[0] = (unsigned char)(len >> 8);
+   (*hdr)[1] = (unsigned char)len;
+   (*hdr)[2] = (unsigned char)msgType;
+   memcpy(*hdr + hdrLen, body->buf, body->len);
+   return packet;
+}
+
+
+static int
+checkArgs(const char* name, Py_ssize_t nargs, Py_ssize_t expected)
+{
+   if(nargs == expected)
+      return 0;
+   PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd arguments (%zd given)",
+                name, expected, nargs);
+   return -1;
+}
+
+
+/* METH_FASTCALL: these run once per sent message */
+static PyObject*
+encode_packet(PyObject* Py_UNUSED(module), PyObject* const* args,
+              Py_ssize_t nargs)
+{
+   long msgType;
+   Py_buffer body;
+   unsigned char* hdr;
+   PyObject* packet;
+   if(checkArgs("encode_packet", nargs, 2))
+      return NULL;
+   msgType = PyLong_AsLong(args[0]);
+   if(msgType == -1 && PyErr_Occurred())
+      return NULL;
+   if(PyObject_GetBuffer(args[1], &body, PyBUF_SIMPLE))
+      return NULL;
+   packet = newPacket((int)msgType, 3, &body, &hdr);
+   PyBuffer_Release(&body);
+   return packet;
+}
+
+
+static PyObject*
+encode_publish(PyObject* Py_UNUSED(module), PyObject* const* args,
+               Py_ssize_t nargs)
+{
+   uint32_t tid, ptid, subtid;
+   Py_buffer payload;
+   unsigned char* hdr;
+   PyObject* packet;
+   if(checkArgs("encode_publish", nargs, 4) ||
+      toU32(args[0], &tid) || toU32(args[1], &ptid) || toU32(args[2], &subtid))
+   {
+      return NULL;
+   }
+   if(PyObject_GetBuffer(args[3], &payload, PyBUF_SIMPLE))
+      return NULL;
+   packet = newPacket(8, 15, &payload, &hdr);
+   PyBuffer_Release(&payload);
+   if(packet)
+   {
+      putU32(hdr + 3, tid);
+      putU32(hdr + 7, ptid);
+      putU32(hdr + 11, subtid);
+   }
+   return packet;
+}
+
+
+static PyObject*
+decode_publish(PyObject* Py_UNUSED(module), PyObject* arg)
+{
+   Py_buffer view;
+   const unsigned char* p;
+   PyObject* result;
+   if(PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE))
+      return NULL;
+   if(view.len < 12)
+   {
+      PyBuffer_Release(&view);
+      PyErr_SetString(PyExc_ValueError, "short publish");
+      return NULL;
+   }
+   p = (const unsigned char*)view.buf;
+   result = Py_BuildValue("(kkky#)", (unsigned long)getU32(p),
+                          (unsigned long)getU32(p + 4),
+                          (unsigned long)getU32(p + 8),
+                          (const char*)p + 12, view.len - 12);
+   PyBuffer_Release(&view);
+   return result;
+}
+
+
+static PyMethodDef module_methods[] = {
+   {"encode_packet", (PyCFunction)(void(*)(void))encode_packet, METH_FASTCALL,
+    "encode_packet(msg_type, body)\n--\n\nReturn a complete SMQ packet."},
+   {"encode_publish", (PyCFunction)(void(*)(void))encode_publish,
+    METH_FASTCALL,
+    "encode_publish(tid, ptid, subtid, payload)\n--\n\n"
+    "Return a complete SMQ publish packet."},
+   {"decode_publish", decode_publish, METH_O,
+    "decode_publish(body)\n--\n\n"
+    "Return (tid, ptid, subtid, payload) for a publish body."},
+   {NULL}
+};
+
+static struct PyModuleDef module = {
+   PyModuleDef_HEAD_INIT,
+   .m_name = "_smqaccel",
+   .m_doc = "Optional accelerator for smqclient.py.",
+   .m_size = -1,
+   .m_methods = module_methods,
+};
+
+
+PyMODINIT_FUNC
+PyInit__smqaccel(void)
+{
+   PyObject* m;
+   if(PyType_Ready(&FrameReaderType) || PyType_Ready(&CallbackTableType))
+      return NULL;
+   m = PyModule_Create(&module);
+   if(!m)
+      return NULL;
+   Py_INCREF(&FrameReaderType);
+   Py_INCREF(&CallbackTableType);
+   if(PyModule_AddObject(m, "FrameReader", (PyObject*)&FrameReaderType) ||
+      PyModule_AddObject(m, "CallbackTable", (PyObject*)&CallbackTableType))
+   {
+      Py_DECREF(m);
+      return NULL;
+   }
+   return m;
+}
@@ -0,0 +1,103 @@
+"""Run a fleet of SMQ sessions on one asyncio event loop.
+
+Each simulated device is an AsyncSMQClient that subscribes to a shared command
+topic and answers every command with a direct reply to the publisher's PTID. A
+controller session broadcasts commands and waits for all replies. All sessions
+share the main thread; the client creates no threads.
+
+Run with the public SimpleMQ broker (keep the fleet small):
+
+    python examples/async_fleet.py https://simplemq.com/smq.lsp 10
+
+Run with a local broker:
+
+    python examples/async_fleet.py http://localhost/smq.lsp 2000
+"""
+
+from __future__ import annotations
+
+import asyncio
+import sys
+import threading
+import time
+import uuid
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+from smqclient_async import AsyncSMQClient
+
+
+url = sys.argv[1] if len(sys.argv) > 1 else "https://simplemq.com/smq.lsp"
+sessions = int(sys.argv[2]) if len(sys.argv) > 2 else 100
+topic = "python.example.fleet." + uuid.uuid4().hex[:12]
+ROUNDS = 5
+
+
+def device(ready: asyncio.Future, subscribed: list) -> AsyncSMQClient:
+    def on_command(data, ptid, tid, subtid):
+        smq.publish(b"ack:" + data, ptid, "fleet.ack")
+
+    def on_suback(accepted, *_):
+        subscribed[0] += 1
+        if subscribed[0] == sessions and not ready.done():
+            ready.set_result(None)
+
+    def setup(etid, rnd, ipaddr):
+        smq.subscribe(topic, "fleet.cmd", {"onmsg": on_command, "onack": on_suback})
+
+    smq = AsyncSMQClient.create(
+        url,
+        {
+            "uid": "py-fleet-" + uuid.uuid4().hex[:12],
+            "info": "asyncio fleet example",
+            "onconnect": setup,
+            "onreconnect": setup,
+            "reconnect_delay": 1,
+            "max_reconnect_delay": 30,
+            "timeout": 30,
+        },
+    )
+    return smq
+
+
+async def main() -> None:
+    loop = asyncio.get_running_loop()
+    ready = loop.create_future()
+    subscribed = [0]
+    start = time.perf_counter()
+    fleet = [device(ready, subscribed) for _ in range(sessions)]
+    await asyncio.wait_for(ready, 60)
+    print(f"{sessions} sessions subscribed in {time.perf_counter() - start:.2f} s, threads: {threading.active_count()}")
+
+    acks = 0
+    round_done: asyncio.Future = loop.create_future()
+
+    def on_ack(data, ptid, tid, subtid):
+        nonlocal acks
+        acks += 1
+        if acks == sessions and not round_done.done():
+            round_done.set_result(None)
+
+    controller = AsyncSMQClient.create(url, {"uid": "py-fleet-ctl-" + uuid.uuid4().hex[:12], "reconnect": False})
+    if not await controller.wait_connected(10):
+        raise SystemExit("controller connect timed out")
+    subscribed_ack: asyncio.Future = loop.create_future()
+    controller.subscribe("self", "fleet.ack", {"onmsg": on_ack, "onack": lambda *_: subscribed_ack.set_result(None)})
+    await asyncio.wait_for(subscribed_ack, 10)
+
+    for n in range(ROUNDS):
+        acks = 0
+        round_done = loop.create_future()
+        start = time.perf_counter()
+        controller.publish(str(n), topic, "fleet.cmd")
+        await asyncio.wait_for(round_done, 30)
+        print(f"round {n}: {sessions} replies in {(time.perf_counter() - start) * 1000:.1f} ms")
+
+    controller.disconnect()
+    for smq in fleet:
+        smq.disconnect()
+    await asyncio.gather(controller.wait_closed(), *(smq.wait_closed() for smq in fleet))
+
+
+asyncio.run(main())
@@ -0,0 +1,95 @@
+"""Measure publish throughput with and without write coalescing.
+
+A receiver session subscribes to a test topic and a publisher session sends
+small messages to it in three modes:
+
+- publish:      one publish() call, and one send, per message
+- coalesce:     publish() with the ``coalesce`` option, so packets published
+                within the window go out in one sendmsg()
+- publish_many: publish_many() with batches of 100 messages
+
+For each mode the benchmark prints how fast the publisher handed messages to the
+socket and how fast the receiver got all of them.
+
+Run with a local broker:
+
+    python examples/publish_bench.py http://localhost/smq.lsp 100000
+"""
+
+from __future__ import annotations
+
+import sys
+import threading
+import time
+import uuid
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+from smqclient import SMQClient
+
+
+url = sys.argv[1] if len(sys.argv) > 1 else "http://localhost/smq.lsp"
+count = int(sys.argv[2]) if len(sys.argv) > 2 else 100000
+topic = "python.example.bench." + uuid.uuid4().hex[:12]
+PAYLOAD = b"x" * 32
+BATCH = 100
+
+
+def connect(options: dict) -> SMQClient:
+    smq = SMQClient.create(url, {"uid": "py-bench-" + uuid.uuid4().hex[:12], "reconnect": False, **options})
+    if not smq.wait_connected(10):
+        raise SystemExit("connect timed out")
+    return smq
+
+
+def run(mode: str, receiver_state: dict) -> None:
+    publisher = connect({"coalesce": 0.002} if mode == "coalesce" else {})
+    created = threading.Event()
+    publisher.create(topic, lambda ok, *_: created.set())
+    if not created.wait(10):
+        raise SystemExit("create timed out")
+
+    receiver_state["received"] = 0
+    receiver_state["done"].clear()
+    start = time.perf_counter()
+    if mode == "publish_many":
+        batch = [(PAYLOAD, topic, None)] * BATCH
+        for _ in range(count // BATCH):
+            publisher.publish_many(batch)
+    else:
+        for _ in range(count):
+            publisher.publish(PAYLOAD, topic)
+        publisher.flush()
+    sent = time.perf_counter() - start
+    if not receiver_state["done"].wait(120):
+        print(f"{mode:13} received only {receiver_state['received']} of {count}")
+    else:
+        total = time.perf_counter() - start
+        print(f"{mode:13} send {count / sent:10.0f} msg/s   delivered {count / total:10.0f} msg/s")
+    publisher.disconnect()
+
+
+def main() -> None:
+    global count
+    count -= count % BATCH
+    state = {"received": 0, "done": threading.Event()}
+
+    def on_msg(data, ptid, tid, subtid):
+        state["received"] += 1
+        if state["received"] == count:
+            state["done"].set()
+
+    receiver = connect({})
+    subscribed = threading.Event()
+    receiver.subscribe(topic, {"onmsg": on_msg, "onack": lambda *_: subscribed.set()})
+    if not subscribed.wait(10):
+        raise SystemExit("subscribe timed out")
+
+    print(f"{count} messages of {len(PAYLOAD)} bytes")
+    for mode in ("publish", "coalesce", "publish_many"):
+        run(mode, state)
+    receiver.disconnect()
+
+
+main()
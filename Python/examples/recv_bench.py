@@ -0,0 +1,108 @@
+"""Measure receive throughput with and without the zerocopy option.
+
+The benchmark needs no broker. It connects an SMQClient to one end of a socket
+pair through a connector callable. A thread on the other end plays the broker:
+it answers the handshake and then streams publish packets for a subscribed
+topic. The subscription callback only counts the payload bytes.
+
+For each payload size the benchmark runs the client with copied ``bytes``
+payloads and with ``zerocopy`` memoryview payloads, and prints messages per
+second and MB per second.
+
+    python examples/recv_bench.py
+    python examples/recv_bench.py 64 1024 60000
+"""
+
+from __future__ import annotations
+
+import socket
+import struct
+import sys
+import threading
+import time
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+import smqclient
+from smqclient import SMQClient
+
+
+TID = 1000
+VOLUME = 200 * 1024 * 1024  # Bytes streamed per run
+sizes = [int(arg) for arg in sys.argv[1:]] or [64, 1024, 16384, 60000]
+
+
+def packet(msg_type: int, body: bytes) -> bytes:
+    return struct.pack(">HB", len(body) + 3, msg_type) + body
+
+
+def recv_packet(sock: socket.socket) -> int:
+    header = sock.recv(3, socket.MSG_WAITALL)
+    length, msg_type = struct.unpack(">HB", header)
+    if length > 3:
+        sock.recv(length - 3, socket.MSG_WAITALL)
+    return msg_type
+
+
+def broker(sock: socket.socket, size: int, count: int) -> None:
+    """Handshake, then stream 'count' publish packets with 'size' byte payloads."""
+    sock.sendall(packet(smqclient.MSG_INIT, b"\x01" + struct.pack(">I", 1) + b"127.0.0.1"))
+    recv_packet(sock)  # Connect
+    sock.sendall(packet(smqclient.MSG_CONNACK, b"\x00" + struct.pack(">I", 1)))
+    recv_packet(sock)  # Subscribe
+    sock.sendall(packet(smqclient.MSG_SUBACK, b"\x00" + struct.pack(">I", TID) + b"bench"))
+    publish = packet(smqclient.MSG_PUBLISH, struct.pack(">III", TID, 2, 0) + b"x" * size)
+    batch = publish * max(1, 262144 // len(publish))
+    per_batch = len(batch) // len(publish)
+    sent = 0
+    try:
+        while sent + per_batch <= count:
+            sock.sendall(batch)
+            sent += per_batch
+        sock.sendall(publish * (count - sent))
+        sock.recv(1)  # Wait for the client to disconnect
+    except OSError:
+        pass
+    finally:
+        sock.close()
+
+
+def run(size: int, zerocopy: bool) -> None:
+    count = max(10000, VOLUME // size)
+    client_sock, broker_sock = socket.socketpair()
+    thread = threading.Thread(target=broker, args=(broker_sock, size, count), daemon=True)
+    thread.start()
+
+    state = {"received": 0, "bytes": 0}
+    done = threading.Event()
+
+    def on_msg(data, ptid, tid, subtid):
+        state["bytes"] += len(data)
+        state["received"] += 1
+        if state["received"] == count:
+            done.set()
+
+    options = {"uid": "recv-bench", "reconnect": False}
+    if zerocopy:
+        options["zerocopy"] = True
+    smq = SMQClient(lambda _options: client_sock, options)
+    subscribed = threading.Event()
+    smq.onconnect = lambda *_: smq.subscribe("bench", {"onmsg": on_msg, "onack": lambda *_: subscribed.set()})
+    smq.start()
+    if not subscribed.wait(10):
+        raise SystemExit("subscribe timed out")
+    start = time.perf_counter()
+    if not done.wait(300):
+        raise SystemExit(f"received only {state['received']} of {count}")
+    elapsed = time.perf_counter() - start
+    smq.disconnect()
+    thread.join()
+    mode = "zerocopy" if zerocopy else "copy"
+    print(f"{size:6} bytes  {mode:8}  {count / elapsed:9.0f} msg/s  {state['bytes'] / elapsed / 1e6:7.1f} MB/s")
+
+
+print(f"accelerator: {'on' if smqclient.ACCELERATED else 'off'}")
+for size in sizes:
+    run(size, False)
+    run(size, True)
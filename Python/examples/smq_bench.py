@@ -0,0 +1,382 @@
+"""Benchmark and load test for smqclient.py.
+
+By default the runner starts the pure-Python broker stand-in (smqbroker.py) in
+a child process, so the numbers need no external services and the broker does
+not compete with the clients for the GIL. Pass ``--url`` to measure against a
+real broker instead.
+
+Scenarios, each run with ``--clients`` sessions and every ``--payload`` size:
+
+- throughput: N publishers send ``--messages`` messages in total to one topic
+              that one receiver subscribes to
+- latency:    every client sends ``--rounds`` requests to the next client's
+              ETID and waits for the reply to its own ETID; percentiles of the
+              round-trip time
+- fanout:     one publisher sends to a topic with N subscribers
+- storm:      N clients connect at once, then the broker drops them all and
+              they reconnect and resubscribe; the time until the last client
+              is back (stand-in broker only)
+
+Results are printed as a table. ``--json FILE`` appends them as one JSON line
+per run to FILE, or prints that line to stdout with ``--json -``, for tracking
+trends over time.
+
+    python examples/smq_bench.py
+    python examples/smq_bench.py --clients 50 --payload 16 1024 --json bench.jsonl
+    python examples/smq_bench.py --url http://localhost/smq.lsp --scenario latency
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import platform
+import subprocess
+import sys
+import threading
+import time
+import uuid
+from datetime import datetime, timezone
+from functools import partial
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+import smqclient
+from smqclient import SMQClient
+
+
+SCENARIOS = ("throughput", "latency", "fanout", "storm")
+TIMEOUT = 60.0
+
+parser = argparse.ArgumentParser(description="Benchmark smqclient.py against a broker.")
+parser.add_argument("--url", help="broker URL; default: start smqbroker.py in a child process")
+parser.add_argument("--clients", type=int, default=10, help="number of client sessions (default 10)")
+parser.add_argument("--payload", type=int, nargs="+", default=[64, 1024], help="payload sizes in bytes")
+parser.add_argument("--messages", type=int, default=20000, help="messages per throughput and fanout run")
+parser.add_argument("--rounds", type=int, default=500, help="round trips per client in the latency run")
+parser.add_argument("--scenario", nargs="+", choices=SCENARIOS, default=list(SCENARIOS))
+parser.add_argument("--json", metavar="FILE", help="append results as one JSON line; '-' for stdout")
+args = parser.parse_args()
+
+log: Callable[..., None] = partial(print, file=sys.stderr) if args.json == "-" else print
+
+
+class Broker:
+    """smqbroker.py in a child process, controlled through its standard input."""
+
+    def __init__(self) -> None:
+        script = Path(__file__).resolve().parents[1] / "smqbroker.py"
+        self.process = subprocess.Popen(
+            [sys.executable, str(script), "--port", "0", "--control"],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+        line = self.process.stdout.readline()
+        if "listening on" not in line:
+            raise SystemExit(f"broker did not start: {line.strip()}")
+        self.url = line.split()[-1]
+
+    def command(self, line: str) -> str:
+        self.process.stdin.write(line + "\n")
+        self.process.stdin.flush()
+        return self.process.stdout.readline().strip()
+
+    def close(self) -> None:
+        self.process.stdin.close()
+        self.process.wait(10)
+
+
+def percentile(sorted_samples: List[float], fraction: float) -> float:
+    return sorted_samples[min(len(sorted_samples) - 1, int(fraction * len(sorted_samples)))]
+
+
+def connect(url: str, count: int, **options: Any) -> List[SMQClient]:
+    clients = [
+        SMQClient.create(url, {"uid": "py-bench-" + uuid.uuid4().hex[:12], "reconnect": False, **options})
+        for _ in range(count)
+    ]
+    for smq in clients:
+        if not smq.wait_connected(TIMEOUT):
+            raise SystemExit("connect timed out")
+    return clients
+
+
+def disconnect(clients: List[SMQClient]) -> None:
+    for smq in clients:
+        smq.disconnect()
+
+
+def wait_ack(start: Callable[[Callable[..., None]], Any]) -> None:
+    """Call start(onack) and wait for the acknowledgement."""
+    acked = threading.Event()
+    start(lambda *_: acked.set())
+    if not acked.wait(TIMEOUT):
+        raise SystemExit("create/subscribe timed out")
+
+
+def run_threads(target: Callable[..., None], items: List[Any]) -> float:
+    """Run target(item) on one thread per item, started together. Returns the elapsed time."""
+    barrier = threading.Barrier(len(items) + 1)
+
+    def work(item: Any) -> None:
+        barrier.wait()
+        target(item)
+
+    threads = [threading.Thread(target=work, args=(item,), daemon=True) for item in items]
+    for thread in threads:
+        thread.start()
+    barrier.wait()
+    start = time.perf_counter()
+    for thread in threads:
+        thread.join()
+    return time.perf_counter() - start
+
+
+def throughput(url: str, clients: int, size: int) -> Dict[str, Any]:
+    topic = "python.bench." + uuid.uuid4().hex[:12]
+    payload = b"x" * size
+    per_client = max(1, args.messages // clients)
+    total = per_client * clients
+    state = {"received": 0}
+    done = threading.Event()
+
+    def on_msg(data, ptid, tid, subtid):
+        state["received"] += 1
+        if state["received"] == total:
+            done.set()
+
+    receiver = connect(url, 1)[0]
+    wait_ack(lambda onack: receiver.subscribe(topic, {"onmsg": on_msg, "onack": onack}))
+    publishers = connect(url, clients)
+    for smq in publishers:
+        wait_ack(lambda onack: smq.create(topic, onack))
+
+    def publish(smq: SMQClient) -> None:
+        for _ in range(per_client):
+            smq.publish(payload, topic)
+        smq.flush()
+
+    start = time.perf_counter()
+    sent = run_threads(publish, publishers)
+    delivered = done.wait(TIMEOUT)
+    elapsed = time.perf_counter() - start
+    disconnect(publishers + [receiver])
+    if not delivered:
+        raise SystemExit(f"throughput: received only {state['received']} of {total}")
+    return {
+        "messages": total,
+        "send_msgs_per_s": round(total / sent),
+        "delivered_msgs_per_s": round(total / elapsed),
+        "delivered_mb_per_s": round(total * size / elapsed / 1e6, 2),
+    }
+
+
+def latency(url: str, clients: int, size: int) -> Dict[str, Any]:
+    """Each client pings the next client's ETID; every client also echoes its neighbour's pings."""
+    request = b"q" + b"x" * max(0, size - 1)
+    replies = {}
+
+    def make_handler(index: int) -> Callable[..., None]:
+        def on_msg(data, ptid, tid, subtid):
+            smq = sessions[index]
+            if data[:1] == b"q":
+                smq.publish(b"r" + data[1:], ptid)
+            else:
+                replies[index].set()
+
+        return on_msg
+
+    sessions: List[SMQClient] = []
+    for index in range(max(2, clients)):
+        replies[index] = threading.Event()
+        sessions.extend(connect(url, 1, onmsg=make_handler(index)))
+    samples: List[float] = []
+    samples_lock = threading.Lock()
+
+    def ping(index: int) -> None:
+        smq = sessions[index]
+        peer = sessions[(index + 1) % len(sessions)].gettid()
+        reply = replies[index]
+        times = []
+        for round_number in range(args.rounds + 10):
+            reply.clear()
+            start = time.perf_counter()
+            smq.publish(request, peer)
+            if not reply.wait(TIMEOUT):
+                raise SystemExit("latency: reply timed out")
+            if round_number >= 10:  # Skip warm-up rounds
+                times.append(time.perf_counter() - start)
+        with samples_lock:
+            samples.extend(times)
+
+    elapsed = run_threads(ping, list(range(len(sessions))))
+    disconnect(sessions)
+    samples.sort()
+    return {
+        "round_trips": len(samples),
+        "round_trips_per_s": round(len(samples) / elapsed),
+        "p50_us": round(percentile(samples, 0.50) * 1e6),
+        "p90_us": round(percentile(samples, 0.90) * 1e6),
+        "p99_us": round(percentile(samples, 0.99) * 1e6),
+        "max_us": round(samples[-1] * 1e6),
+    }
+
+
+def fanout(url: str, clients: int, size: int) -> Dict[str, Any]:
+    topic = "python.bench." + uuid.uuid4().hex[:12]
+    payload = b"x" * size
+    count = max(100, args.messages // clients)
+    remaining = [clients]
+    remaining_lock = threading.Lock()
+    done = threading.Event()
+
+    def make_handler() -> Callable[..., None]:
+        received = [0]
+
+        def on_msg(data, ptid, tid, subtid):
+            received[0] += 1
+            if received[0] == count:
+                with remaining_lock:
+                    remaining[0] -= 1
+                    if remaining[0] == 0:
+                        done.set()
+
+        return on_msg
+
+    subscribers = connect(url, clients)
+    for smq in subscribers:
+        handler = make_handler()
+        wait_ack(lambda onack: smq.subscribe(topic, {"onmsg": handler, "onack": onack}))
+    publisher = connect(url, 1)[0]
+    wait_ack(lambda onack: publisher.create(topic, onack))
+
+    start = time.perf_counter()
+    for _ in range(count):
+        publisher.publish(payload, topic)
+    publisher.flush()
+    sent = time.perf_counter() - start
+    delivered = done.wait(TIMEOUT)
+    elapsed = time.perf_counter() - start
+    disconnect(subscribers + [publisher])
+    if not delivered:
+        raise SystemExit(f"fanout: {remaining[0]} subscribers did not receive all {count} messages")
+    return {
+        "messages": count,
+        "deliveries": count * clients,
+        "send_msgs_per_s": round(count / sent),
+        "deliveries_per_s": round(count * clients / elapsed),
+    }
+
+
+def storm(broker: Broker, clients: int) -> Dict[str, Any]:
+    """Time N simultaneous connects, then N simultaneous reconnects after a broker drop."""
+    topic = "python.bench." + uuid.uuid4().hex[:12]
+    ready_at: Dict[int, float] = {}
+    ready_lock = threading.Lock()
+    all_ready = threading.Event()
+
+    def make_onreconnect(index: int) -> Callable[..., None]:
+        def onreconnect(etid, rnd, ipaddr):
+            def onack(*_):
+                with ready_lock:
+                    ready_at[index] = time.perf_counter()
+                    if len(ready_at) == clients:
+                        all_ready.set()
+
+            sessions[index].subscribe(topic, {"onmsg": lambda *_: None, "onack": onack})
+
+        return onreconnect
+
+    sessions = [
+        SMQClient(broker.url, {"uid": "py-bench-" + uuid.uuid4().hex[:12], "reconnect_delay": 0.01, "onreconnect": make_onreconnect(index)})
+        for index in range(clients)
+    ]
+    start = time.perf_counter()
+    for smq in sessions:
+        smq.start()
+    for smq in sessions:
+        if not smq.wait_connected(TIMEOUT):
+            raise SystemExit("storm: connect timed out")
+    connected = time.perf_counter() - start
+    for smq in sessions:
+        wait_ack(lambda onack, smq=smq: smq.subscribe(topic, {"onmsg": lambda *_: None, "onack": onack}))
+
+    start = time.perf_counter()
+    broker.command("drop broker restart")
+    recovered = all_ready.wait(TIMEOUT)
+    disconnect(sessions)
+    if not recovered:
+        raise SystemExit(f"storm: only {len(ready_at)} of {clients} clients reconnected")
+    times = sorted(ready - start for ready in ready_at.values())
+    return {
+        "connect_s": round(connected, 4),
+        "reconnect_s": round(times[-1], 4),
+        "reconnect_p50_ms": round(percentile(times, 0.50) * 1e3, 2),
+        "reconnect_p99_ms": round(percentile(times, 0.99) * 1e3, 2),
+    }
+
+
+def describe(result: Dict[str, Any]) -> str:
+    name = result["scenario"]
+    if name == "throughput":
+        return f"send {result['send_msgs_per_s']:9} msg/s  delivered {result['delivered_msgs_per_s']:9} msg/s  {result['delivered_mb_per_s']:8} MB/s"
+    if name == "latency":
+        return (
+            f"{result['round_trips_per_s']:9} rtt/s  p50 {result['p50_us']:6} us  p90 {result['p90_us']:6} us"
+            f"  p99 {result['p99_us']:6} us  max {result['max_us']:7} us"
+        )
+    if name == "fanout":
+        return f"send {result['send_msgs_per_s']:9} msg/s  delivered {result['deliveries_per_s']:9} msg/s"
+    return (
+        f"connect {result['connect_s']:7.3f} s  reconnect {result['reconnect_s']:7.3f} s"
+        f"  p50 {result['reconnect_p50_ms']:8.2f} ms  p99 {result['reconnect_p99_ms']:8.2f} ms"
+    )
+
+
+def main() -> None:
+    broker: Optional[Broker] = None if args.url else Broker()
+    url = args.url or broker.url
+    results: List[Dict[str, Any]] = []
+
+    def record(scenario: str, size: Optional[int], values: Dict[str, Any]) -> None:
+        result = {"scenario": scenario, "clients": args.clients, "payload": size, **values}
+        results.append(result)
+        label = f"{size} B" if size is not None else "-"
+        log(f"{scenario:10} {args.clients:5} clients  {label:>8}  {describe(result)}")
+
+    log(f"broker {url}  accelerator {'on' if smqclient.ACCELERATED else 'off'}")
+    try:
+        for size in args.payload:
+            for scenario, run in (("throughput", throughput), ("latency", latency), ("fanout", fanout)):
+                if scenario in args.scenario:
+                    record(scenario, size, run(url, args.clients, size))
+        if "storm" in args.scenario:
+            if broker is None:
+                log("storm      skipped: needs the smqbroker.py stand-in to drop all clients")
+            else:
+                record("storm", None, storm(broker, args.clients))
+    finally:
+        if broker is not None:
+            broker.close()
+
+    if args.json:
+        report = {
+            "time": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "accelerated": smqclient.ACCELERATED,
+            "broker": args.url or "smqbroker.py",
+            "results": results,
+        }
+        line = json.dumps(report)
+        if args.json == "-":
+            print(line)
+        else:
+            with open(args.json, "a", encoding="utf-8") as file:
+                file.write(line + "\n")
+
+
+main()
@@ -0,0 +1,15 @@
+"""Build the optional _smqaccel accelerator for smqclient.py.
+
+    python setup.py build_ext --inplace
+
+smqclient.py works without it; a failed build is reported but not fatal.
+"""
+
+from setuptools import Extension, setup
+
+setup(
+    name="smqclient",
+    version="1.0",
+    py_modules=["smqclient", "smqclient_async"],
+    ext_modules=[Extension("_smqaccel", ["_smqaccel.c"], optional=True)],
+)
@@ -0,0 +1,455 @@
+"""Pure-Python stand-in for an SMQ broker, for tests and benchmarks.
+
+``SMQBroker`` implements the raw socket transport from
+``specification/SMQ-specification.md`` on an asyncio event loop: the HTTP
+bootstrap, Init/Connect/Connack, topic and sub-topic resolution, publish
+routing to topic subscribers and to ETIDs, Unsubscribe, Observe/Unobserve and
+Change, PubFrag reassembly, Ping/Pong, and Disconnect.
+
+It is not a replacement for the BAS broker. Every connection is accepted and
+every topic is permitted; there are no authentication or authorization hooks,
+no TLS, no WebSocket transport, no server-side client on ETID 1, and no
+clustering. A publish with the wrong publisher ETID or a malformed packet
+closes the connection, as the specification requires.
+
+Run it from the command line and point any raw-socket client at it:
+
+    python smqbroker.py --port 9000
+    python examples/smq_smoke.py http://127.0.0.1:9000/smq.lsp
+
+With ``--control`` the broker also reads commands from standard input, one per
+line: ``drop [reason]`` sends Disconnect with the reason to every client and
+closes them, and ``stats`` prints a line of counters.
+
+Or run it inside an existing event loop:
+
+    broker = SMQBroker()
+    await broker.start("127.0.0.1", 0)
+    client = SMQClient.create(broker.url)
+"""
+
+from __future__ import annotations
+
+import argparse
+import asyncio
+import random
+import struct
+import sys
+import threading
+from typing import Dict, List, Optional, Set
+
+from smqclient import (
+    MSG_CHANGE,
+    MSG_CONNACK,
+    MSG_CONNECT,
+    MSG_CREATE,
+    MSG_CREATEACK,
+    MSG_CREATESUB,
+    MSG_CREATESUBACK,
+    MSG_DISCONNECT,
+    MSG_INIT,
+    MSG_OBSERVE,
+    MSG_PING,
+    MSG_PONG,
+    MSG_PUBLISH,
+    MSG_SUBACK,
+    MSG_SUBSCRIBE,
+    MSG_UNOBSERVE,
+    MSG_UNSUBSCRIBE,
+)
+
+
+MSG_PUBFRAG = 19
+MAX_PACKET = 0xFFFF
+MAX_BOOTSTRAP = 65536
+WRITE_HIGH_WATER = 256 * 1024
+
+_ACKS = {MSG_SUBSCRIBE: MSG_SUBACK, MSG_CREATE: MSG_CREATEACK, MSG_CREATESUB: MSG_CREATESUBACK}
+
+
+def _packet(msg_type: int, body: bytes = b"") -> bytes:
+    return struct.pack(">HB", len(body) + 3, msg_type) + body
+
+
+class _Peer(asyncio.Protocol):
+    """One client connection: bootstrap, handshake, then packet dispatch."""
+
+    def __init__(self, broker: "SMQBroker"):
+        self.broker = broker
+        self.transport: Optional[asyncio.Transport] = None
+        self.buf = bytearray()
+        self.bootstrapped = False
+        self.etid: Optional[int] = None
+        self.uid = b""
+        self.info = b""
+        self.topics: Set[int] = set()
+        self.observing: Set[int] = set()
+        self.fragments: List[bytes] = []
+        self.write_paused = False
+        self.read_paused = False
+        self.blocked: Set["_Peer"] = set()  # Senders paused until this peer drains
+        self.closed = False
+
+    def connection_made(self, transport: asyncio.BaseTransport) -> None:
+        self.transport = transport  # type: ignore[assignment]
+        self.transport.set_write_buffer_limits(high=WRITE_HIGH_WATER)
+
+    def data_received(self, data: bytes) -> None:
+        buf = self.buf
+        buf += data
+        if not self.bootstrapped and not self.bootstrap():
+            return
+        pos = 0
+        end = len(buf)
+        while end - pos >= 3 and not self.closed:
+            length = (buf[pos] << 8) | buf[pos + 1]
+            if length < 3:
+                self.close("invalid packet length")
+                return
+            if end - pos < length:
+                break
+            packet = bytes(buf[pos : pos + length])
+            pos += length
+            self.handle(packet[2], packet)
+        del buf[:pos]
+
+    def bootstrap(self) -> bool:
+        """Answer the HTTP bootstrap request and send Init. False until the request is complete."""
+        head_end = self.buf.find(b"\r\n\r\n")
+        if head_end < 0:
+            if len(self.buf) > MAX_BOOTSTRAP:
+                self.close()
+            return False
+        lines = bytes(self.buf[:head_end]).decode("iso-8859-1").split("\r\n")
+        del self.buf[: head_end + 4]
+        headers = {}
+        for line in lines[1:]:
+            name, _, value = line.partition(":")
+            headers[name.strip().lower()] = value.strip()
+        if not headers.get("simplemq"):  # "1" per the specification; the Java client sends "true"
+            self.transport.write(b"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n")
+            self.close()
+            return False
+        if headers.get("sendsmqhttpresponse", "").lower() == "true":
+            self.transport.write(b"HTTP/1.1 200 OK\r\nSmqBroker: 1\r\nContent-Length: 0\r\n\r\n")
+        self.bootstrapped = True
+        address = self.transport.get_extra_info("peername")
+        ipaddr = address[0] if isinstance(address, tuple) else "127.0.0.1"
+        self.transport.write(_packet(MSG_INIT, struct.pack(">BI", 1, random.getrandbits(32)) + ipaddr.encode("ascii")))
+        return True
+
+    def handle(self, msg_type: int, packet: bytes) -> None:
+        broker = self.broker
+        if msg_type == MSG_PUBLISH:
+            if len(packet) < 15:
+                self.close("short publish")
+            elif int.from_bytes(packet[7:11], "big") != self.etid:
+                self.close("publisher ETID mismatch")
+            else:
+                broker.route(self, int.from_bytes(packet[3:7], "big"), packet)
+        elif self.etid is None:
+            if msg_type == MSG_CONNECT:
+                self.connect(packet[3:])
+            else:
+                self.close("expected Connect")
+        elif msg_type in _ACKS:
+            name = packet[3:]
+            if not name:
+                self.send(_packet(_ACKS[msg_type], b"\x01\x00\x00\x00\x00"))
+                return
+            if msg_type == MSG_CREATESUB:
+                tid = broker.subtopic_id(name)
+            else:
+                tid = broker.topic_id(name)
+                if msg_type == MSG_SUBSCRIBE:
+                    broker.subscribe(self, tid)
+            self.send(_packet(_ACKS[msg_type], b"\x00" + tid.to_bytes(4, "big") + name))
+        elif msg_type == MSG_PUBFRAG:
+            self.pubfrag(packet)
+        elif msg_type == MSG_PING:
+            self.send(_packet(MSG_PONG))
+        elif msg_type == MSG_PONG:
+            pass
+        elif msg_type in (MSG_UNSUBSCRIBE, MSG_OBSERVE, MSG_UNOBSERVE):
+            if len(packet) < 7:
+                self.close("short packet")
+                return
+            tid = int.from_bytes(packet[3:7], "big")
+            if msg_type == MSG_UNSUBSCRIBE:
+                broker.unsubscribe(self, tid)
+            elif msg_type == MSG_OBSERVE:
+                broker.observe(self, tid)
+            else:
+                broker.unobserve(self, tid)
+        elif msg_type == MSG_DISCONNECT:
+            self.close()
+        else:
+            self.close(f"unexpected packet type {msg_type}")
+
+    def connect(self, body: bytes) -> None:
+        try:
+            version = body[0]
+            uid_end = 2 + body[1]
+            credentials_end = uid_end + 1 + body[uid_end]
+            if credentials_end > len(body):
+                raise IndexError
+        except IndexError:
+            self.close("malformed Connect")
+            return
+        if version != 1:
+            self.send(_packet(MSG_CONNACK, b"\x01\x00\x00\x00\x00"))
+            self.close()
+            return
+        self.uid = body[2:uid_end]
+        self.info = body[credentials_end:]
+        self.etid = self.broker.add_peer(self)
+        self.send(_packet(MSG_CONNACK, b"\x00" + self.etid.to_bytes(4, "big")))
+
+    def pubfrag(self, packet: bytes) -> None:
+        """Collect fragments until the one with a non-zero TID, then route the assembled Publish."""
+        if len(packet) < 15 or int.from_bytes(packet[7:11], "big") != self.etid:
+            self.close("invalid PubFrag")
+            return
+        self.fragments.append(packet[15:])
+        tid = int.from_bytes(packet[3:7], "big")
+        if tid == 0:
+            if sum(map(len, self.fragments)) > MAX_PACKET - 15:
+                self.close("PubFrag message too large")
+            return
+        payload = b"".join(self.fragments)
+        self.fragments.clear()
+        if len(payload) > MAX_PACKET - 15:
+            self.close("PubFrag message too large")
+            return
+        self.broker.route(self, tid, _packet(MSG_PUBLISH, packet[3:15] + payload))
+
+    def send(self, packet: bytes) -> None:
+        if not self.closed:
+            self.transport.write(packet)
+
+    def close(self, reason: Optional[str] = None) -> None:
+        """Close the connection, sending Disconnect with 'reason' when one is given."""
+        if self.closed:
+            return
+        if reason is not None and self.bootstrapped:
+            self.transport.write(_packet(MSG_DISCONNECT, reason.encode("utf-8")))
+        self.closed = True
+        self.transport.close()
+
+    def pause_writing(self) -> None:
+        self.write_paused = True
+
+    def resume_writing(self) -> None:
+        self.write_paused = False
+        self.release_blocked()
+
+    def release_blocked(self) -> None:
+        for sender in self.blocked:
+            if sender.read_paused and not sender.closed:
+                sender.read_paused = False
+                sender.transport.resume_reading()
+        self.blocked.clear()
+
+    def connection_lost(self, exc: Optional[Exception]) -> None:
+        self.closed = True
+        self.release_blocked()
+        self.broker.remove_peer(self)
+
+
+class SMQBroker:
+    """Topic table, subscriptions, and observations shared by all connections."""
+
+    def __init__(self) -> None:
+        self.peers: Dict[int, _Peer] = {}
+        self.topics: Dict[bytes, int] = {}
+        self.topic_names: Dict[int, bytes] = {}
+        self.subtopics: Dict[bytes, int] = {}
+        self.subscribers: Dict[int, Set[_Peer]] = {}
+        self.observers: Dict[int, Set[_Peer]] = {}
+        self.used_ids: Set[int] = {0, 1}  # 0 is "no sub-topic"; 1 is the BAS server-side client
+        self.routed = 0
+        self.dropped = 0
+        self.server: Optional[asyncio.AbstractServer] = None
+        self.host = "127.0.0.1"
+        self.port = 0
+
+    @property
+    def url(self) -> str:
+        return f"http://{self.host}:{self.port}/smq.lsp"
+
+    async def start(self, host: str = "127.0.0.1", port: int = 0, backlog: int = 4096) -> None:
+        loop = asyncio.get_running_loop()
+        self.server = await loop.create_server(lambda: _Peer(self), host, port, backlog=backlog)
+        self.host = host
+        self.port = self.server.sockets[0].getsockname()[1]
+
+    async def serve_forever(self) -> None:
+        assert self.server is not None, "start() must be called first"
+        await self.server.serve_forever()
+
+    async def close(self) -> None:
+        self.drop_all()
+        if self.server is not None:
+            self.server.close()
+            await self.server.wait_closed()
+
+    def drop_all(self, reason: Optional[str] = None) -> int:
+        """Disconnect every client, as a broker restart would. Returns the number dropped."""
+        peers = list(self.peers.values())
+        for peer in peers:
+            peer.close(reason)
+        return len(peers)
+
+    def stats(self) -> str:
+        return f"clients={len(self.peers)} topics={len(self.topics)} routed={self.routed} dropped={self.dropped}"
+
+    def _new_id(self) -> int:
+        while True:
+            value = random.getrandbits(32)
+            if value not in self.used_ids:
+                self.used_ids.add(value)
+                return value
+
+    def topic_id(self, name: bytes) -> int:
+        tid = self.topics.get(name)
+        if tid is None:
+            tid = self.topics[name] = self._new_id()
+            self.topic_names[tid] = name
+        return tid
+
+    def subtopic_id(self, name: bytes) -> int:
+        subtid = self.subtopics.get(name)
+        if subtid is None:
+            subtid = self.subtopics[name] = self._new_id()
+        return subtid
+
+    def add_peer(self, peer: _Peer) -> int:
+        etid = self._new_id()
+        self.peers[etid] = peer
+        return etid
+
+    def remove_peer(self, peer: _Peer) -> None:
+        etid = peer.etid
+        if etid is None or self.peers.get(etid) is not peer:
+            return
+        del self.peers[etid]
+        self.used_ids.discard(etid)
+        for tid in list(peer.topics):
+            self.unsubscribe(peer, tid)
+        for tid in peer.observing:
+            observers = self.observers.get(tid)
+            if observers is not None:
+                observers.discard(peer)
+                if not observers:
+                    del self.observers[tid]
+        for observer in self.observers.pop(etid, ()):
+            observer.observing.discard(etid)
+            observer.send(_packet(MSG_CHANGE, struct.pack(">II", etid, 0)))
+
+    def route(self, sender: _Peer, tid: int, packet: bytes) -> None:
+        """Forward a Publish packet unchanged to the subscribers of 'tid' or to the ETID owner."""
+        subscribers = self.subscribers.get(tid)
+        if subscribers:
+            targets = subscribers
+        else:
+            peer = self.peers.get(tid)
+            if peer is None:
+                self.dropped += 1
+                return
+            targets = (peer,)
+        for peer in targets:
+            if peer.closed:
+                continue
+            peer.transport.write(packet)
+            if peer.write_paused and peer is not sender:
+                peer.blocked.add(sender)
+                if not sender.read_paused:
+                    sender.read_paused = True
+                    sender.transport.pause_reading()
+        self.routed += 1
+
+    def subscribe(self, peer: _Peer, tid: int) -> None:
+        subscribers = self.subscribers.setdefault(tid, set())
+        if peer not in subscribers:
+            subscribers.add(peer)
+            peer.topics.add(tid)
+            self._changed(tid)
+
+    def unsubscribe(self, peer: _Peer, tid: int) -> None:
+        subscribers = self.subscribers.get(tid)
+        if subscribers is None or peer not in subscribers:
+            return
+        subscribers.discard(peer)
+        peer.topics.discard(tid)
+        if not subscribers:
+            del self.subscribers[tid]
+        self._changed(tid)
+
+    def observe(self, peer: _Peer, tid: int) -> None:
+        if tid not in self.peers and tid not in self.topic_names:
+            # Unknown or departed ETID: report the disconnect right away.
+            peer.send(_packet(MSG_CHANGE, struct.pack(">II", tid, 0)))
+            return
+        self.observers.setdefault(tid, set()).add(peer)
+        peer.observing.add(tid)
+
+    def unobserve(self, peer: _Peer, tid: int) -> None:
+        observers = self.observers.get(tid)
+        if observers is not None:
+            observers.discard(peer)
+            if not observers:
+                del self.observers[tid]
+        peer.observing.discard(tid)
+
+    def _changed(self, tid: int) -> None:
+        observers = self.observers.get(tid)
+        if observers:
+            change = _packet(MSG_CHANGE, struct.pack(">II", tid, len(self.subscribers.get(tid, ()))))
+            for observer in observers:
+                observer.send(change)
+
+
+def _read_control(loop: asyncio.AbstractEventLoop, broker: SMQBroker, stopped: asyncio.Event) -> None:
+    """Read control commands from stdin on a helper thread and run them on the loop."""
+
+    def run(line: str) -> None:
+        command, _, argument = line.strip().partition(" ")
+        if command == "drop":
+            print(f"dropped {broker.drop_all(argument or 'broker restart')}", flush=True)
+        elif command == "stats":
+            print(broker.stats(), flush=True)
+        elif command:
+            print(f"unknown command: {command}", flush=True)
+
+    for line in sys.stdin:
+        loop.call_soon_threadsafe(run, line)
+    loop.call_soon_threadsafe(stopped.set)
+
+
+async def _main(args: argparse.Namespace) -> None:
+    broker = SMQBroker()
+    await broker.start(args.host, args.port)
+    print(f"SMQ broker listening on {broker.url}", flush=True)
+    if not args.control:
+        await broker.serve_forever()
+        return
+    stopped = asyncio.Event()
+    threading.Thread(target=_read_control, args=(asyncio.get_running_loop(), broker, stopped), daemon=True).start()
+    await stopped.wait()  # Standard input closed
+    await broker.close()
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Pure-Python SMQ broker stand-in (raw socket transport).")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9000, help="listen port; 0 picks a free port")
+    parser.add_argument("--control", action="store_true", help="read drop/stats commands from stdin")
+    args = parser.parse_args()
+    try:
+        asyncio.run(_main(args))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -4,6 +4,11 @@ The client uses the raw SMQ transport by default: an HTTP(S) bootstrap request
 with ``SimpleMQ: 1`` and ``SendSmqHttpResponse: true`` followed by SMQ binary
 packets. Public methods are thread-safe. Lifecycle and message callbacks run on
 the client's background receive thread.
+
+Packet framing, publish encoding, and subscription lookup use the optional
+``_smqaccel`` C extension when it is built (``python setup.py build_ext
+--inplace``) and fall back to the pure-Python versions below otherwise. Set the
+environment variable ``SMQ_NO_ACCEL`` to force the pure-Python versions.
 """
 
 from __future__ import annotations
@@ -18,7 +23,7 @@ import time
 import uuid
 from collections import defaultdict
 from dataclasses import dataclass, field
-from typing import Any, Callable, Dict, List, Mapping, Optional, Tuple, Union
+from typing import Any, Callable, Dict, Iterable, List, Mapping, Optional, Tuple, Union
 from urllib.parse import urlparse
 
 
@@ -77,6 +82,9 @@ class SMQOptions:
     reconnect_delay: float = 5.0
     max_reconnect_delay: Optional[float] = None
     headers: Mapping[str, str] = field(default_factory=dict)
+    coalesce: float = 0.0
+    coalesce_bytes: int = 16384
+    zerocopy: bool = False
 
 
 @dataclass
@@ -86,6 +94,220 @@ class _MessageCallbacks:
     datatypes: Dict[Optional[int], Optional[str]] = field(default_factory=dict)
 
 
+class _PyFrameReader:
+    """Pure-Python ``_smqaccel.FrameReader``: split SMQ packets from a byte stream.
+
+    Received data is kept between ``_start`` and ``_end`` of a bytearray and is
+    either copied in by ``feed()`` or received in place through the
+    ``writable()`` view. The unconsumed tail is moved to the front when free
+    space runs low, so every packet is contiguous and ``next_view()`` returns
+    it without copying. A view is valid until the next ``feed()`` or
+    ``writable()`` call. The buffer is replaced, not resized, when it grows.
+    """
+
+    def __init__(self) -> None:
+        self._buf = bytearray()
+        self._view = memoryview(self._buf)
+        self._start = 0
+        self._end = 0
+
+    def _reserve(self, extra: int) -> None:
+        size = self._end - self._start
+        if len(self._buf) - self._end >= extra:
+            return
+        if size + extra <= len(self._buf):
+            self._view[:size] = self._view[self._start : self._end]  # memmove
+        else:
+            cap = max(len(self._buf), _MIN_RECV_BUFFER)
+            while cap < size + extra:
+                cap *= 2
+            buf = bytearray(cap)
+            buf[:size] = self._view[self._start : self._end]
+            self._buf = buf
+            self._view = memoryview(buf)
+        self._start = 0
+        self._end = size
+
+    def feed(self, data: BytesLike) -> None:
+        self._reserve(len(data))
+        end = self._end + len(data)
+        self._buf[self._end : end] = data
+        self._end = end
+
+    def writable(self) -> memoryview:
+        size = self._end - self._start
+        extra = _MIN_RECV_BUFFER // 2
+        if size >= 2:
+            extra = max(extra, ((self._buf[self._start] << 8) | self._buf[self._start + 1]) - size)
+        self._reserve(extra)
+        return self._view[self._end :]
+
+    def commit(self, size: int) -> None:
+        if size < 0 or size > len(self._buf) - self._end:
+            raise ValueError("commit size out of range")
+        self._end += size
+
+    def _take(self) -> Optional[Tuple[int, int]]:
+        buf = self._buf
+        start = self._start
+        if self._end - start < 3:
+            return None
+        length = (buf[start] << 8) | buf[start + 1]
+        if length < 3:
+            raise ValueError("invalid SMQ packet length")
+        if self._end - start < length:
+            return None
+        self._start = start + length
+        if self._start == self._end:
+            self._start = self._end = 0
+        return start, start + length
+
+    def next(self) -> Optional[Tuple[int, bytes]]:
+        span = self._take()
+        if span is None:
+            return None
+        start, end = span
+        return self._buf[start + 2], bytes(self._view[start + 3 : end])
+
+    def next_view(self) -> Optional[Tuple[int, memoryview]]:
+        span = self._take()
+        if span is None:
+            return None
+        start, end = span
+        return self._buf[start + 2], self._view[start + 3 : end]
+
+    def clear(self) -> None:
+        self._start = self._end = 0
+
+    def __iter__(self) -> "_PyFrameReader":
+        return self
+
+    def __next__(self) -> Tuple[int, bytes]:
+        packet = self.next()
+        if packet is None:
+            raise StopIteration
+        return packet
+
+    def __len__(self) -> int:
+        return self._end - self._start
+
+
+class _PyCallbackTable:
+    """Pure-Python ``_smqaccel.CallbackTable``: (tid, subtid) -> subscription entry."""
+
+    def __init__(self) -> None:
+        self._exact: Dict[Tuple[int, int], Any] = {}
+        self._all: Dict[int, Any] = {}
+
+    def set(self, key: Tuple[int, Optional[int]], entry: Any) -> None:
+        tid, subtid = key
+        if subtid is None:
+            self._all[tid] = entry
+        else:
+            self._exact[(tid, subtid)] = entry
+
+    def lookup(self, tid: int, subtid: int) -> Any:
+        entry = self._exact.get((tid, subtid))
+        return entry if entry is not None else self._all.get(tid)
+
+    def discard(self, tid: int) -> None:
+        self._all.pop(tid, None)
+        for key in [key for key in self._exact if key[0] == tid]:
+            del self._exact[key]
+
+    def clear(self) -> None:
+        self._exact.clear()
+        self._all.clear()
+
+    def dispatch(self, body: bytes) -> Tuple[Any, bytes, int, int, int]:
+        if len(body) < 12:
+            raise ValueError("short publish")
+        tid, ptid, subtid = _PUBLISH_HEADER.unpack_from(body)
+        return self.lookup(tid, subtid), body[12:], ptid, tid, subtid
+
+    def __len__(self) -> int:
+        return len(self._exact) + len(self._all)
+
+
+_MIN_RECV_BUFFER = 0x4000
+_PACKET_HEADER = struct.Struct(">HB")
+_PUBLISH_HEADER = struct.Struct(">III")
+_PUBLISH_PACKET_HEADER = struct.Struct(">HBIII")
+
+
+def _py_encode_packet(msg_type: int, body: BytesLike) -> bytes:
+    if len(body) + 3 > 0xFFFF:
+        raise ValueError("SMQ packet too large")
+    return _PACKET_HEADER.pack(len(body) + 3, msg_type) + body
+
+
+def _py_encode_publish(tid: int, ptid: int, subtid: int, payload: BytesLike) -> bytes:
+    if len(payload) + 15 > 0xFFFF:
+        raise ValueError("SMQ packet too large")
+    return _PUBLISH_PACKET_HEADER.pack(len(payload) + 15, MSG_PUBLISH, tid, ptid, subtid) + payload
+
+
+def _encode_ndarray(array: Any) -> bytes:
+    """Encode a NumPy array for ``datatype="ndarray"``.
+
+    Layout: dtype string length (u8), ndim (u8), ``dtype.str`` in ASCII (for
+    example ``<f4``, which includes the byte order), ndim big-endian u32
+    dimensions, then the array data in C order.
+    """
+    import numpy
+
+    array = numpy.asarray(array)
+    if not array.flags.c_contiguous:
+        array = numpy.ascontiguousarray(array)
+    dtype = array.dtype
+    if dtype.hasobject or dtype.fields is not None or dtype.subdtype is not None:
+        raise TypeError(f"unsupported ndarray dtype {dtype}")
+    code = dtype.str.encode("ascii")
+    header = struct.pack(f">BB{len(code)}s{array.ndim}I", len(code), array.ndim, code, *array.shape)
+    return header + memoryview(array.reshape(-1).view(numpy.uint8))
+
+
+def _decode_ndarray(payload: BytesLike) -> Any:
+    """Return a read-only array over ``payload`` without copying the data."""
+    import numpy
+
+    if len(payload) < 2:
+        raise ValueError("short ndarray header")
+    code_len, ndim = payload[0], payload[1]
+    offset = 2 + code_len + 4 * ndim
+    if len(payload) < offset:
+        raise ValueError("short ndarray header")
+    dtype = numpy.dtype(str(payload[2 : 2 + code_len], "ascii"))
+    shape = struct.unpack_from(f">{ndim}I", payload, 2 + code_len)
+    count = 1
+    for dim in shape:
+        count *= dim
+    if len(payload) - offset != count * dtype.itemsize:
+        raise ValueError("ndarray size does not match its shape")
+    array = numpy.frombuffer(payload, dtype, count, offset).reshape(shape)
+    array.flags.writeable = False
+    return array
+
+
+_FrameReader: Any = _PyFrameReader
+_CallbackTable: Any = _PyCallbackTable
+_encode_packet = _py_encode_packet
+_encode_publish = _py_encode_publish
+ACCELERATED = False
+_IOV_MAX = 1024  # sendmsg() buffer limit on Linux and the BSDs
+if not os.environ.get("SMQ_NO_ACCEL"):
+    try:
+        import _smqaccel
+    except ImportError:
+        pass
+    else:
+        _FrameReader = _smqaccel.FrameReader
+        _CallbackTable = _smqaccel.CallbackTable
+        _encode_packet = _smqaccel.encode_packet
+        _encode_publish = _smqaccel.encode_publish
+        ACCELERATED = True
+
+
 class _CreateDescriptor:
     def __get__(self, obj: Optional["SMQClient"], owner: type["SMQClient"]) -> Callable[..., Any]:
         if obj is None:
@@ -122,11 +344,16 @@ class SMQClient:
 
         self._lock = threading.RLock()
         self._send_lock = threading.Lock()
+        self._send_ready = threading.Condition(self._send_lock)
+        self._out: List[BytesLike] = []  # Packets queued by the coalescing window
+        self._out_size = 0
+        self._out_since = 0.0
+        self._flush_thread: Optional[threading.Thread] = None
         self._stop = threading.Event()
         self._connected = threading.Event()
         self._thread: Optional[threading.Thread] = None
         self._sock: Optional[socket.socket] = None
-        self._recv_buffer = bytearray()
+        self._frames = _FrameReader()
         self._ever_connected = False
         self._manual_disconnect = False
 
@@ -139,6 +366,7 @@ class SMQClient:
         self.pending_subscribe_acks: Dict[str, List[Callback]] = defaultdict(list)
         self.pending_subtopic_acks: Dict[str, List[Callback]] = defaultdict(list)
         self.message_callbacks: Dict[int, _MessageCallbacks] = {}
+        self._callback_table = _CallbackTable()  # (tid, subtid) -> (onmsg, datatype, copy)
         self.observe_callbacks: Dict[int, Tuple[Topic, Callback]] = {}
         self._subscribed_tids: set[int] = set()
 
@@ -152,6 +380,9 @@ class SMQClient:
             self._manual_disconnect = False
             self._thread = threading.Thread(target=self._connect_loop, name="SMQClient", daemon=True)
             self._thread.start()
+            if self.options.coalesce > 0 and not (self._flush_thread and self._flush_thread.is_alive()):
+                self._flush_thread = threading.Thread(target=self._flush_loop, name="SMQClient-flush", daemon=True)
+                self._flush_thread.start()
 
     def wait_connected(self, timeout: Optional[float] = None) -> bool:
         return self._connected.wait(timeout)
@@ -213,11 +444,50 @@ class SMQClient:
                 raise TypeError("topic must be a string or integer TID/ETID")
             return self.create(topic_or_tid_or_etid, after_topic)
 
+        if subtopic_or_subtid is None:
+            return self._publish_resolved(payload, tid, 0)
         return self._resolve_subtopic_then(subtopic_or_subtid, lambda subtid: self._publish_resolved(payload, tid, subtid))
 
+    def publish_many(self, messages: Iterable[Tuple[Payload, Topic, Optional[Topic]]]) -> bool:
+        """Publish (data, topic_or_tid_or_etid, subtopic_or_subtid) tuples.
+
+        Messages whose topic and sub-topic are IDs, ``"self"``, or names already
+        resolved are encoded and sent together with one ``sendmsg()``.
+        Unresolved names go through ``publish()`` after the batch. Returns False
+        if the client is not connected or a send failed.
+        """
+        packets: List[bytes] = []
+        deferred: List[Tuple[bytes, Topic, Optional[Topic]]] = []
+        with self._lock:
+            if not self._is_connected_locked() or self.etid is None:
+                return False
+            etid = self.etid
+            topics = self.topic_name_to_tid
+            subtopics = self.subtopic_name_to_subtid
+            for data, topic, subtopic in messages:
+                payload = self._payload_to_bytes(data)
+                tid = topic if isinstance(topic, int) else etid if topic == "self" else topics.get(topic)
+                subtid = 0 if subtopic is None else subtopic if isinstance(subtopic, int) else subtopics.get(subtopic)
+                if tid is None or subtid is None:
+                    deferred.append((payload, topic, subtopic))
+                else:
+                    packets.append(_encode_publish(tid, etid, subtid, payload))
+        ok = not packets or self._send_buffers(packets)
+        for payload, topic, subtopic in deferred:
+            ok = self.publish(payload, topic, subtopic) and ok
+        return ok
+
+    def flush(self) -> bool:
+        """Send packets held by the ``coalesce`` window now."""
+        return self._send_buffers([])
+
     def pubjson(self, value: Any, topic_or_tid_or_etid: Topic, subtopic_or_subtid: Optional[Topic] = None) -> bool:
         return self.publish(json.dumps(value, separators=(",", ":")), topic_or_tid_or_etid, subtopic_or_subtid)
 
+    def pubarray(self, array: Any, topic_or_tid_or_etid: Topic, subtopic_or_subtid: Optional[Topic] = None) -> bool:
+        """Publish a NumPy array's buffer with a dtype and shape header, for ``datatype="ndarray"``."""
+        return self.publish(_encode_ndarray(array), topic_or_tid_or_etid, subtopic_or_subtid)
+
     def subscribe(
         self,
         topic_or_self: Topic,
@@ -230,6 +500,9 @@ class SMQClient:
         datatype = settings_dict.get("datatype")
         if settings_dict.get("json") and datatype is None:
             datatype = "json"
+        if datatype == "ndarray":
+            import numpy  # noqa: F401  # Fail here, not for each message, if NumPy is missing
+        copy = bool(settings_dict.get("copy"))
 
         def register(tid: int, subtid: Optional[int]) -> None:
             if onmsg:
@@ -241,6 +514,7 @@ class SMQClient:
                     else:
                         callbacks.subtopics[subtid] = onmsg
                         callbacks.datatypes[subtid] = datatype
+                    self._callback_table.set((tid, subtid), (onmsg, datatype, copy))
 
         def after_topic(ok: bool, topic_name: Union[str, int], tid: int, subtid: Optional[int]) -> None:
             if ok:
@@ -281,6 +555,7 @@ class SMQClient:
             if tid is None:
                 return False
             self.message_callbacks.pop(tid, None)
+            self._callback_table.discard(tid)
             self._subscribed_tids.discard(tid)
         return self._send_packet(MSG_UNSUBSCRIBE, struct.pack(">I", tid))
 
@@ -346,7 +621,7 @@ class SMQClient:
                 self._reset_connection_state()
                 sock, initial = self._open_transport()
                 self._sock = sock
-                self._recv_buffer = bytearray(initial)
+                self._frames.feed(initial)
                 sock.settimeout(0.5)
                 rnd, ipaddr = self._handshake()
                 self._connected.set()
@@ -367,7 +642,7 @@ class SMQClient:
             decision = self._handle_close(reason, can_reconnect)
             if not decision:
                 break
-            sleep_for = decision if isinstance(decision, (int, float)) else delay
+            sleep_for = delay if decision is True else decision
             if self.options.max_reconnect_delay is not None:
                 sleep_for = min(sleep_for, self.options.max_reconnect_delay)
                 delay = min(delay * 2, self.options.max_reconnect_delay)
@@ -382,6 +657,30 @@ class SMQClient:
                 raise TypeError("connector must return a socket.socket")
             return sock, b""
 
+        host, port, scheme, request = self._bootstrap_request()
+        raw = socket.create_connection((host, port), timeout=self.options.timeout)
+        if scheme == "https":
+            context = ssl.create_default_context()
+            sock = context.wrap_socket(raw, server_hostname=host)
+        else:
+            sock = raw
+        sock.settimeout(self.options.timeout)
+        sock.sendall(request)
+
+        header_bytes = bytearray()
+        while b"\r\n\r\n" not in header_bytes:
+            chunk = sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("HTTP bootstrap closed before response")
+            header_bytes.extend(chunk)
+            if len(header_bytes) > 65536:
+                raise ConnectionError("HTTP bootstrap response too large")
+        head, initial = bytes(header_bytes).split(b"\r\n\r\n", 1)
+        self._check_bootstrap_response(head)
+        return sock, initial
+
+    def _bootstrap_request(self) -> Tuple[str, int, str, bytes]:
+        """Return host, port, scheme, and the HTTP bootstrap request for the broker URL."""
         parsed = urlparse(self.url_or_connector)
         scheme = parsed.scheme.lower()
         if scheme not in ("http", "https"):
@@ -395,14 +694,6 @@ class SMQClient:
         if parsed.query:
             path += "?" + parsed.query
 
-        raw = socket.create_connection((host, port), timeout=self.options.timeout)
-        if scheme == "https":
-            context = ssl.create_default_context()
-            sock = context.wrap_socket(raw, server_hostname=host)
-        else:
-            sock = raw
-        sock.settimeout(self.options.timeout)
-
         headers = {
             "Host": f"{host}:{port}" if parsed.port else host,
             "User-Agent": "smqclient.py",
@@ -412,25 +703,25 @@ class SMQClient:
         }
         headers.update(self.options.headers)
         request = [f"GET {path} HTTP/1.1", *(f"{k}: {v}" for k, v in headers.items()), "", ""]
-        sock.sendall("\r\n".join(request).encode("ascii"))
+        return host, port, scheme, "\r\n".join(request).encode("ascii")
 
-        header_bytes = bytearray()
-        while b"\r\n\r\n" not in header_bytes:
-            chunk = sock.recv(4096)
-            if not chunk:
-                raise ConnectionError("HTTP bootstrap closed before response")
-            header_bytes.extend(chunk)
-            if len(header_bytes) > 65536:
-                raise ConnectionError("HTTP bootstrap response too large")
-        head, initial = bytes(header_bytes).split(b"\r\n\r\n", 1)
+    @staticmethod
+    def _check_bootstrap_response(head: bytes) -> None:
         status_line = head.split(b"\r\n", 1)[0].decode("iso-8859-1", "replace")
         parts = status_line.split()
         if len(parts) < 2 or parts[1] != "200":
             raise ConnectionError(f"HTTP bootstrap failed: {status_line}")
-        return sock, initial
 
     def _handshake(self) -> Tuple[int, str]:
         msg_type, body = self._recv_packet(timeout=self.options.timeout)
+        rnd, ipaddr = self._parse_init(msg_type, body)
+        self._send_packet(MSG_CONNECT, self._connect_body(rnd, ipaddr))
+        msg_type, body = self._recv_packet(timeout=self.options.timeout)
+        self._accept_connack(msg_type, body)
+        return rnd, ipaddr
+
+    @staticmethod
+    def _parse_init(msg_type: int, body: bytes) -> Tuple[int, str]:
         if msg_type != MSG_INIT or len(body) < 5:
             raise SMQProtocolError("expected Init packet")
         version = body[0]
@@ -438,7 +729,9 @@ class SMQClient:
             raise SMQProtocolError(f"unsupported SMQ version {version}")
         rnd = struct.unpack(">I", body[1:5])[0]
         ipaddr = body[5:].decode("utf-8", "replace")
+        return rnd, ipaddr
 
+    def _connect_body(self, rnd: int, ipaddr: str) -> bytes:
         uid = self._uid_bytes(ipaddr)
         credentials = self._payload_to_bytes(self.onauth(rnd, ipaddr)) if self.onauth else b""
         info = self._payload_to_bytes(self.options.info or b"")
@@ -446,10 +739,9 @@ class SMQClient:
             raise ValueError("SMQ UID is limited to 255 bytes")
         if len(credentials) > 255:
             raise ValueError("SMQ credentials are limited to 255 bytes")
-        connect_body = b"".join((b"\x01", bytes([len(uid)]), uid, bytes([len(credentials)]), credentials, info))
-        self._send_packet(MSG_CONNECT, connect_body)
+        return b"".join((b"\x01", bytes([len(uid)]), uid, bytes([len(credentials)]), credentials, info))
 
-        msg_type, body = self._recv_packet(timeout=self.options.timeout)
+    def _accept_connack(self, msg_type: int, body: bytes) -> None:
         if msg_type != MSG_CONNACK or len(body) < 5:
             raise SMQProtocolError("expected Connack packet")
         status = body[0]
@@ -461,7 +753,6 @@ class SMQClient:
             self.etid = etid
             self.topic_name_to_tid["self"] = etid
             self.tid_to_topic_name[etid] = "self"
-        return rnd, ipaddr
 
     def _receive_loop(self) -> str:
         last_received = time.monotonic()
@@ -484,69 +775,130 @@ class SMQClient:
 
             last_received = time.monotonic()
             ping_sent_at = None
-            if msg_type == MSG_SUBACK:
-                self._handle_topic_ack(body, self.pending_subscribe_acks, subscribed=True)
-            elif msg_type == MSG_CREATEACK:
-                self._handle_topic_ack(body, self.pending_topic_acks, subscribed=False)
-            elif msg_type == MSG_CREATESUBACK:
-                self._handle_subtopic_ack(body)
-            elif msg_type == MSG_PUBLISH:
-                self._handle_publish(body)
-            elif msg_type == MSG_PING:
-                self._send_packet(MSG_PONG, b"")
-            elif msg_type == MSG_PONG:
-                pass
-            elif msg_type == MSG_CHANGE:
-                self._handle_change(body)
-            elif msg_type == MSG_DISCONNECT:
-                return body.decode("utf-8", "replace") or "disconnect"
-            else:
-                return f"unexpected packet type {msg_type}"
+            reason = self._dispatch_packet(msg_type, body)
+            if reason is not None:
+                return reason
         return "closed"
 
-    def _recv_packet(self, timeout: Optional[float]) -> Tuple[int, bytes]:
+    def _dispatch_packet(self, msg_type: int, body: bytes) -> Optional[str]:
+        """Handle one packet received after the handshake. Returns a close reason or None."""
+        if msg_type == MSG_SUBACK:
+            self._handle_topic_ack(body, self.pending_subscribe_acks, subscribed=True)
+        elif msg_type == MSG_CREATEACK:
+            self._handle_topic_ack(body, self.pending_topic_acks, subscribed=False)
+        elif msg_type == MSG_CREATESUBACK:
+            self._handle_subtopic_ack(body)
+        elif msg_type == MSG_PUBLISH:
+            self._handle_publish(body)
+        elif msg_type == MSG_PING:
+            self._send_packet(MSG_PONG, b"")
+        elif msg_type == MSG_PONG:
+            pass
+        elif msg_type == MSG_CHANGE:
+            self._handle_change(body)
+        elif msg_type == MSG_DISCONNECT:
+            return body.decode("utf-8", "replace") or "disconnect"
+        else:
+            return f"unexpected packet type {msg_type}"
+        return None
+
+    def _recv_packet(self, timeout: Optional[float]) -> Tuple[int, BytesLike]:
         sock = self._sock
         if sock is None:
             raise ConnectionError("not connected")
+        frames = self._frames
+        next_packet = frames.next_view if self.options.zerocopy else frames.next
         previous_timeout = sock.gettimeout()
         sock.settimeout(timeout)
         try:
-            while len(self._recv_buffer) < 2:
-                chunk = sock.recv(4096)
-                if not chunk:
+            packet = next_packet()
+            while packet is None:
+                size = sock.recv_into(frames.writable())
+                if not size:
                     raise ConnectionError("socket closed")
-                self._recv_buffer.extend(chunk)
-            length = struct.unpack(">H", self._recv_buffer[:2])[0]
-            if length < 3:
-                raise SMQProtocolError("invalid SMQ packet length")
-            while len(self._recv_buffer) < length:
-                chunk = sock.recv(4096)
-                if not chunk:
-                    raise ConnectionError("socket closed")
-                self._recv_buffer.extend(chunk)
-            packet = bytes(self._recv_buffer[:length])
-            del self._recv_buffer[:length]
+                frames.commit(size)
+                packet = next_packet()
         except socket.timeout as exc:
             raise TimeoutError() from exc
+        except ValueError as exc:
+            raise SMQProtocolError(str(exc)) from exc
         finally:
             sock.settimeout(previous_timeout)
-        return packet[2], packet[3:]
+        if packet[0] != MSG_PUBLISH and isinstance(packet[1], memoryview):
+            return packet[0], bytes(packet[1])
+        return packet
 
     def _send_packet(self, msg_type: int, body: bytes) -> bool:
-        packet = struct.pack(">HB", len(body) + 3, msg_type) + body
-        if len(packet) > 0xFFFF:
-            raise ValueError("SMQ packet too large")
+        return self._send_bytes(_encode_packet(msg_type, body))
+
+    def _send_bytes(self, packet: bytes, flush: bool = True) -> bool:
+        return self._send_buffers([packet], flush)
+
+    def _send_buffers(self, packets: List[BytesLike], flush: bool = True) -> bool:
+        """Send packets, or with flush False, queue them for the coalescing window.
+
+        Queued packets are sent ahead of the next flushed packet, so control
+        packets and ``disconnect()`` never overtake a publish.
+        """
         sock = self._sock
         if sock is None:
             return False
         try:
             with self._send_lock:
-                sock.sendall(packet)
+                out = self._out
+                if out or not flush:
+                    if not out:
+                        self._out_since = time.monotonic()
+                        self._send_ready.notify()
+                    out.extend(packets)
+                    self._out_size += sum(map(len, packets))
+                    if not flush and self._out_size < self.options.coalesce_bytes:
+                        return True
+                    packets, self._out, self._out_size = out, [], 0
+                if packets:
+                    self._sendmsg(sock, packets)
             return True
         except OSError:
             self._close_socket()
             return False
 
+    @staticmethod
+    def _sendmsg(sock: socket.socket, packets: List[BytesLike]) -> None:
+        """Send all packets, using one sendmsg() call per _IOV_MAX buffers."""
+        if len(packets) == 1 or isinstance(sock, ssl.SSLSocket) or not hasattr(sock, "sendmsg"):
+            sock.sendall(packets[0] if len(packets) == 1 else b"".join(packets))
+            return
+        first = 0
+        while first < len(packets):
+            sent = sock.sendmsg(packets[first : first + _IOV_MAX])
+            while sent and first < len(packets):
+                size = len(packets[first])
+                if sent < size:
+                    packets[first] = memoryview(packets[first])[sent:]
+                    break
+                sent -= size
+                first += 1
+
+    def _flush_loop(self) -> None:
+        """Send packets queued by publish() when the coalescing window expires."""
+        with self._send_lock:
+            while not self._stop.is_set():
+                if not self._out:
+                    self._send_ready.wait(0.5)
+                    continue
+                remaining = self._out_since + self.options.coalesce - time.monotonic()
+                if remaining > 0:
+                    self._send_ready.wait(remaining)
+                    continue
+                packets, self._out, self._out_size = self._out, [], 0
+                sock = self._sock
+                if sock is None:
+                    continue
+                try:
+                    self._sendmsg(sock, packets)
+                except OSError:
+                    self._close_socket()
+
     def _subscribe_topic(self, topic: str, onack: Callable[[bool, str, int], Any]) -> bool:
         self._validate_name(topic, "topic")
         with self._lock:
@@ -566,8 +918,8 @@ class SMQClient:
         with self._lock:
             if not self._is_connected_locked() or self.etid is None:
                 return False
-            body = struct.pack(">III", tid, self.etid, subtid) + payload
-        return self._send_packet(MSG_PUBLISH, body)
+            packet = _encode_publish(tid, self.etid, subtid, payload)
+        return self._send_bytes(packet, self.options.coalesce <= 0)
 
     def _resolve_subtopic_then(self, subtopic_or_subtid: Optional[Topic], callback: Callable[[int], bool]) -> bool:
         if subtopic_or_subtid is None:
@@ -614,28 +966,25 @@ class SMQClient:
             self._call(callback, accepted, subtopic, subtid)
 
     def _handle_publish(self, body: bytes) -> None:
-        if len(body) < 12:
-            raise SMQProtocolError("short publish")
-        tid, ptid, subtid = struct.unpack(">III", body[:12])
-        payload = body[12:]
-        with self._lock:
-            callbacks = self.message_callbacks.get(tid)
-            callback: Optional[Callback] = None
-            datatype: Optional[str] = None
-            if callbacks:
-                callback = callbacks.subtopics.get(subtid)
-                datatype = callbacks.datatypes.get(subtid)
-                if callback is None:
-                    callback = callbacks.catch_all
-                    datatype = callbacks.datatypes.get(None)
-            callback = callback or self.onmsg
+        try:
+            with self._lock:
+                entry, payload, ptid, tid, subtid = self._callback_table.dispatch(body)
+        except ValueError as exc:
+            raise SMQProtocolError(str(exc)) from exc
+        callback: Optional[Callback] = None
+        datatype: Optional[str] = None
+        if entry is not None:
+            callback, datatype, copy = entry
+            if copy and isinstance(payload, memoryview):
+                payload = bytes(payload)
+        callback = callback or self.onmsg
 
         data: Any = payload
         if datatype == "text":
-            data = payload.decode("utf-8")
-        elif datatype == "json":
+            data = str(payload, "utf-8")
+        elif datatype == "json" or datatype == "ndarray":
             try:
-                data = json.loads(payload.decode("utf-8"))
+                data = json.loads(str(payload, "utf-8")) if datatype == "json" else _decode_ndarray(payload)
             except Exception:
                 if callback is not self.onmsg and self.onmsg:
                     callback = self.onmsg
@@ -687,9 +1036,13 @@ class SMQClient:
             self.pending_subscribe_acks.clear()
             self.pending_subtopic_acks.clear()
             self.message_callbacks.clear()
+            self._callback_table.clear()
             self.observe_callbacks.clear()
             self._subscribed_tids.clear()
-            self._recv_buffer.clear()
+            self._frames.clear()
+        with self._send_lock:
+            self._out.clear()
+            self._out_size = 0
 
     def _close_socket(self) -> None:
         sock = self._sock
@@ -0,0 +1,410 @@
+"""asyncio transport for the SMQ Python client.
+
+``AsyncSMQClient`` has the same API and callback semantics as ``SMQClient``,
+but runs on an asyncio event loop instead of a background thread per client.
+Each connection is an ``asyncio.BufferedProtocol``: received data is parsed
+into SMQ packets as it arrives, and ping/pong supervision uses loop timers
+instead of socket timeouts. Hundreds or thousands of sessions can share one
+event loop and one thread.
+
+All methods and callbacks run on the event loop thread. Methods are not
+thread-safe; use ``loop.call_soon_threadsafe`` to call them from another
+thread.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import socket
+import ssl
+import time
+from collections import deque
+from typing import Any, Callable, Deque, List, Mapping, Optional, Tuple, Union
+
+from smqclient import (
+    BytesLike,
+    MSG_CONNECT,
+    MSG_DISCONNECT,
+    MSG_PING,
+    MSG_PUBLISH,
+    SMQClient,
+    SMQProtocolError,
+    _FrameReader,
+)
+
+
+class _NoLock:
+    """Stand-in for the threaded client's locks: all access is on the loop thread."""
+
+    def __enter__(self) -> None:
+        return None
+
+    def __exit__(self, *_exc: Any) -> None:
+        return None
+
+
+_NO_LOCK = _NoLock()
+
+
+class _SMQProtocol(asyncio.BufferedProtocol):
+    """Parse the HTTP bootstrap response and SMQ packets for one connection.
+
+    After the bootstrap response, the transport receives straight into the
+    ``FrameReader`` buffer (``get_buffer``/``buffer_updated``), the asyncio
+    equivalent of ``recv_into``.
+    """
+
+    def __init__(self, client: "AsyncSMQClient", bootstrap: bool):
+        loop = asyncio.get_running_loop()
+        self.client = client
+        self.transport: Optional[asyncio.Transport] = None
+        self.buffer = bytearray()  # HTTP bootstrap response
+        self.chunk = memoryview(bytearray(4096)) if bootstrap else None
+        self.frames = _FrameReader()
+        self.bootstrap = bootstrap
+        self.ready = loop.create_future()  # HTTP bootstrap response received
+        self.closed = loop.create_future()  # close reason
+        self.handshake: Optional[Deque[Tuple[int, bytes]]] = deque()
+        self.waiter: Optional[asyncio.Future] = None
+        self.paused = False
+        self.drain_waiters: list = []
+        if not bootstrap:
+            self.ready.set_result(None)
+
+    def connection_made(self, transport: asyncio.BaseTransport) -> None:
+        self.transport = transport  # type: ignore[assignment]
+
+    def get_buffer(self, sizehint: int) -> memoryview:
+        if self.bootstrap:
+            assert self.chunk is not None
+            return self.chunk
+        return self.frames.writable()
+
+    def buffer_updated(self, nbytes: int) -> None:
+        if not self.bootstrap:
+            self.frames.commit(nbytes)
+            self.dispatch()
+            return
+        assert self.chunk is not None
+        buf = self.buffer
+        buf += self.chunk[:nbytes]
+        end = buf.find(b"\r\n\r\n")
+        if end < 0:
+            if len(buf) > 65536:
+                self.fail("HTTP bootstrap response too large")
+            return
+        self.bootstrap = False
+        self.chunk = None
+        head = bytes(buf[:end])
+        self.frames.feed(memoryview(buf)[end + 4 :])
+        self.buffer = bytearray()
+        try:
+            SMQClient._check_bootstrap_response(head)
+        except ConnectionError as exc:
+            self.fail(str(exc))
+            return
+        self.ready.set_result(None)
+        self.dispatch()
+
+    def dispatch(self) -> None:
+        """Deliver the buffered packets. Publish bodies are views with ``zerocopy``."""
+        frames = self.frames
+        next_packet = frames.next_view if self.client.options.zerocopy else frames.next
+        try:
+            packet = next_packet()
+            while packet is not None:
+                msg_type, body = packet
+                if msg_type != MSG_PUBLISH and isinstance(body, memoryview):
+                    body = bytes(body)
+                if not self.packet(msg_type, body):
+                    return
+                packet = next_packet()
+        except ValueError as exc:
+            self.fail(str(exc))
+
+    def packet(self, msg_type: int, body: BytesLike) -> bool:
+        """Deliver one packet. Returns False if the connection was closed."""
+        if self.handshake is not None:
+            self.handshake.append((msg_type, bytes(body)))
+            if self.waiter is not None and not self.waiter.done():
+                self.waiter.set_result(None)
+            return True
+        client = self.client
+        client._last_received = time.monotonic()
+        client._ping_sent_at = None
+        try:
+            reason = client._dispatch_packet(msg_type, body)
+        except SMQProtocolError as exc:
+            reason = str(exc) or exc.__class__.__name__
+        if reason is not None:
+            self.fail(reason)
+            return False
+        return not self.closed.done()
+
+    async def recv_packet(self) -> Tuple[int, bytes]:
+        """Wait for a handshake packet."""
+        assert self.handshake is not None
+        while not self.handshake:
+            if self.closed.done():
+                raise ConnectionError(self.closed.result())
+            self.waiter = asyncio.get_running_loop().create_future()
+            await asyncio.wait((self.waiter, self.closed), return_when=asyncio.FIRST_COMPLETED)
+            self.waiter = None
+        return self.handshake.popleft()
+
+    def end_handshake(self) -> None:
+        """Dispatch packets received with the Connack and dispatch directly from now on."""
+        queued, self.handshake = self.handshake, None
+        while queued and not self.closed.done():
+            self.packet(*queued.popleft())
+
+    def fail(self, reason: str) -> None:
+        if not self.closed.done():
+            self.closed.set_result(reason)
+        if self.transport is not None:
+            self.transport.abort()
+
+    def connection_lost(self, exc: Optional[Exception]) -> None:
+        if not self.closed.done():
+            if exc:
+                self.closed.set_result(str(exc) or exc.__class__.__name__)
+            else:
+                self.closed.set_result("HTTP bootstrap closed before response" if self.bootstrap else "socket closed")
+        if not self.ready.done():
+            self.ready.set_exception(ConnectionError(self.closed.result()))
+        self.paused = False
+        self.wake_writers()
+
+    def pause_writing(self) -> None:
+        self.paused = True
+
+    def resume_writing(self) -> None:
+        self.paused = False
+        self.wake_writers()
+
+    def wake_writers(self) -> None:
+        waiters, self.drain_waiters = self.drain_waiters, []
+        for waiter in waiters:
+            if not waiter.done():
+                waiter.set_result(None)
+
+
+class AsyncSMQClient(SMQClient):
+    """asyncio SMQ client.
+
+    Create the client from a coroutine running on the event loop that should
+    own the connection:
+
+        smq = AsyncSMQClient.create(url, options)
+        await smq.wait_connected(5)
+
+    ``url_or_connector`` may also be a callable returning a connected
+    ``socket.socket`` or an awaitable producing one.
+    """
+
+    def __init__(self, url_or_connector: Union[str, Callable[..., Any]], options: Optional[Mapping[str, Any]] = None):
+        super().__init__(url_or_connector, options)
+        self._lock = _NO_LOCK  # type: ignore[assignment]
+        self._send_lock = _NO_LOCK  # type: ignore[assignment]
+        self._stop = asyncio.Event()  # type: ignore[assignment]
+        self._connected = asyncio.Event()  # type: ignore[assignment]
+        self._task: Optional[asyncio.Task] = None
+        self._protocol: Optional[_SMQProtocol] = None
+        self._timer: Optional[asyncio.TimerHandle] = None
+        self._flush_timer: Optional[asyncio.TimerHandle] = None
+        self._last_received = 0.0
+        self._ping_sent_at: Optional[float] = None
+
+    def start(self) -> None:
+        if self._task and not self._task.done():
+            return
+        self._stop.clear()
+        self._manual_disconnect = False
+        self._task = asyncio.get_running_loop().create_task(self._connect_loop())
+
+    async def wait_connected(self, timeout: Optional[float] = None) -> bool:  # type: ignore[override]
+        try:
+            await asyncio.wait_for(self._connected.wait(), timeout)
+        except asyncio.TimeoutError:
+            return False
+        return True
+
+    async def drain(self) -> None:
+        """Wait until the transport's write buffer is below its high-water mark.
+
+        ``publish()`` never blocks; a producer sending faster than the network
+        accepts should await ``drain()`` to bound the memory used per session.
+        """
+        protocol = self._protocol
+        if protocol is None or not protocol.paused:
+            return
+        waiter = asyncio.get_running_loop().create_future()
+        protocol.drain_waiters.append(waiter)
+        await waiter
+
+    def disconnect(self) -> None:
+        self._manual_disconnect = True
+        self._stop.set()
+        protocol = self._protocol
+        if self._connected.is_set():
+            self._send_packet(MSG_DISCONNECT, b"")
+        if protocol is not None:
+            if not protocol.closed.done():
+                protocol.closed.set_result("disconnect")
+            if protocol.transport is not None:
+                protocol.transport.close()  # Flushes the Disconnect packet first
+        self._connected.clear()
+
+    close = disconnect
+
+    async def wait_closed(self) -> None:
+        """Wait until the connection task has ended after ``disconnect()``."""
+        if self._task is not None:
+            await asyncio.gather(self._task, return_exceptions=True)
+
+    async def _connect_loop(self) -> None:  # type: ignore[override]
+        delay = self.options.reconnect_delay
+        while not self._stop.is_set():
+            reason = "closed"
+            can_reconnect = self.options.reconnect and not self._manual_disconnect
+            try:
+                self._reset_connection_state()
+                rnd, ipaddr = await asyncio.wait_for(self._open(), self.options.timeout)
+                self._connected.set()
+                delay = self.options.reconnect_delay
+                self._start_keepalive()
+                self._announce_connected(rnd, ipaddr)
+                assert self._protocol is not None
+                self._protocol.end_handshake()
+                reason = await self._protocol.closed
+                can_reconnect = self.options.reconnect and not self._manual_disconnect and reason != "disconnect"
+            except asyncio.CancelledError:
+                self._close_socket()
+                raise
+            except Exception as exc:  # callbacks must still receive protocol/connect failures
+                reason = str(exc) or exc.__class__.__name__
+                can_reconnect = self.options.reconnect and not self._manual_disconnect
+            finally:
+                self._connected.clear()
+                self.etid = None
+                self._stop_keepalive()
+                if self._manual_disconnect:
+                    self._protocol = None  # disconnect() closes the transport after flushing
+                else:
+                    self._close_socket()
+
+            if self._stop.is_set() or self._manual_disconnect:
+                break
+            decision = self._handle_close(reason, can_reconnect)
+            if not decision:
+                break
+            sleep_for = delay if decision is True else decision
+            if self.options.max_reconnect_delay is not None:
+                sleep_for = min(sleep_for, self.options.max_reconnect_delay)
+                delay = min(delay * 2, self.options.max_reconnect_delay)
+            else:
+                delay = max(delay, self.options.reconnect_delay)
+            try:
+                await asyncio.wait_for(self._stop.wait(), max(0.0, float(sleep_for)))
+            except asyncio.TimeoutError:
+                pass
+
+    async def _open(self) -> Tuple[int, str]:
+        """Connect, send the HTTP bootstrap request, and run the SMQ handshake."""
+        loop = asyncio.get_running_loop()
+        if callable(self.url_or_connector):
+            sock = self.url_or_connector(self.options)
+            if asyncio.iscoroutine(sock) or isinstance(sock, asyncio.Future):
+                sock = await sock
+            if not isinstance(sock, socket.socket):
+                raise TypeError("connector must return a socket.socket")
+            sock.setblocking(False)
+            _, protocol = await loop.create_connection(lambda: _SMQProtocol(self, False), sock=sock)
+        else:
+            host, port, scheme, request = self._bootstrap_request()
+            context = ssl.create_default_context() if scheme == "https" else None
+            _, protocol = await loop.create_connection(
+                lambda: _SMQProtocol(self, True), host, port, ssl=context, server_hostname=host if context else None
+            )
+            protocol.transport.write(request)
+        self._protocol = protocol
+        await protocol.ready
+        rnd, ipaddr = self._parse_init(*await protocol.recv_packet())
+        self._send_packet(MSG_CONNECT, self._connect_body(rnd, ipaddr))
+        self._accept_connack(*await protocol.recv_packet())
+        return rnd, ipaddr
+
+    def _send_buffers(self, packets: List[BytesLike], flush: bool = True) -> bool:
+        """Write packets, or with flush False, queue them for the coalescing window."""
+        protocol = self._protocol
+        if protocol is None or protocol.transport is None or protocol.transport.is_closing():
+            return False
+        out = self._out
+        if out or not flush:
+            out.extend(packets)
+            self._out_size += sum(map(len, packets))
+            if not flush and self._out_size < self.options.coalesce_bytes:
+                if self._flush_timer is None:
+                    self._flush_timer = asyncio.get_running_loop().call_later(self.options.coalesce, self._flush_timeout)
+                return True
+            packets, self._out, self._out_size = out, [], 0
+        if self._flush_timer is not None:
+            self._flush_timer.cancel()
+            self._flush_timer = None
+        if len(packets) == 1:
+            protocol.transport.write(packets[0])
+        elif packets:
+            protocol.transport.writelines(packets)
+        return True
+
+    def _flush_timeout(self) -> None:
+        self._flush_timer = None
+        self.flush()
+
+    def _start_keepalive(self) -> None:
+        self._last_received = time.monotonic()
+        self._ping_sent_at = None
+        self._timer = asyncio.get_running_loop().call_later(self.options.ping, self._keepalive)
+
+    def _stop_keepalive(self) -> None:
+        if self._timer is not None:
+            self._timer.cancel()
+            self._timer = None
+
+    def _keepalive(self) -> None:
+        """Timer callback replacing the threaded client's 0.5 s receive poll.
+
+        The timer is not rescheduled for each received packet; it fires at the
+        earliest time a Ping or a missing Pong can be due and re-arms itself.
+        """
+        protocol = self._protocol
+        if protocol is None or protocol.closed.done():
+            return
+        now = time.monotonic()
+        if self._ping_sent_at is not None:
+            if now - self._ping_sent_at > self.options.pong:
+                protocol.fail("missing pong")
+                return
+            due = self._ping_sent_at + self.options.pong
+        elif now - self._last_received >= self.options.ping:
+            if not self._send_packet(MSG_PING, b""):
+                protocol.fail("send failed")
+                return
+            self._ping_sent_at = now
+            due = now + min(self.options.pong, self.options.ping)
+        else:
+            due = self._last_received + self.options.ping
+        self._timer = asyncio.get_running_loop().call_later(max(0.0, due - now) + 0.001, self._keepalive)
+
+    def _close_socket(self) -> None:
+        protocol = self._protocol
+        self._protocol = None
+        if protocol is not None and protocol.transport is not None:
+            protocol.transport.abort()
+
+    def _is_connected_locked(self) -> bool:
+        protocol = self._protocol
+        return self._connected.is_set() and protocol is not None and not protocol.closed.done()
+
+
+__all__ = ["AsyncSMQClient"]